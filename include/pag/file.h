@@ -2253,6 +2253,8 @@ class PAG_API BitmapComposition : public Composition {
   RTTR_ENABLE(Composition)
 };
 
+class VideoFrameLoader;
+
 class PAG_API VideoFrame {
  public:
   ~VideoFrame();
@@ -2302,10 +2304,22 @@ class PAG_API VideoSequence : public Sequence {
 
   bool verify() const override;
 
+  /**
+   * Makes sure the fileBytes of all video frames are available. If the sequence was decoded lazily,
+   * the frame bytes are copied from the source file on the first call. It must be called before
+   * accessing the fileBytes of video frames, and it is safe to call it from multiple threads.
+   */
+  void loadFrames() const;
+
   int32_t getVideoWidth() const;
 
   int32_t getVideoHeight() const;
 
+ private:
+  std::shared_ptr<VideoFrameLoader> frameLoader = nullptr;
+
+  friend class VideoFrameLoader;
+
   RTTR_ENABLE(Sequence)
 };
 
@@ -2395,9 +2409,22 @@ class PAG_API File {
                                     const std::string& password = "");
   /**
    *  Load a pag file from path, return null if the file does not exist or the data is not a pag
-   * file.
+   * file. The embedded resources reference the loaded file bytes instead of copying them, and the
+   * video frames are only copied out when their sequence is first used.
    */
   static std::shared_ptr<File> Load(const std::string& filePath, const std::string& password = "");
+  /**
+   * Load a pag file from path by mapping it into memory. Embedded resources such as image bytes
+   * and bitmap frames reference the mapping directly instead of being copied, which saves memory
+   * and loading time for large files. The file stays mapped until the returned File and all of
+   * its resources are released. Only use it for files that are not modified during that time:
+   * on POSIX systems, reading a mapped file that is truncated by others crashes the process with
+   * SIGBUS, and on Windows the mapped file can not be replaced or deleted. Falls back to Load()
+   * if the platform does not support memory mapping. Returns null if the file does not exist or
+   * the data is not a pag file.
+   */
+  static std::shared_ptr<File> LoadMapped(const std::string& filePath,
+                                          const std::string& password = "");
 
   ~File();
 
@@ -2558,6 +2585,15 @@ class PAG_API Codec {
   static std::shared_ptr<File> Decode(const void* bytes, uint32_t byteLength,
                                       const std::string& path);
 
+  /**
+   * Decode a pag file from the specified byte data without copying the embedded resources, such as
+   * image bytes and bitmap frames. These resources reference the specified bytes directly and keep
+   * the bytesOwner alive until they are released, return null if the bytes is empty or it's not a
+   * valid pag file.
+   */
+  static std::shared_ptr<File> Decode(const void* bytes, uint32_t byteLength,
+                                      const std::string& path, std::shared_ptr<void> bytesOwner);
+
   /**
    * Encode a pag file to byte data, return null if the file is null.
    */
@@ -475,7 +475,7 @@ class PAG_API PAGLayer : public Content {
   virtual Frame stretchedContentFrame() const;
   virtual int64_t durationInternal() const;
   virtual int64_t startTimeInternal() const;
-  virtual Content* getContent();
+  virtual std::shared_ptr<Content> getContent();
   virtual void invalidateCacheScale();
   virtual void onAddToStage(PAGStage* pagStage);
   virtual void onRemoveFromStage();
@@ -558,12 +558,12 @@ class PAG_API PAGSolidLayer : public PAGLayer {
   void setSolidColor(const Color& value);
 
  protected:
-  Content* getContent() override;
+  std::shared_ptr<Content> getContent() override;
   bool contentModified() const override;
 
  private:
   SolidLayer* emptySolidLayer = nullptr;
-  Content* replacement = nullptr;
+  std::shared_ptr<Content> replacement = nullptr;
   Color _solidColor = White;
 };
 
@@ -641,7 +641,7 @@ class PAG_API PAGTextLayer : public PAGLayer {
  protected:
   void replaceTextInternal(std::shared_ptr<TextDocument> textData);
   void setMatrixInternal(const Matrix& matrix) override;
-  Content* getContent() override;
+  std::shared_ptr<Content> getContent() override;
   bool contentModified() const override;
 
  private:
@@ -783,7 +783,7 @@ class PAG_API PAGImageLayer : public PAGLayer {
   int64_t getCurrentContentTime(int64_t layerTime);
   Property<float>* getContentTimeRemap();
   bool contentVisible();
-  Content* getContent() override;
+  std::shared_ptr<Content> getContent() override;
   bool contentModified() const override;
   bool cacheFilters() const override;
   void onRemoveFromRootFile() override;
@@ -793,7 +793,7 @@ class PAG_API PAGImageLayer : public PAGLayer {
 
  private:
   ImageLayer* emptyImageLayer = nullptr;
-  ImageReplacement* replacement = nullptr;
+  std::shared_ptr<ImageReplacement> replacement = nullptr;
   std::unique_ptr<Property<float>> contentTimeRemap;
 
   PAGImageLayer(int width, int height, int64_t duration);
@@ -1039,6 +1039,27 @@ class PAG_API PAGFile : public PAGComposition {
    */
   static std::shared_ptr<PAGFile> Load(const std::string& filePath,
                                        const std::string& password = "");
+  /**
+   * Load a pag file from path by mapping it into memory instead of copying its embedded
+   * resources. The file must not be modified, replaced or deleted until the returned PAGFile and
+   * all of its resources are released, see File::LoadMapped() for details. Returns null if the
+   * file does not exist or the data is not a pag file.
+   */
+  static std::shared_ptr<PAGFile> LoadMapped(const std::string& filePath,
+                                             const std::string& password = "");
+
+  /**
+   * Returns the maximum number of frames for which each layer keeps its computed rendering data,
+   * such as transforms, masks and contents. The default value is 0, which means unlimited.
+   */
+  static size_t MaxFrameCacheCount();
+
+  /**
+   * Sets the maximum number of frames for which each layer keeps its computed rendering data. The
+   * least recently used frames are evicted once the limit is exceeded, which bounds the memory
+   * growth of long compositions at the cost of recomputing the evicted frames when revisited.
+   */
+  static void SetMaxFrameCacheCount(size_t count);
 
   PAGFile(std::shared_ptr<File> file, PreComposeLayer* layer);
 
@@ -1264,9 +1285,12 @@ class PAG_API PAGSurface {
   std::shared_ptr<Drawable> drawable = nullptr;
   bool externalContext = false;
   GLRestorer* glRestorer = nullptr;
+  std::shared_ptr<Graphic> lastGraphic = nullptr;
+  bool lastFrameCleared = false;
+  Rect dirtyRect = {};
 
   bool draw(RenderCache* cache, std::shared_ptr<Graphic> graphic, BackendSemaphore* signalSemaphore,
-            bool autoClear = true);
+            bool autoClear = true, bool partialRedraw = false);
   bool prepare(RenderCache* cache, std::shared_ptr<Graphic> graphic);
   bool hitTest(RenderCache* cache, std::shared_ptr<Graphic> graphic, float x, float y);
   tgfx::Context* lockContext();
@@ -1350,6 +1374,47 @@ class PAG_API PAGPlayer {
    */
   void setUseDiskCache(bool value);
 
+  /**
+   * Returns the number of frames decoded ahead of playback for each image sequence, such as the
+   * video compositions. A value greater than 1 allows a background task to decode the upcoming
+   * frames in advance, which avoids stutters caused by a single slow frame (e.g. a video keyframe)
+   * at the cost of more memory. The default value is 1.
+   */
+  int sequencePrefetchDepth();
+
+  /**
+   * Set the value of sequencePrefetchDepth property.
+   */
+  void setSequencePrefetchDepth(int value);
+
+  /**
+   * Returns the interval of frames at which the bitmap sequences keep a snapshot of the decoded
+   * frame, so that seeking to any frame decodes at most that many frames instead of going back to
+   * the previous keyframe. It speeds up scrubbing through long bitmap sequences at the cost of
+   * some memory, which is LZ4-compressed and limited for each sequence. The default value is 0,
+   * which disables the snapshots.
+   */
+  int sequenceCheckpointInterval();
+
+  /**
+   * Set the value of sequenceCheckpointInterval property.
+   */
+  void setSequenceCheckpointInterval(int value);
+
+  /**
+   * If set to true, the decoded images of the file assets and the replaced PAGImages are shared
+   * with all the other PAGPlayers that also enable it, which greatly reduces the memory usage when
+   * many players show the same content at the same time, such as the stickers in a list view. The
+   * images no longer used by any player are kept in memory within the limit set by
+   * PAGAssetCache::SetMaxMemorySize(). The default value is false.
+   */
+  bool useSharedAssetCache();
+
+  /**
+   * Set the value of useSharedAssetCache property.
+   */
+  void setUseSharedAssetCache(bool value);
+
   /**
    * This value defines the scale factor for internal graphics caches, ranges from 0.0 to 1.0. The
    * scale factors less than 1.0 may result in blurred output, but it can reduce the usage of
@@ -1440,6 +1505,35 @@ class PAG_API PAGPlayer {
    */
   void setAutoClear(bool value);
 
+  /**
+   * If set to true, PAGPlayer compares each new frame with the last frame drawn to the PAGSurface,
+   * and only clears and redraws the regions that changed, which greatly reduces the GPU cost when
+   * only small parts of a large surface are animated. It only applies if autoClear is true, and the
+   * PAGSurface keeps its pixels between frames, such as the offscreen surfaces or the surfaces made
+   * from textures or hardware buffers, whose content must not be modified outside PAG. Otherwise,
+   * the whole surface is still redrawn. The default value is false.
+   */
+  bool partialRedrawEnabled();
+
+  /**
+   * Set the value of partialRedrawEnabled property.
+   */
+  void setPartialRedrawEnabled(bool value);
+
+  /**
+   * If set to true, PAGPlayer evaluates the layer contents of the next frame on a worker thread
+   * while the current frame is being drawn to the PAGSurface, so that the next flush() call only
+   * has to assemble the already prepared contents. It works best for the sequential playback, such
+   * as a PAGView or a PAGAnimator driven player, and costs an extra CPU core during each flush()
+   * call. The default value is false.
+   */
+  bool pipelinedRenderingEnabled();
+
+  /**
+   * Set the value of pipelinedRenderingEnabled property.
+   */
+  void setPipelinedRenderingEnabled(bool value);
+
   /**
    * Prepares the player for the next flush() call. It collects all CPU tasks from the current
    * progress of the composition and runs them asynchronously in parallel. It is usually used for
@@ -1493,6 +1587,14 @@ class PAG_API PAGPlayer {
    */
   Rect getBounds(std::shared_ptr<PAGLayer> pagLayer);
 
+  /**
+   * Returns the region of the PAGSurface in pixels that changed in the last flush() call, which can
+   * be used to present only the dirty region of the surface. It is the whole surface if
+   * partialRedrawEnabled is false or the last frame is not available, and it is empty if the last
+   * flush() call did not draw anything.
+   */
+  Rect getDirtyRect();
+
   /**
    * Returns an array of layers that lie under the specified point. The point is in the coordinate
    * space of the PAGSurface.
@@ -1546,6 +1648,7 @@ class PAG_API PAGPlayer {
   float _maxFrameRate = 60;
   PAGScaleMode _scaleMode = PAGScaleMode::LetterBox;
   bool _autoClear = true;
+  bool _partialRedrawEnabled = false;
 
   bool updateStageSize();
   void setSurfaceInternal(std::shared_ptr<PAGSurface> newSurface);
@@ -1579,6 +1682,16 @@ class PAG_API PAGDecoder {
   static std::shared_ptr<PAGDecoder> MakeFrom(std::shared_ptr<PAGComposition> composition,
                                               float maxFrameRate = 30.0f, float scale = 1.0f);
 
+  /**
+   * Creates a PAGDecoder with a PAGComposition, a frame rate limit, a scale factor for the decoded
+   * image size, and the number of workers used by readFrames() to render frames concurrently. Each
+   * worker renders its own copy of the composition, which is only possible if the composition is an
+   * unmodified PAGFile. Otherwise, readFrames() falls back to rendering frames one by one. Returns
+   * nullptr if the composition is nullptr.
+   */
+  static std::shared_ptr<PAGDecoder> MakeFrom(std::shared_ptr<PAGComposition> composition,
+                                              float maxFrameRate, float scale, int workerCount);
+
   ~PAGDecoder();
 
   /**
@@ -1629,6 +1742,22 @@ class PAG_API PAGDecoder {
    */
   bool readFrame(int index, HardwareBufferRef hardwareBuffer);
 
+  /**
+   * Reads pixels of the image frames in the range [startIndex, endIndex] and caches them to the
+   * disk. Frames that are not cached yet are split into disjoint ranges and rendered concurrently
+   * by the workers specified in MakeFrom(). The callback, if not null, is called on the worker
+   * threads with the index and pixels of each frame once it is ready, and the pixels are only valid
+   * during the call. Returns false if any of the frames failed to read. Note that the colorType,
+   * alphaType, and rowBytes must stay the same as other reading calls. This call blocks until all
+   * frames are ready, so avoid calling it from a task of the shared thread pool. If it is called
+   * from the callback of another readFrames() call, the frames are rendered on the calling thread
+   * only. The decoder stays locked until this call returns, so calling readFrame() or readFrames()
+   * of the same decoder from the callback fails and returns false.
+   */
+  bool readFrames(int startIndex, int endIndex, size_t rowBytes, ColorType colorType,
+                  AlphaType alphaType,
+                  std::function<void(int index, const void* pixels)> callback = nullptr);
+
  private:
   std::mutex locker = {};
   int _width = 0;
@@ -1636,6 +1765,7 @@ class PAG_API PAGDecoder {
   int _numFrames = 0;
   float _frameRate = 30.0f;
   float maxFrameRate = 30.0f;
+  int workerCount = 1;
   int lastReadIndex = -1;
   tgfx::ImageInfo* lastImageInfo = nullptr;
   uint32_t lastContentVersion = 0;
@@ -1656,15 +1786,23 @@ class PAG_API PAGDecoder {
              float frameRate, float maxFrameRate);
 
   bool readFrameInternal(int index, std::shared_ptr<BitmapBuffer> bitmap);
+  bool checkInCallback() const;
   bool renderFrame(std::shared_ptr<PAGComposition> composition, int index,
                    std::shared_ptr<BitmapBuffer> bitmap);
+  bool renderFrames(std::shared_ptr<CompositionReader> frameReader, const std::vector<int>& indices,
+                    const tgfx::ImageInfo& info,
+                    const std::function<void(int index, const void* pixels)>& callback);
+  void checkSequenceComplete(const std::shared_ptr<PAGComposition>& composition);
   bool checkSequenceFile(std::shared_ptr<PAGComposition> composition, const tgfx::ImageInfo& info);
   void checkCompositionChange(std::shared_ptr<PAGComposition> composition);
   std::string generateCacheKey(std::shared_ptr<PAGComposition> composition);
   std::shared_ptr<PAGComposition> getComposition();
   void setCacheKeyGeneratorFun(
       std::function<std::string(PAGDecoder*, std::shared_ptr<PAGComposition>)> fun);
+  bool prefetch(size_t rowBytes, ColorType colorType, AlphaType alphaType, int preloadFrames,
+                int priority);
   friend class DiskSequenceReader;
+  friend class PAGDiskCache;
 };
 
 /**
@@ -1689,6 +1827,132 @@ class PAG_API PAGDiskCache {
    * are closed.
    */
   static void RemoveAll();
+
+  /**
+   * Returns the compression mode used to store image frames in the disk cache. The default value is
+   * PAGCompressionMode::LZ4.
+   */
+  static PAGCompressionMode CompressionMode();
+
+  /**
+   * Sets the compression mode used to store image frames in the disk cache. Each cache file keeps
+   * the mode that was set when it was opened, so the new mode only applies to the cache files
+   * opened afterward, and the files already opened keep writing frames with their previous mode.
+   * The frames cached with any mode remain readable.
+   */
+  static void SetCompressionMode(PAGCompressionMode mode);
+
+  /**
+   * Returns the maximum memory in bytes used to hold image frames waiting to be written to the disk
+   * cache. The default value is 0, which means frames are written synchronously.
+   */
+  static size_t MaxWriteQueueSize();
+
+  /**
+   * Sets the maximum memory in bytes used to hold image frames waiting to be written to the disk
+   * cache. If the value is greater than 0, frames are copied and then compressed and written on a
+   * background thread, and new frames are dropped if the queue is full.
+   */
+  static void SetMaxWriteQueueSize(size_t size);
+
+  /**
+   * Returns the number of image frames currently waiting to be written to the disk cache.
+   */
+  static size_t WriteQueueDepth();
+
+  /**
+   * Returns the total number of image frames dropped because the write queue was full.
+   */
+  static size_t DroppedWriteCount();
+
+  /**
+   * Returns the memory limit in bytes of the in-memory frame cache, which is shared by all
+   * PAGDecoders and holds recently read frames in front of the disk cache. The default value is 0,
+   * which means the in-memory frame cache is disabled.
+   */
+  static size_t MaxMemorySize();
+
+  /**
+   * Sets the memory limit in bytes of the in-memory frame cache. Frames are stored decompressed and
+   * evicted in least recently used order once the limit is exceeded. Frames of a sequence are
+   * released from memory once no PAGDecoder uses the sequence.
+   */
+  static void SetMaxMemorySize(size_t size);
+
+  /**
+   * Returns the total size in bytes of the frames currently held by the in-memory frame cache.
+   */
+  static size_t MemoryUsage();
+
+  /**
+   * Asynchronously opens and validates the disk cache of the specified decoder on a background
+   * thread, so that the first readFrame() call after a scene transition doesn't pay for opening and
+   * indexing the cache file. If preloadFrames is greater than 0, the first preloadFrames frames
+   * that are already cached are also decompressed into the in-memory frame cache. They count
+   * against MaxMemorySize() and may be evicted like other frames, so nothing is preloaded if it is
+   * 0. Requests with a higher priority are processed first. The rowBytes, colorType, and alphaType
+   * must match the ones passed to PAGDecoder::readFrame() later. Returns false if the decoder has
+   * no cache key to prefetch.
+   */
+  static bool Prefetch(std::shared_ptr<PAGDecoder> decoder, size_t rowBytes, ColorType colorType,
+                       AlphaType alphaType, int preloadFrames = 0, int priority = 0);
+};
+
+/**
+ * Defines methods to manage the asset images shared by the PAGPlayers that enable
+ * PAGPlayer::setUseSharedAssetCache().
+ */
+class PAG_API PAGAssetCache {
+ public:
+  /**
+   * Returns the memory limit in bytes of the shared images that are no longer used by any
+   * PAGPlayer. The default value is 64 MB.
+   */
+  static size_t MaxMemorySize();
+
+  /**
+   * Sets the memory limit in bytes of the shared images that are no longer used by any PAGPlayer.
+   * They are evicted in least recently used order once the limit is exceeded. The images still in
+   * use are never evicted.
+   */
+  static void SetMaxMemorySize(size_t size);
+
+  /**
+   * Returns the estimated total size in bytes of the decoded pixels of all shared images.
+   */
+  static size_t MemoryUsage();
+};
+
+/**
+ * Defines methods to manage the graphics memory used by the caches of all PAGPlayers.
+ */
+class PAG_API PAGMemoryGovernor {
+ public:
+  /**
+   * Returns the memory limit in bytes of the caches of all PAGPlayers. The default value is 0,
+   * which means no limit.
+   */
+  static size_t MaxMemorySize();
+
+  /**
+   * Sets the memory limit in bytes of the caches of all PAGPlayers. Once the limit is exceeded, the
+   * caches not used by the frames currently displayed are released first, and then all caches of
+   * the least recently drawn PAGPlayers. The caches of a PAGPlayer that is drawing are released
+   * after its current frame.
+   */
+  static void SetMaxMemorySize(size_t size);
+
+  /**
+   * Returns the total memory usage in bytes of the caches of all PAGPlayers, which is updated every
+   * time a PAGPlayer draws a frame.
+   */
+  static size_t MemoryUsage();
+
+  /**
+   * Releases the caches of all PAGPlayers and the unused shared asset images according to the
+   * pressure level. It is usually called when the system sends a memory warning.
+   */
+  static void OnMemoryPressure(PAGMemoryPressureLevel level);
 };
 
 /**
@@ -1701,6 +1965,14 @@ class PAG_API PAGVideoDecoder {
    */
   static void SetMaxHardwareDecoderCount(int count);
 
+  /**
+   * Sets the number of threads used by the built-in software decoder (libavc) to decode each video
+   * sequence, which is clamped to the range [1, 3]. The default value is 0, which means the number
+   * is chosen automatically: videos smaller than 960x540 are decoded in one thread, and larger ones
+   * use as many threads as the CPU cores allow. Only affects decoders created afterward.
+   */
+  static void SetSoftwareDecoderThreadCount(int count);
+
   /**
    * Register a software decoder factory to PAG, which can be used to create video decoders for
    * decoding video sequences from a pag file, if hardware decoders are not available.
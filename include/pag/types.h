@@ -1435,6 +1435,44 @@ enum class PAG_API PAGTimeStretchMode : uint8_t {
     RepeatInverted = 3
 };
 
+/**
+ * Defines how image frames are compressed when they are cached to the disk.
+ */
+enum class PAG_API PAGCompressionMode : uint8_t {
+  /**
+   * Compresses image frames with LZ4. Frames that can not be reduced by LZ4 are stored
+   * uncompressed. This is the default mode.
+   */
+  LZ4 = 0,
+  /**
+   * Stores image frames uncompressed, which costs more disk space but skips the decompression when
+   * reading. It is suitable for sequences with tiny frames.
+   */
+  None = 1,
+  /**
+   * Stores image frames as the LZ4 compressed tiles that differ from a previous keyframe, and
+   * stores a full keyframe periodically or when most of the tiles have changed. It significantly
+   * reduces the disk usage of sequences where only small regions change between frames, at the
+   * cost of decoding the keyframe when reading a delta frame.
+   */
+  Delta = 2
+};
+
+/**
+ * Defines how much memory should be released when the system is running low on memory.
+ */
+enum class PAG_API PAGMemoryPressureLevel : uint8_t {
+  /**
+   * Releases the caches not used by the frames currently displayed.
+   */
+  Moderate = 0,
+  /**
+   * Releases all caches that can be recreated, including the ones used by the frames currently
+   * displayed, which will be recreated when they are drawn again.
+   */
+  Critical = 1
+};
+
 enum class PAG_API ParagraphJustification : uint8_t {
   LeftJustify = 0,
   CenterJustify = 1,
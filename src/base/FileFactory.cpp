@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <unordered_map>
+#include "base/utils/MappedFile.h"
 #include "pag/file.h"
 
 namespace pag {
@@ -54,12 +55,49 @@ static std::shared_ptr<File> FindFileByPath(const std::string& filePath) {
   return nullptr;
 }
 
-std::shared_ptr<File> File::Load(const std::string& filePath, const std::string& password) {
-  auto byteData = ByteData::FromPath(filePath);
-  if (byteData == nullptr) {
+static void CacheFile(const std::string& filePath, std::shared_ptr<File> file) {
+  std::lock_guard<std::mutex> autoLock(globalLocker);
+  std::weak_ptr<File> weak = file;
+  weakFileMap.insert(std::make_pair(filePath, std::move(weak)));
+}
+
+std::shared_ptr<File> File::Load(const std::string& filePath, const std::string&) {
+  auto file = FindFileByPath(filePath);
+  if (file != nullptr) {
+    return file;
+  }
+  std::shared_ptr<ByteData> byteData = ByteData::FromPath(filePath);
+  if (byteData == nullptr || byteData->length() > UINT32_MAX) {
     return nullptr;
   }
-  return pag::File::Load(byteData->data(), byteData->length(), filePath, password);
+  // The loaded bytes are owned by this method, so the embedded resources and the video frames
+  // reference slices of them instead of being copied, and the video frames are only copied out
+  // on first access. The bytes are released once the file and all of its resources are released.
+  auto data = byteData->data();
+  auto length = static_cast<uint32_t>(byteData->length());
+  file = Codec::Decode(data, length, filePath, std::move(byteData));
+  if (file != nullptr) {
+    CacheFile(filePath, file);
+  }
+  return file;
+}
+
+std::shared_ptr<File> File::LoadMapped(const std::string& filePath, const std::string& password) {
+  // A file loaded by copying has the same contents, and it is safe to share.
+  auto file = FindFileByPath(filePath);
+  if (file != nullptr) {
+    return file;
+  }
+  std::shared_ptr<MappedFile> mappedFile = MappedFile::MakeFromPath(filePath);
+  if (mappedFile == nullptr || mappedFile->size() > UINT32_MAX) {
+    return File::Load(filePath, password);
+  }
+  // The embedded resources reference slices of the mapped file, which stays mapped until all of
+  // them are released. The result is not put into the path cache, so File::Load() never returns a
+  // mapped file to callers that did not ask for one.
+  auto data = mappedFile->data();
+  auto length = static_cast<uint32_t>(mappedFile->size());
+  return Codec::Decode(data, length, filePath, std::move(mappedFile));
 }
 
 std::shared_ptr<File> File::Load(const void* bytes, size_t length, const std::string& filePath,
@@ -70,9 +108,7 @@ std::shared_ptr<File> File::Load(const void* bytes, size_t length, const std::st
   }
   file = Codec::Decode(bytes, static_cast<uint32_t>(length), filePath);
   if (file != nullptr) {
-    std::lock_guard<std::mutex> autoLock(globalLocker);
-    std::weak_ptr<File> weak = file;
-    weakFileMap.insert(std::make_pair(filePath, std::move(weak)));
+    CacheFile(filePath, file);
   }
   return file;
 }
@@ -17,6 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "base/utils/Verify.h"
+#include "codec/utils/VideoFrameLoader.h"
 #include "pag/file.h"
 
 namespace pag {
@@ -41,12 +42,21 @@ bool VideoSequence::verify() const {
     VerifyFailed();
     return false;
   }
-  auto frameNotNull = [](VideoFrame* frame) {
-    return frame != nullptr && frame->fileBytes != nullptr;
-  };
-  if (!std::all_of(frames.begin(), frames.end(), frameNotNull)) {
-    VerifyFailed();
-    return false;
+  if (frameLoader != nullptr) {
+    auto frameNotNull = [](VideoFrame* frame) { return frame != nullptr; };
+    if (!std::all_of(frames.begin(), frames.end(), frameNotNull) ||
+        !frameLoader->verify(frames.size())) {
+      VerifyFailed();
+      return false;
+    }
+  } else {
+    auto frameNotNull = [](VideoFrame* frame) {
+      return frame != nullptr && frame->fileBytes != nullptr;
+    };
+    if (!std::all_of(frames.begin(), frames.end(), frameNotNull)) {
+      VerifyFailed();
+      return false;
+    }
   }
   auto headerNotNull = [](ByteData* header) { return header != nullptr; };
   if (!std::all_of(headers.begin(), headers.end(), headerNotNull)) {
@@ -56,6 +66,12 @@ bool VideoSequence::verify() const {
   return true;
 }
 
+void VideoSequence::loadFrames() const {
+  if (frameLoader != nullptr) {
+    frameLoader->load(frames);
+  }
+}
+
 // The exact total width and height of the picture were not recorded when the video sequence frame
 // was exported，You need to do the calculation yourself with width and alphaStartX，
 // If an odd size is encountered, the exporter plugin automatically increments by one，
@@ -0,0 +1,108 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <sys/mman.h>
+#endif
+
+namespace pag {
+#ifdef _WIN32
+
+std::unique_ptr<MappedFile> MappedFile::MakeFrom(FILE* file, size_t length) {
+  if (file == nullptr || length == 0) {
+    return nullptr;
+  }
+  fflush(file);
+  auto fileHandle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+  if (fileHandle == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+  auto mapping = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    return nullptr;
+  }
+  auto data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, length);
+  // The mapped view keeps an internal reference to the mapping object.
+  CloseHandle(mapping);
+  if (data == nullptr) {
+    return nullptr;
+  }
+  return std::unique_ptr<MappedFile>(
+      new MappedFile(reinterpret_cast<const uint8_t*>(data), length));
+}
+
+MappedFile::~MappedFile() {
+  UnmapViewOfFile(_data);
+}
+
+#elif !defined(__EMSCRIPTEN__)
+
+std::unique_ptr<MappedFile> MappedFile::MakeFrom(FILE* file, size_t length) {
+  if (file == nullptr || length == 0) {
+    return nullptr;
+  }
+  fflush(file);
+  auto data = mmap(nullptr, length, PROT_READ, MAP_SHARED, fileno(file), 0);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  return std::unique_ptr<MappedFile>(
+      new MappedFile(reinterpret_cast<const uint8_t*>(data), length));
+}
+
+MappedFile::~MappedFile() {
+  munmap(const_cast<uint8_t*>(_data), _size);
+}
+
+#else
+
+std::unique_ptr<MappedFile> MappedFile::MakeFrom(FILE*, size_t) {
+  return nullptr;
+}
+
+MappedFile::~MappedFile() = default;
+
+#endif
+
+std::unique_ptr<MappedFile> MappedFile::MakeFromPath(const std::string& filePath) {
+  if (filePath.empty()) {
+    return nullptr;
+  }
+  auto file = fopen(filePath.c_str(), "rb");
+  if (file == nullptr) {
+    return nullptr;
+  }
+  std::unique_ptr<MappedFile> mappedFile = nullptr;
+  if (fseek(file, 0, SEEK_END) == 0) {
+    auto length = ftell(file);
+    if (length > 0) {
+      mappedFile = MakeFrom(file, static_cast<size_t>(length));
+    }
+  }
+  // The mapped region stays valid after the file is closed.
+  fclose(file);
+  return mappedFile;
+}
+
+MappedFile::MappedFile(const uint8_t* data, size_t size) : _data(data), _size(size) {
+}
+}  // namespace pag
@@ -0,0 +1,67 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace pag {
+/**
+ * MappedFile maps a region of a file into memory as read-only, which allows reading the file
+ * contents directly from memory without copying them through stdio buffers.
+ */
+class MappedFile {
+ public:
+  /**
+   * Maps the first length bytes of the specified opened file into memory. Returns nullptr if the
+   * length is zero or the platform does not support memory mapping.
+   */
+  static std::unique_ptr<MappedFile> MakeFrom(FILE* file, size_t length);
+
+  /**
+   * Maps the entire file at the specified path into memory. Returns nullptr if the file is empty,
+   * can not be opened, or the platform does not support memory mapping.
+   */
+  static std::unique_ptr<MappedFile> MakeFromPath(const std::string& filePath);
+
+  ~MappedFile();
+
+  /**
+   * Returns the start address of the mapped region.
+   */
+  const uint8_t* data() const {
+    return _data;
+  }
+
+  /**
+   * Returns the size of the mapped region in bytes.
+   */
+  size_t size() const {
+    return _size;
+  }
+
+ private:
+  const uint8_t* _data = nullptr;
+  size_t _size = 0;
+
+  MappedFile(const uint8_t* data, size_t size);
+};
+}  // namespace pag
@@ -209,7 +209,14 @@ DecodeStream ReadBodyBytes(DecodeStream* stream) {
 
 std::shared_ptr<File> Codec::Decode(const void* bytes, uint32_t byteLength,
                                     const std::string& filePath) {
+  return Decode(bytes, byteLength, filePath, nullptr);
+}
+
+std::shared_ptr<File> Codec::Decode(const void* bytes, uint32_t byteLength,
+                                    const std::string& filePath,
+                                    std::shared_ptr<void> bytesOwner) {
   CodecContext context = {};
+  context.bytesOwner = std::move(bytesOwner);
   DecodeStream stream(&context, reinterpret_cast<const uint8_t*>(bytes), byteLength);
   auto bodyBytes = ReadBodyBytes(&stream);
   if (context.hasException()) {
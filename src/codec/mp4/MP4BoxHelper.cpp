@@ -171,6 +171,7 @@ static std::unique_ptr<ByteData> MakeMP4Data(const VideoSequence* videoSequence,
 }
 
 std::unique_ptr<ByteData> MP4BoxHelper::CovertToMP4(const VideoSequence* videoSequence) {
+  videoSequence->loadFrames();
   if (!videoSequence->MP4Header) {
     return MakeMP4Data(videoSequence, true);
   }
@@ -178,6 +179,7 @@ std::unique_ptr<ByteData> MP4BoxHelper::CovertToMP4(const VideoSequence* videoSe
 }
 
 void MP4BoxHelper::WriteMP4Header(VideoSequence* videoSequence) {
+  videoSequence->loadFrames();
   videoSequence->MP4Header = MakeMP4Data(videoSequence, false).release();
 }
 }  // namespace pag
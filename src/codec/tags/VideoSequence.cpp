@@ -18,8 +18,19 @@
 
 #include "VideoSequence.h"
 #include "codec/utils/NALUReader.h"
+#include "codec/utils/VideoFrameLoader.h"
 
 namespace pag {
+static void ReadFrameBytes(DecodeStream* stream, VideoFrameLoader* frameLoader) {
+  auto length = stream->readEncodedUint32();
+  auto bytes = stream->readBytes(length);
+  if (length == 0 || length > bytes.length() || stream->context->hasException()) {
+    frameLoader->addFrame(nullptr, 0);
+    return;
+  }
+  frameLoader->addFrame(bytes.data(), length);
+}
+
 VideoSequence* ReadVideoSequence(DecodeStream* stream, bool hasAlpha) {
   auto sequence = new VideoSequence();
   sequence->width = stream->readEncodedInt32();
@@ -45,13 +56,20 @@ VideoSequence* ReadVideoSequence(DecodeStream* stream, bool hasAlpha) {
     sequence->frames.push_back(videoFrame);
     videoFrame->isKeyframe = stream->readBitBoolean();
   }
+  // Decodes the frame bytes lazily if they can reference the source bytes, which avoids copying
+  // the frames of sequences that are never displayed.
+  auto frameLoader = VideoFrameLoader::Attach(sequence, stream->context->bytesOwner);
   for (uint32_t i = 0; i < count; i++) {
     if (stream->context->hasException()) {
       return sequence;
     }
     auto videoFrame = sequence->frames[i];
     videoFrame->frame = ReadTime(stream);
-    videoFrame->fileBytes = ReadByteDataWithStartCode(stream).release();
+    if (frameLoader != nullptr) {
+      ReadFrameBytes(stream, frameLoader);
+    } else {
+      videoFrame->fileBytes = ReadByteDataWithStartCode(stream).release();
+    }
   }
 
   if (stream->bytesAvailable() > 0) {
@@ -84,6 +102,7 @@ static void WriteByteDataWithoutStartCode(EncodeStream* stream, ByteData* byteDa
 
 TagCode WriteVideoSequence(EncodeStream* stream, std::pair<VideoSequence*, bool>* parameter) {
   auto sequence = parameter->first;
+  sequence->loadFrames();
   auto hasAlpha = parameter->second;
   stream->writeEncodedInt32(sequence->width);
   stream->writeEncodedInt32(sequence->height);
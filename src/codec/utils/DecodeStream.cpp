@@ -147,6 +147,10 @@ std::unique_ptr<ByteData> DecodeStream::readByteData() {
   if (length == 0 || length > bytes.length() || context->hasException()) {
     return nullptr;
   }
+  if (context->bytesOwner != nullptr) {
+    auto data = const_cast<uint8_t*>(bytes.data());
+    return ByteData::MakeAdopted(data, length, [owner = context->bytesOwner](uint8_t*) {});
+  }
   return ByteData::MakeCopy(bytes.data(), length);
 }
 
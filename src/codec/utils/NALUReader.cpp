@@ -27,11 +27,15 @@ std::unique_ptr<ByteData> ReadByteDataWithStartCode(DecodeStream* stream) {
   if (length == 0 || length > bytes.length() || stream->context->hasException()) {
     return nullptr;
   }
+  return MakeByteDataWithStartCode(bytes.data(), length);
+}
+
+std::unique_ptr<ByteData> MakeByteDataWithStartCode(const uint8_t* bytes, uint32_t length) {
   auto data = new (std::nothrow) uint8_t[length + 4];
   if (data == nullptr) {
     return nullptr;
   }
-  memcpy(data + 4, bytes.data(), length);
+  memcpy(data + 4, bytes, length);
   if (Platform::Current()->naluType() == NALUType::AVCC) {
     // AVCC
     data[0] = static_cast<uint8_t>((length >> 24) & 0xFF);
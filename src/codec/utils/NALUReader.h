@@ -23,4 +23,9 @@
 
 namespace pag {
 std::unique_ptr<ByteData> ReadByteDataWithStartCode(DecodeStream* stream);
+
+/**
+ * Copies the specified NALU bytes into a new ByteData with a 4-byte start code in front of them.
+ */
+std::unique_ptr<ByteData> MakeByteDataWithStartCode(const uint8_t* bytes, uint32_t length);
 }
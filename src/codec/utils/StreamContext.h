@@ -20,6 +20,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include "base/utils/Log.h"
@@ -44,6 +45,12 @@ class StreamContext {
   }
 
   std::vector<std::string> errorMessages;
+
+  /**
+   * The owner of the source bytes being decoded. If not null, the ByteData objects read from the
+   * streams reference the source bytes directly and keep the owner alive instead of copying them.
+   */
+  std::shared_ptr<void> bytesOwner = nullptr;
 };
 
 inline size_t BitsToBytes(size_t capacity) {
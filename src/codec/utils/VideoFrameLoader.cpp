@@ -0,0 +1,72 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "VideoFrameLoader.h"
+#include <algorithm>
+#include "codec/utils/NALUReader.h"
+
+namespace pag {
+VideoFrameLoader* VideoFrameLoader::Attach(VideoSequence* sequence,
+                                           std::shared_ptr<void> bytesOwner) {
+  if (sequence == nullptr || bytesOwner == nullptr) {
+    return nullptr;
+  }
+  auto loader = std::shared_ptr<VideoFrameLoader>(new VideoFrameLoader(std::move(bytesOwner)));
+  sequence->frameLoader = loader;
+  return loader.get();
+}
+
+VideoFrameLoader::VideoFrameLoader(std::shared_ptr<void> bytesOwner)
+    : bytesOwner(std::move(bytesOwner)) {
+}
+
+void VideoFrameLoader::addFrame(const uint8_t* data, uint32_t length) {
+  frameBytes.emplace_back(data, length);
+}
+
+bool VideoFrameLoader::verify(size_t frameCount) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  if (loaded) {
+    return true;
+  }
+  if (frameBytes.size() != frameCount) {
+    return false;
+  }
+  return std::all_of(frameBytes.begin(), frameBytes.end(),
+                     [](const std::pair<const uint8_t*, uint32_t>& item) {
+                       return item.first != nullptr;
+                     });
+}
+
+void VideoFrameLoader::load(const std::vector<VideoFrame*>& frames) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  if (loaded) {
+    return;
+  }
+  loaded = true;
+  auto count = std::min(frames.size(), frameBytes.size());
+  for (size_t i = 0; i < count; i++) {
+    auto& bytes = frameBytes[i];
+    if (bytes.first != nullptr && frames[i]->fileBytes == nullptr) {
+      frames[i]->fileBytes = MakeByteDataWithStartCode(bytes.first, bytes.second).release();
+    }
+  }
+  frameBytes = {};
+  bytesOwner = nullptr;
+}
+}  // namespace pag
@@ -0,0 +1,64 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "pag/file.h"
+
+namespace pag {
+/**
+ * VideoFrameLoader records the source bytes of video frames during a lazy decoding, and copies
+ * them into the frames on first access. The source bytes are kept alive by the bytes owner until
+ * the frames are loaded.
+ */
+class VideoFrameLoader {
+ public:
+  /**
+   * Creates a VideoFrameLoader and attaches it to the specified sequence, which keeps it alive.
+   */
+  static VideoFrameLoader* Attach(VideoSequence* sequence, std::shared_ptr<void> bytesOwner);
+
+  /**
+   * Records the source bytes of the next frame. The data is nullptr if the frame bytes are invalid.
+   */
+  void addFrame(const uint8_t* data, uint32_t length);
+
+  /**
+   * Returns true if the source bytes of all the specified number of frames are valid, or the frames
+   * have already been loaded.
+   */
+  bool verify(size_t frameCount);
+
+  /**
+   * Copies the recorded source bytes into the specified frames if they have not been loaded yet.
+   * It's safe to call this method from multiple threads.
+   */
+  void load(const std::vector<VideoFrame*>& frames);
+
+ private:
+  std::mutex locker = {};
+  bool loaded = false;
+  std::shared_ptr<void> bytesOwner = nullptr;
+  std::vector<std::pair<const uint8_t*, uint32_t>> frameBytes = {};
+
+  explicit VideoFrameLoader(std::shared_ptr<void> bytesOwner);
+};
+}  // namespace pag
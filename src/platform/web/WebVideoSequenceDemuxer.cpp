@@ -47,6 +47,7 @@ val WebVideoSequenceDemuxer::getStaticTimeRanges() {
 }
 
 std::unique_ptr<ByteData> WebVideoSequenceDemuxer::getMp4Data() {
+  sequence->loadFrames();
   val isIPhone = val::module_property("isIPhone");
   std::unique_ptr<ByteData> mp4Data;
   if (isIPhone().as<bool>()) {
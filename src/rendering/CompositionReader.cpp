@@ -17,6 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "CompositionReader.h"
+#include "base/utils/TGFXCast.h"
 
 namespace pag {
 std::shared_ptr<CompositionReader> CompositionReader::Make(int width, int height) {
@@ -33,7 +34,7 @@ std::shared_ptr<CompositionReader> CompositionReader::Make(int width, int height
 CompositionReader::CompositionReader(std::shared_ptr<BitmapDrawable> bitmapDrawable)
     : drawable(std::move(bitmapDrawable)) {
   pagPlayer = new PAGPlayer();
-  auto pagSurface = PAGSurface::MakeFrom(drawable);
+  pagSurface = PAGSurface::MakeFrom(drawable);
   pagPlayer->setSurface(pagSurface);
 }
 
@@ -53,8 +54,8 @@ void CompositionReader::setComposition(std::shared_ptr<PAGComposition> compositi
 
 bool CompositionReader::readFrame(double progress, std::shared_ptr<BitmapBuffer> bitmap) {
   std::lock_guard<std::mutex> autoLock(locker);
-  drawable->setBitmap(std::move(bitmap));
-  return renderFrame(progress);
+  drawable->setBitmap(bitmap);
+  return renderFrame(progress) || copyLastFrame(bitmap.get());
 }
 
 bool CompositionReader::renderFrame(double progress) {
@@ -62,4 +63,21 @@ bool CompositionReader::renderFrame(double progress) {
   pagPlayer->flush();
   return drawable->isPixelCopied();
 }
+
+bool CompositionReader::copyLastFrame(BitmapBuffer* bitmap) {
+  // The flush() call skips drawing if the frame has not changed, but the persistent surface still
+  // holds it, which only needs to be read back if the bitmap is not the surface itself.
+  if (bitmap->getHardwareBuffer() != nullptr) {
+    return false;
+  }
+  auto pixels = bitmap->lockPixels();
+  if (pixels == nullptr) {
+    return false;
+  }
+  auto& info = bitmap->info();
+  auto result = pagSurface->readPixels(ToPAG(info.colorType()), ToPAG(info.alphaType()), pixels,
+                                       info.rowBytes());
+  bitmap->unlockPixels();
+  return result;
+}
 }  // namespace pag
@@ -46,10 +46,13 @@ class CompositionReader {
  private:
   std::mutex locker = {};
   PAGPlayer* pagPlayer = nullptr;
+  std::shared_ptr<PAGSurface> pagSurface = nullptr;
   std::shared_ptr<BitmapDrawable> drawable = nullptr;
 
   CompositionReader(std::shared_ptr<BitmapDrawable> bitmapDrawable);
 
   bool renderFrame(double progress);
+
+  bool copyLastFrame(BitmapBuffer* bitmap);
 };
 }  // namespace pag
@@ -20,6 +20,7 @@
 #include "base/utils/USE.h"
 #include "pag/file.h"
 #include "platform/Platform.h"
+#include "rendering/utils/shaper/TextShaper.h"
 
 namespace pag {
 std::shared_ptr<TypefaceHolder> TypefaceHolder::MakeFromName(const std::string& fontFamily,
@@ -205,15 +206,19 @@ PAGFont FontManager::RegisterFont(const void* data, size_t length, int ttcIndex,
 }
 
 void FontManager::UnregisterFont(const PAGFont& font) {
-  return fontManager.unregisterFont(font);
+  fontManager.unregisterFont(font);
+  // Releases the typeface retained by the shaping results.
+  TextShaper::PurgeCaches();
 }
 
 void FontManager::SetFallbackFontNames(const std::vector<std::string>& fontNames) {
   fontManager.setFallbackFontNames(fontNames);
+  TextShaper::PurgeCaches();
 }
 
 void FontManager::SetFallbackFontPaths(const std::vector<std::string>& fontPaths,
                                        const std::vector<int>& ttcIndices) {
   fontManager.setFallbackFontPaths(fontPaths, ttcIndices);
+  TextShaper::PurgeCaches();
 }
 }  // namespace pag
@@ -26,8 +26,47 @@
 #include "rendering/layers/ContentVersion.h"
 #include "rendering/utils/BitmapBuffer.h"
 #include "rendering/utils/LockGuard.h"
+#include "tgfx/core/Buffer.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
+// Set on the threads running the tasks started by readFrames(). The tasks capture the locals of
+// readFrames() by reference, which stay valid since readFrames() waits for all of them before
+// returning. On these threads, the work is done inline instead of starting nested tasks and
+// blocking a pool thread to wait for them.
+static thread_local bool isReadingTask = false;
+
+class ReadingTaskScope {
+ public:
+  ReadingTaskScope() : previous(isReadingTask) {
+    isReadingTask = true;
+  }
+
+  ~ReadingTaskScope() {
+    isReadingTask = previous;
+  }
+
+ private:
+  bool previous = false;
+};
+
+// Set on the threads calling the callback of readFrames(), which holds the locker of the decoder
+// until it returns. Calls into the same decoder from the callback must not take the locker again.
+static thread_local const PAGDecoder* callbackDecoder = nullptr;
+
+class CallbackScope {
+ public:
+  explicit CallbackScope(const PAGDecoder* decoder) : previous(callbackDecoder) {
+    callbackDecoder = decoder;
+  }
+
+  ~CallbackScope() {
+    callbackDecoder = previous;
+  }
+
+ private:
+  const PAGDecoder* previous = nullptr;
+};
 
 static std::string DefaultCacheKeyGeneratorFunc(PAGDecoder* decoder,
                                                 std::shared_ptr<PAGComposition> composition) {
@@ -43,6 +82,15 @@ static std::string DefaultCacheKeyGeneratorFunc(PAGDecoder* decoder,
          std::to_string(decoder->height());
 }
 
+static std::shared_ptr<PAGComposition> CloneComposition(
+    std::shared_ptr<PAGComposition> composition) {
+  // Only an unmodified PAGFile can be rendered identically by an independent copy.
+  if (!composition->isPAGFile() || pag::ContentVersion::Get(composition) > 0) {
+    return nullptr;
+  }
+  return static_cast<PAGFile*>(composition.get())->copyOriginal();
+}
+
 Composition* PAGDecoder::GetSingleComposition(std::shared_ptr<PAGComposition> pagComposition) {
   auto numChildren = pagComposition->numChildren();
   if (numChildren == 0) {
@@ -113,6 +161,16 @@ std::shared_ptr<PAGDecoder> PAGDecoder::MakeFrom(std::shared_ptr<PAGComposition>
                                                     result.second, maxFrameRate));
 }
 
+std::shared_ptr<PAGDecoder> PAGDecoder::MakeFrom(std::shared_ptr<PAGComposition> composition,
+                                                 float maxFrameRate, float scale,
+                                                 int workerCount) {
+  auto decoder = MakeFrom(std::move(composition), maxFrameRate, scale);
+  if (decoder != nullptr) {
+    decoder->workerCount = std::max(workerCount, 1);
+  }
+  return decoder;
+}
+
 PAGDecoder::PAGDecoder(std::shared_ptr<PAGComposition> composition, int width, int height,
                        int numFrames, float frameRate, float maxFrameRate)
     : _width(width), _height(height), _numFrames(numFrames), _frameRate(frameRate),
@@ -128,12 +186,19 @@ PAGDecoder::~PAGDecoder() {
 }
 
 int PAGDecoder::numFrames() {
+  if (callbackDecoder == this) {
+    // The locker is held by readFrames(), which never changes the value while it is running.
+    return _numFrames;
+  }
   std::lock_guard<std::mutex> auoLock(locker);
   checkCompositionChange(getComposition());
   return _numFrames;
 }
 
 float PAGDecoder::frameRate() {
+  if (callbackDecoder == this) {
+    return _frameRate;
+  }
   std::lock_guard<std::mutex> auoLock(locker);
   checkCompositionChange(getComposition());
   return _frameRate;
@@ -154,6 +219,9 @@ bool PAGDecoder::checkFrameChanged(int index) {
 
 bool PAGDecoder::readFrame(int index, void* pixels, size_t rowBytes, ColorType colorType,
                            AlphaType alphaType) {
+  if (checkInCallback()) {
+    return false;
+  }
   std::lock_guard<std::mutex> auoLock(locker);
   auto info =
       tgfx::ImageInfo::Make(_width, _height, ToTGFX(colorType), ToTGFX(alphaType), rowBytes);
@@ -162,6 +230,9 @@ bool PAGDecoder::readFrame(int index, void* pixels, size_t rowBytes, ColorType c
 }
 
 bool PAGDecoder::readFrame(int index, HardwareBufferRef hardwareBuffer) {
+  if (checkInCallback()) {
+    return false;
+  }
   std::lock_guard<std::mutex> auoLock(locker);
   auto bitmap = BitmapBuffer::Wrap(hardwareBuffer);
   return readFrameInternal(index, bitmap);
@@ -181,32 +252,199 @@ bool PAGDecoder::readFrameInternal(int index, std::shared_ptr<BitmapBuffer> bitm
   if (!checkSequenceFile(composition, bitmap->info())) {
     return false;
   }
-  auto success = sequenceFile->readFrame(index, bitmap);
+  auto success = DiskCache::ReadFrame(sequenceFile, index, bitmap);
   if (!success) {
     success = renderFrame(composition, index, bitmap);
     if (success) {
-      success = sequenceFile->writeFrame(index, bitmap);
+      success = DiskCache::WriteFrame(sequenceFile, index, bitmap);
       if (!success) {
         LOGE("PAGDecoder::readFrame() Failed to write frame to SequenceFile!");
       }
     }
   }
-  if (sequenceFile->isComplete() && composition != nullptr) {
-    if (reader != nullptr) {
-      reader = nullptr;
-      if (composition.use_count() != 1) {
-        container->addLayer(composition);
+  checkSequenceComplete(composition);
+  if (success) {
+    lastReadIndex = index;
+  }
+  return success;
+}
+
+bool PAGDecoder::readFrames(int startIndex, int endIndex, size_t rowBytes, ColorType colorType,
+                            AlphaType alphaType,
+                            std::function<void(int index, const void* pixels)> callback) {
+  if (checkInCallback()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> auoLock(locker);
+  auto composition = getComposition();
+  checkCompositionChange(composition);
+  if (startIndex < 0 || startIndex > endIndex || endIndex >= _numFrames) {
+    LOGE("PAGDecoder::readFrames() The index range is out of range!");
+    return false;
+  }
+  auto info =
+      tgfx::ImageInfo::Make(_width, _height, ToTGFX(colorType), ToTGFX(alphaType), rowBytes);
+  if (info.isEmpty()) {
+    LOGE("PAGDecoder::readFrames() The specified rowBytes is invalid!");
+    return false;
+  }
+  if (!checkSequenceFile(composition, info)) {
+    return false;
+  }
+  std::vector<std::shared_ptr<CompositionReader>> readers = {};
+  if (composition != nullptr && !sequenceFile->isComplete()) {
+    if (reader == nullptr) {
+      reader = CompositionReader::Make(_width, _height);
+      if (reader == nullptr) {
+        LOGE("PAGDecoder::readFrames() Failed to create a CompositionReader!");
+        return false;
       }
-    } else if (composition.use_count() <= 2) {
-      container->removeAllLayers();
+      reader->setComposition(composition);
     }
+    readers.push_back(reader);
+    // Called from a callback of another readFrames() call, the frames are rendered on the current
+    // thread only.
+    auto maxWorkers = isReadingTask ? 1 : std::min(workerCount, endIndex - startIndex + 1);
+    while (static_cast<int>(readers.size()) < maxWorkers) {
+      auto copy = CloneComposition(composition);
+      if (copy == nullptr) {
+        break;
+      }
+      auto copyReader = CompositionReader::Make(_width, _height);
+      if (copyReader == nullptr) {
+        break;
+      }
+      copyReader->setComposition(copy);
+      readers.push_back(copyReader);
+    }
+  } else {
+    readers.push_back(nullptr);
+  }
+  auto numWorkers = static_cast<int>(readers.size());
+  auto totalFrames = endIndex - startIndex + 1;
+  auto framesPerWorker = (totalFrames + numWorkers - 1) / numWorkers;
+  std::vector<std::vector<int>> workerIndices(readers.size());
+  for (int i = 0; i < totalFrames; i++) {
+    workerIndices[i / framesPerWorker].push_back(startIndex + i);
+  }
+  std::atomic_bool success = {true};
+  std::vector<std::shared_ptr<tgfx::Task>> tasks = {};
+  for (size_t i = 1; i < readers.size(); i++) {
+    auto task = tgfx::Task::Run([&, i]() {
+      ReadingTaskScope scope = {};
+      if (!renderFrames(readers[i], workerIndices[i], info, callback)) {
+        success = false;
+      }
+    });
+    tasks.push_back(task);
+  }
+  if (!renderFrames(readers[0], workerIndices[0], info, callback)) {
+    success = false;
   }
+  for (auto& task : tasks) {
+    task->wait();
+  }
+  readers.clear();
+  checkSequenceComplete(composition);
   if (success) {
-    lastReadIndex = index;
+    lastReadIndex = endIndex;
   }
   return success;
 }
 
+bool PAGDecoder::checkInCallback() const {
+  if (callbackDecoder != this) {
+    return false;
+  }
+  LOGE("PAGDecoder: Can not read frames from the callback of readFrames() on the same decoder!");
+  return true;
+}
+
+bool PAGDecoder::renderFrames(std::shared_ptr<CompositionReader> frameReader,
+                              const std::vector<int>& indices, const tgfx::ImageInfo& info,
+                              const std::function<void(int index, const void* pixels)>& callback) {
+  if (indices.empty()) {
+    return true;
+  }
+  // On the calling thread, two bitmaps are used in turn, so that the disk caching and the callback
+  // of one frame run on a background task while the next frame is being rendered. The reading tasks
+  // finish each frame inline, which only needs one bitmap.
+  auto byteSize = info.byteSize();
+  auto bitmapCount = isReadingTask ? 1 : 2;
+  tgfx::Buffer buffer(byteSize * bitmapCount);
+  if (buffer.isEmpty()) {
+    LOGE("PAGDecoder::readFrames() Failed to allocate the pixel buffer!");
+    return false;
+  }
+  std::shared_ptr<BitmapBuffer> bitmaps[2] = {};
+  for (int i = 0; i < bitmapCount; i++) {
+    bitmaps[i] = BitmapBuffer::Wrap(info, buffer.bytes() + i * byteSize);
+  }
+  auto finishFrame = [&](int index, bool rendered, std::shared_ptr<BitmapBuffer> bitmap,
+                         const void* pixels) {
+    if (rendered) {
+      // Another worker may have already written a frame of the same static time range.
+      DiskCache::WriteFrame(sequenceFile, index, bitmap);
+    }
+    if (callback) {
+      CallbackScope scope(this);
+      callback(index, pixels);
+    }
+  };
+  std::shared_ptr<tgfx::Task> pendingTask = nullptr;
+  auto success = true;
+  size_t slot = 0;
+  for (auto index : indices) {
+    auto bitmap = bitmaps[slot];
+    auto rendered = false;
+    if (!DiskCache::ReadFrame(sequenceFile, index, bitmap)) {
+      if (frameReader == nullptr) {
+        success = false;
+        break;
+      }
+      auto progress = FrameToProgress(static_cast<Frame>(index), _numFrames);
+      if (!frameReader->readFrame(progress, bitmap)) {
+        LOGE("PAGDecoder::readFrames() Failed to render frame %d!", index);
+        success = false;
+        break;
+      }
+      rendered = true;
+    }
+    auto pixels = buffer.bytes() + slot * byteSize;
+    if (isReadingTask) {
+      // Already on a task thread, which must not block waiting for another task.
+      finishFrame(index, rendered, bitmap, pixels);
+      continue;
+    }
+    if (pendingTask != nullptr) {
+      pendingTask->wait();
+    }
+    pendingTask = tgfx::Task::Run([&, index, rendered, bitmap, pixels]() {
+      ReadingTaskScope scope = {};
+      finishFrame(index, rendered, bitmap, pixels);
+    });
+    slot = 1 - slot;
+  }
+  if (pendingTask != nullptr) {
+    pendingTask->wait();
+  }
+  return success;
+}
+
+void PAGDecoder::checkSequenceComplete(const std::shared_ptr<PAGComposition>& composition) {
+  if (!sequenceFile->isComplete() || composition == nullptr) {
+    return;
+  }
+  if (reader != nullptr) {
+    reader = nullptr;
+    if (composition.use_count() != 1) {
+      container->addLayer(composition);
+    }
+  } else if (composition.use_count() <= 2) {
+    container->removeAllLayers();
+  }
+}
+
 bool PAGDecoder::renderFrame(std::shared_ptr<PAGComposition> composition, int index,
                              std::shared_ptr<BitmapBuffer> bitmap) {
   if (composition == nullptr) {
@@ -272,6 +510,37 @@ void PAGDecoder::checkCompositionChange(std::shared_ptr<PAGComposition> composit
   staticTimeRanges = GetStaticTimeRange(composition, _numFrames);
 }
 
+bool PAGDecoder::prefetch(size_t rowBytes, ColorType colorType, AlphaType alphaType,
+                          int preloadFrames, int priority) {
+  if (callbackDecoder == this) {
+    // readFrames() has already opened the sequence file.
+    return true;
+  }
+  std::lock_guard<std::mutex> autoLock(locker);
+  auto composition = getComposition();
+  checkCompositionChange(composition);
+  if (sequenceFile != nullptr) {
+    return true;
+  }
+  if (composition == nullptr) {
+    return false;
+  }
+  auto info =
+      tgfx::ImageInfo::Make(_width, _height, ToTGFX(colorType), ToTGFX(alphaType), rowBytes);
+  if (info.isEmpty()) {
+    LOGE("PAGDecoder::prefetch() The specified rowBytes is invalid!");
+    return false;
+  }
+  // Temporary sequence files can not be shared with later reads.
+  auto key = generateCacheKey(composition);
+  if (key.empty()) {
+    return false;
+  }
+  DiskCache::Prefetch(key, info, _numFrames, _frameRate, staticTimeRanges, preloadFrames,
+                      priority);
+  return true;
+}
+
 std::string PAGDecoder::generateCacheKey(std::shared_ptr<PAGComposition> composition) {
   return cacheKeyGeneratorFun == nullptr ? DefaultCacheKeyGeneratorFunc(this, composition)
                                          : cacheKeyGeneratorFun(this, composition);
@@ -91,6 +91,7 @@ void PAGPlayer::setSurfaceInternal(std::shared_ptr<PAGSurface> newSurface) {
   if (pagSurface) {
     pagSurface->pagPlayer = nullptr;
     pagSurface->rootLocker = std::make_shared<std::mutex>();
+    pagSurface->lastGraphic = nullptr;
   }
   pagSurface = newSurface;
   if (pagSurface) {
@@ -133,6 +134,36 @@ void PAGPlayer::setUseDiskCache(bool value) {
   renderCache->setUseDiskCache(value);
 }
 
+int PAGPlayer::sequencePrefetchDepth() {
+  LockGuard autoLock(rootLocker);
+  return renderCache->sequencePrefetchDepth();
+}
+
+void PAGPlayer::setSequencePrefetchDepth(int value) {
+  LockGuard autoLock(rootLocker);
+  renderCache->setSequencePrefetchDepth(value);
+}
+
+int PAGPlayer::sequenceCheckpointInterval() {
+  LockGuard autoLock(rootLocker);
+  return renderCache->sequenceCheckpointInterval();
+}
+
+void PAGPlayer::setSequenceCheckpointInterval(int value) {
+  LockGuard autoLock(rootLocker);
+  renderCache->setSequenceCheckpointInterval(value);
+}
+
+bool PAGPlayer::useSharedAssetCache() {
+  LockGuard autoLock(rootLocker);
+  return renderCache->useSharedAssetCache();
+}
+
+void PAGPlayer::setUseSharedAssetCache(bool value) {
+  LockGuard autoLock(rootLocker);
+  renderCache->setUseSharedAssetCache(value);
+}
+
 float PAGPlayer::cacheScale() {
   LockGuard autoLock(rootLocker);
   return stage->cacheScale();
@@ -257,6 +288,26 @@ void PAGPlayer::setAutoClear(bool value) {
   stage->notifyModified(true);
 }
 
+bool PAGPlayer::partialRedrawEnabled() {
+  LockGuard autoLock(rootLocker);
+  return _partialRedrawEnabled;
+}
+
+void PAGPlayer::setPartialRedrawEnabled(bool value) {
+  LockGuard autoLock(rootLocker);
+  _partialRedrawEnabled = value;
+}
+
+bool PAGPlayer::pipelinedRenderingEnabled() {
+  LockGuard autoLock(rootLocker);
+  return renderCache->pipelinedRenderingEnabled();
+}
+
+void PAGPlayer::setPipelinedRenderingEnabled(bool value) {
+  LockGuard autoLock(rootLocker);
+  renderCache->setPipelinedRenderingEnabled(value);
+}
+
 void PAGPlayer::prepare() {
   LockGuard autoLock(rootLocker);
   prepareInternal();
@@ -301,8 +352,10 @@ bool PAGPlayer::flushInternal(BackendSemaphore* signalSemaphore) {
   }
   tgfx::Clock clock = {};
   prepareInternal();
+  renderCache->prepareNextContents();
   clock.mark("rendering");
-  if (!pagSurface->draw(renderCache, lastGraphic, signalSemaphore, _autoClear)) {
+  if (!pagSurface->draw(renderCache, lastGraphic, signalSemaphore, _autoClear,
+                        _partialRedrawEnabled)) {
     return false;
   }
   clock.mark("presenting");
@@ -347,6 +400,14 @@ Rect PAGPlayer::getBounds(std::shared_ptr<PAGLayer> pagLayer) {
   return contains ? ToPAG(bounds) : Rect::MakeEmpty();
 }
 
+Rect PAGPlayer::getDirtyRect() {
+  LockGuard autoLock(rootLocker);
+  if (pagSurface == nullptr) {
+    return Rect::MakeEmpty();
+  }
+  return pagSurface->dirtyRect;
+}
+
 std::vector<std::shared_ptr<PAGLayer>> PAGPlayer::getLayersUnderPoint(float surfaceX,
                                                                       float surfaceY) {
   LockGuard autoLock(rootLocker);
@@ -193,7 +193,7 @@ bool PAGSurface::readPixels(ColorType colorType, AlphaType alphaType, void* dstP
 }
 
 bool PAGSurface::draw(RenderCache* cache, std::shared_ptr<Graphic> graphic,
-                      BackendSemaphore* signalSemaphore, bool autoClear) {
+                      BackendSemaphore* signalSemaphore, bool autoClear, bool partialRedraw) {
   auto context = lockContext();
   if (!context) {
     return false;
@@ -201,9 +201,12 @@ bool PAGSurface::draw(RenderCache* cache, std::shared_ptr<Graphic> graphic,
   cache->prepareLayers();
   auto surface = drawable->getSurface(context, true);
   if (surface != nullptr && autoClear && contentVersion == cache->getContentVersion()) {
+    dirtyRect = Rect::MakeEmpty();
     unlockContext();
     return false;
   }
+  // The last frame is only available if the surface is neither recreated nor cleared.
+  auto hasLastFrame = surface != nullptr && contentVersion > 0 && lastFrameCleared;
   if (surface == nullptr) {
     surface = drawable->getSurface(context, false);
   }
@@ -211,13 +214,42 @@ bool PAGSurface::draw(RenderCache* cache, std::shared_ptr<Graphic> graphic,
     unlockContext();
     return false;
   }
+  auto surfaceBounds = tgfx::Rect::MakeWH(surface->width(), surface->height());
+  auto drawingBounds = surfaceBounds;
+  // The last graphic is only kept while partial redraw is enabled, the whole surface is redrawn
+  // if it is missing.
+  if (partialRedraw && autoClear && hasLastFrame && lastGraphic != nullptr) {
+    drawingBounds = tgfx::Rect::MakeEmpty();
+    Graphic::MeasureDirtyBounds(lastGraphic.get(), graphic.get(), &drawingBounds);
+    if (!drawingBounds.isEmpty()) {
+      // Outsets one pixel to cover the anti-aliased edges.
+      drawingBounds.outset(1.0f, 1.0f);
+      drawingBounds.roundOut();
+    }
+    if (!drawingBounds.intersect(surfaceBounds)) {
+      drawingBounds.setEmpty();
+    }
+  }
+  // The surface only contains the last graphic if it was cleared before drawing. It is not kept if
+  // partial redraw is disabled, so the graphic and its caches are released after drawing.
+  lastGraphic = partialRedraw ? graphic : nullptr;
+  lastFrameCleared = autoClear;
+  dirtyRect = ToPAG(drawingBounds);
   contentVersion = cache->getContentVersion();
   cache->attachToContext(context);
   auto canvas = surface->getCanvas();
+  auto clipped = drawingBounds != surfaceBounds && drawable->preservesContents();
+  if (clipped) {
+    canvas->save();
+    canvas->clipRect(drawingBounds);
+  }
   if (autoClear) {
     canvas->clear();
   }
   onDraw(graphic, surface, cache);
+  if (clipped) {
+    canvas->restore();
+  }
   if (signalSemaphore == nullptr) {
     context->flush();
   } else {
@@ -23,8 +23,18 @@
 #include "tgfx/core/Buffer.h"
 #include "tgfx/core/DataView.h"
 #include "tgfx/core/Stream.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
+// The key length of a journal record which removes the file from the cache.
+static constexpr uint32_t REMOVED_RECORD_FLAG = 0xFFFFFFFF;
+// The config journal is compacted once it holds this many more records than the live entries.
+static constexpr size_t JOURNAL_COMPACTION_THRESHOLD = 64;
+// Pending journal records are written to disk once this many of them have been queued.
+static constexpr size_t MAX_PENDING_CONFIG_RECORDS = 32;
+// The maximum number of prefetched files waiting to be taken over by OpenSequence().
+static constexpr size_t MAX_PREFETCHED_FILES = 16;
+
 class FileInfo {
  public:
   FileInfo(std::string cacheKey, uint32_t fileID, size_t fileSize = 0)
@@ -34,9 +44,41 @@ class FileInfo {
   std::string cacheKey;
   uint32_t fileID = 0;
   size_t fileSize = 0;
+  bool opened = false;
+  // Only valid when the file is not opened.
   std::list<std::shared_ptr<FileInfo>>::iterator cachedPosition;
 };
 
+class PendingFrame {
+ public:
+  PendingFrame(std::shared_ptr<SequenceFile> sequenceFile, int index,
+               std::shared_ptr<tgfx::Buffer> pixels)
+      : sequenceFile(std::move(sequenceFile)), index(index), pixels(std::move(pixels)) {
+  }
+
+  std::shared_ptr<SequenceFile> sequenceFile;
+  int index = 0;
+  std::shared_ptr<tgfx::Buffer> pixels;
+};
+
+class PrefetchRequest {
+ public:
+  PrefetchRequest(std::string key, const tgfx::ImageInfo& info, int frameCount, float frameRate,
+                  std::vector<TimeRange> staticTimeRanges, int preloadFrames, int priority)
+      : key(std::move(key)), info(info), frameCount(frameCount), frameRate(frameRate),
+        staticTimeRanges(std::move(staticTimeRanges)), preloadFrames(preloadFrames),
+        priority(priority) {
+  }
+
+  std::string key;
+  tgfx::ImageInfo info = {};
+  int frameCount = 0;
+  float frameRate = 30.0f;
+  std::vector<TimeRange> staticTimeRanges = {};
+  int preloadFrames = 0;
+  int priority = 0;
+};
+
 size_t PAGDiskCache::MaxDiskSize() {
   return DiskCache::GetInstance()->getMaxDiskSize();
 }
@@ -49,6 +91,51 @@ void PAGDiskCache::RemoveAll() {
   DiskCache::GetInstance()->removeAll();
 }
 
+PAGCompressionMode PAGDiskCache::CompressionMode() {
+  return DiskCache::GetInstance()->getCompressionMode();
+}
+
+void PAGDiskCache::SetCompressionMode(PAGCompressionMode mode) {
+  DiskCache::GetInstance()->setCompressionMode(mode);
+}
+
+size_t PAGDiskCache::MaxWriteQueueSize() {
+  return DiskCache::GetInstance()->getMaxWriteQueueSize();
+}
+
+void PAGDiskCache::SetMaxWriteQueueSize(size_t size) {
+  DiskCache::GetInstance()->setMaxWriteQueueSize(size);
+}
+
+size_t PAGDiskCache::WriteQueueDepth() {
+  return DiskCache::GetInstance()->getWriteQueueDepth();
+}
+
+size_t PAGDiskCache::DroppedWriteCount() {
+  return DiskCache::GetInstance()->getDroppedWriteCount();
+}
+
+size_t PAGDiskCache::MaxMemorySize() {
+  return DiskCache::GetInstance()->memoryCache.maxMemorySize();
+}
+
+void PAGDiskCache::SetMaxMemorySize(size_t size) {
+  DiskCache::GetInstance()->memoryCache.setMaxMemorySize(size);
+}
+
+size_t PAGDiskCache::MemoryUsage() {
+  return DiskCache::GetInstance()->memoryCache.memoryUsage();
+}
+
+bool PAGDiskCache::Prefetch(std::shared_ptr<PAGDecoder> decoder, size_t rowBytes,
+                            ColorType colorType, AlphaType alphaType, int preloadFrames,
+                            int priority) {
+  if (decoder == nullptr) {
+    return false;
+  }
+  return decoder->prefetch(rowBytes, colorType, alphaType, preloadFrames, priority);
+}
+
 DiskCache* DiskCache::GetInstance() {
   static auto& diskCache = *new DiskCache();
   return &diskCache;
@@ -57,7 +144,12 @@ DiskCache* DiskCache::GetInstance() {
 std::shared_ptr<SequenceFile> DiskCache::OpenSequence(
     const std::string& key, const tgfx::ImageInfo& info, int frameCount, float frameRate,
     const std::vector<TimeRange>& staticTimeRanges) {
-  return GetInstance()->openSequence(key, info, frameCount, frameRate, staticTimeRanges);
+  auto diskCache = GetInstance();
+  auto sequenceFile = diskCache->openSequence(key, info, frameCount, frameRate, staticTimeRanges);
+  if (!key.empty()) {
+    diskCache->releasePrefetchedFile(key);
+  }
+  return sequenceFile;
 }
 
 std::shared_ptr<tgfx::Data> DiskCache::ReadFile(const std::string& key) {
@@ -68,6 +160,49 @@ bool DiskCache::WriteFile(const std::string& key, std::shared_ptr<tgfx::Data> da
   return GetInstance()->writeFile(key, data);
 }
 
+bool DiskCache::ReadFrame(std::shared_ptr<SequenceFile> sequenceFile, int index,
+                          std::shared_ptr<BitmapBuffer> bitmap) {
+  if (sequenceFile == nullptr || bitmap == nullptr || bitmap->info() != sequenceFile->info()) {
+    return false;
+  }
+  auto& memoryCache = GetInstance()->memoryCache;
+  auto timeRange = GetTimeRangeContains(sequenceFile->staticTimeRanges(), index);
+  auto frameIndex = static_cast<int>(timeRange.start);
+  if (memoryCache.readFrame(sequenceFile->fileID, frameIndex, bitmap)) {
+    return true;
+  }
+  if (!sequenceFile->readFrame(index, bitmap)) {
+    return false;
+  }
+  memoryCache.writeFrame(sequenceFile->fileID, frameIndex, bitmap);
+  return true;
+}
+
+bool DiskCache::WriteFrame(std::shared_ptr<SequenceFile> sequenceFile, int index,
+                           std::shared_ptr<BitmapBuffer> bitmap) {
+  if (sequenceFile == nullptr) {
+    return false;
+  }
+  auto diskCache = GetInstance();
+  auto fileID = sequenceFile->fileID;
+  auto timeRange = GetTimeRangeContains(sequenceFile->staticTimeRanges(), index);
+  if (!diskCache->writeFrame(std::move(sequenceFile), index, bitmap)) {
+    return false;
+  }
+  diskCache->memoryCache.writeFrame(fileID, static_cast<int>(timeRange.start), bitmap);
+  return true;
+}
+
+void DiskCache::Prefetch(const std::string& key, const tgfx::ImageInfo& info, int frameCount,
+                         float frameRate, const std::vector<TimeRange>& staticTimeRanges,
+                         int preloadFrames, int priority) {
+  if (key.empty()) {
+    return;
+  }
+  GetInstance()->prefetch(std::make_shared<PrefetchRequest>(
+      key, info, frameCount, frameRate, staticTimeRanges, preloadFrames, priority));
+}
+
 DiskCache::DiskCache() {
   auto cacheDir = Platform::Current()->getCacheDir();
   if (!cacheDir.empty()) {
@@ -77,6 +212,7 @@ DiskCache::DiskCache() {
       Directory::VisitFiles(cacheFolder,
                             [&](const std::string& path, size_t) { remove(path.c_str()); });
     }
+    flushConfig();
   }
 }
 
@@ -86,81 +222,324 @@ size_t DiskCache::getMaxDiskSize() {
 }
 
 void DiskCache::setMaxDiskSize(size_t size) {
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    if (maxDiskSize == size) {
+      return;
+    }
+    maxDiskSize = size;
+    checkDiskSpace(maxDiskSize);
+  }
+  flushConfig();
+}
+
+PAGCompressionMode DiskCache::getCompressionMode() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return compressionMode;
+}
+
+void DiskCache::setCompressionMode(PAGCompressionMode mode) {
   std::lock_guard<std::mutex> autoLock(locker);
-  if (maxDiskSize == size) {
+  compressionMode = mode;
+}
+
+size_t DiskCache::getMaxWriteQueueSize() {
+  std::lock_guard<std::mutex> autoLock(writeLocker);
+  return maxWriteQueueSize;
+}
+
+void DiskCache::setMaxWriteQueueSize(size_t size) {
+  std::lock_guard<std::mutex> autoLock(writeLocker);
+  maxWriteQueueSize = size;
+}
+
+size_t DiskCache::getWriteQueueDepth() {
+  std::lock_guard<std::mutex> autoLock(writeLocker);
+  return pendingFrames.size();
+}
+
+size_t DiskCache::getDroppedWriteCount() {
+  std::lock_guard<std::mutex> autoLock(writeLocker);
+  return droppedWriteCount;
+}
+
+bool DiskCache::writeFrame(std::shared_ptr<SequenceFile> sequenceFile, int index,
+                           std::shared_ptr<BitmapBuffer> bitmap) {
+  std::unique_lock<std::mutex> autoLock(writeLocker);
+  if (maxWriteQueueSize == 0) {
+    autoLock.unlock();
+    return sequenceFile->writeFrame(index, std::move(bitmap));
+  }
+  if (index < 0 || index >= static_cast<int>(sequenceFile->numFrames()) || bitmap == nullptr ||
+      bitmap->info() != sequenceFile->info()) {
+    return false;
+  }
+  auto byteSize = bitmap->info().byteSize();
+  if (writeQueueSize + byteSize > maxWriteQueueSize) {
+    // The frame can be rendered again later, so dropping it is not a failure.
+    droppedWriteCount++;
+    return true;
+  }
+  auto pixels = std::make_shared<tgfx::Buffer>(byteSize);
+  if (pixels->isEmpty()) {
+    return false;
+  }
+  auto srcPixels = bitmap->lockPixels();
+  if (srcPixels == nullptr) {
+    return false;
+  }
+  memcpy(pixels->bytes(), srcPixels, byteSize);
+  bitmap->unlockPixels();
+  auto timeRange = GetTimeRangeContains(sequenceFile->staticTimeRanges(), index);
+  pendingFrames.push_back(std::make_shared<PendingFrame>(
+      std::move(sequenceFile), static_cast<int>(timeRange.start), pixels));
+  writeQueueSize += byteSize;
+  if (!writeTaskRunning) {
+    writeTaskRunning = true;
+    tgfx::Task::Run([this]() { processWriteQueue(); });
+  }
+  return true;
+}
+
+bool DiskCache::readPendingFrame(SequenceFile* sequenceFile, int index,
+                                 std::shared_ptr<BitmapBuffer> bitmap) {
+  std::lock_guard<std::mutex> autoLock(writeLocker);
+  auto timeRange = GetTimeRangeContains(sequenceFile->staticTimeRanges(), index);
+  for (auto& frame : pendingFrames) {
+    if (frame->sequenceFile.get() != sequenceFile || frame->index != timeRange.start) {
+      continue;
+    }
+    auto pixels = bitmap->lockPixels();
+    if (pixels == nullptr) {
+      return false;
+    }
+    memcpy(pixels, frame->pixels->bytes(), frame->pixels->size());
+    bitmap->unlockPixels();
+    return true;
+  }
+  return false;
+}
+
+void DiskCache::processWriteQueue() {
+  while (true) {
+    std::shared_ptr<PendingFrame> frame = nullptr;
+    {
+      std::lock_guard<std::mutex> autoLock(writeLocker);
+      if (pendingFrames.empty()) {
+        writeTaskRunning = false;
+        return;
+      }
+      // Keeps the frame in the queue until it is written, so that it is still readable.
+      frame = pendingFrames.front();
+    }
+    auto bitmap = BitmapBuffer::Wrap(frame->sequenceFile->info(), frame->pixels->bytes());
+    frame->sequenceFile->writeFrame(frame->index, bitmap);
+    std::lock_guard<std::mutex> autoLock(writeLocker);
+    pendingFrames.pop_front();
+    writeQueueSize -= frame->pixels->size();
+  }
+}
+
+void DiskCache::prefetch(std::shared_ptr<PrefetchRequest> request) {
+  std::lock_guard<std::mutex> autoLock(prefetchLocker);
+  if (cacheFolder.empty()) {
+    return;
+  }
+  for (auto& item : prefetchRequests) {
+    if (item->key == request->key) {
+      return;
+    }
+  }
+  auto position = prefetchRequests.begin();
+  while (position != prefetchRequests.end() && (*position)->priority >= request->priority) {
+    position++;
+  }
+  prefetchRequests.insert(position, request);
+  if (!prefetchTaskRunning) {
+    prefetchTaskRunning = true;
+    tgfx::Task::Run([this]() { processPrefetchQueue(); });
+  }
+}
+
+void DiskCache::processPrefetchQueue() {
+  while (true) {
+    std::shared_ptr<PrefetchRequest> request = nullptr;
+    {
+      std::lock_guard<std::mutex> autoLock(prefetchLocker);
+      if (prefetchRequests.empty()) {
+        prefetchTaskRunning = false;
+        return;
+      }
+      request = prefetchRequests.front();
+      prefetchRequests.pop_front();
+    }
+    auto sequenceFile = openSequence(request->key, request->info, request->frameCount,
+                                     request->frameRate, request->staticTimeRanges);
+    if (sequenceFile == nullptr) {
+      continue;
+    }
+    preloadFrames(sequenceFile.get(), request->preloadFrames);
+    // Files released here may be closed, which requires no lock of the disk cache to be held.
+    std::vector<std::shared_ptr<SequenceFile>> releasedFiles = {};
+    std::lock_guard<std::mutex> autoLock(prefetchLocker);
+    for (auto item = prefetchedFiles.begin(); item != prefetchedFiles.end(); item++) {
+      if (item->first == request->key) {
+        releasedFiles.push_back(item->second);
+        prefetchedFiles.erase(item);
+        break;
+      }
+    }
+    prefetchedFiles.emplace_back(request->key, sequenceFile);
+    if (prefetchedFiles.size() > MAX_PREFETCHED_FILES) {
+      releasedFiles.push_back(prefetchedFiles.front().second);
+      prefetchedFiles.pop_front();
+    }
+  }
+}
+
+void DiskCache::preloadFrames(SequenceFile* sequenceFile, int count) {
+  auto info = sequenceFile->info();
+  auto byteSize = info.byteSize();
+  if (byteSize == 0) {
+    return;
+  }
+  // The preloaded frames are held by the memory cache, so they count against its limit and are
+  // evicted like other frames. Preloading more than the limit would only evict the first ones.
+  auto maxCount = memoryCache.maxMemorySize() / byteSize;
+  count = static_cast<int>(std::min(static_cast<size_t>(std::max(count, 0)), maxCount));
+  count = std::min(count, static_cast<int>(sequenceFile->numFrames()));
+  if (count == 0) {
+    return;
+  }
+  tgfx::Buffer buffer(byteSize);
+  if (buffer.isEmpty()) {
     return;
   }
-  maxDiskSize = size;
-  if (checkDiskSpace(maxDiskSize)) {
-    saveConfig();
+  auto bitmap = BitmapBuffer::Wrap(info, buffer.data());
+  for (int i = 0; i < count; i++) {
+    auto timeRange = GetTimeRangeContains(sequenceFile->staticTimeRanges(), i);
+    if (timeRange.start < i || memoryCache.hasFrame(sequenceFile->fileID, i)) {
+      // Frames in the same static time range share the pixels of the first one.
+      continue;
+    }
+    // Stops at the first frame that is not cached yet.
+    if (!sequenceFile->readFrame(i, bitmap)) {
+      break;
+    }
+    memoryCache.writeFrame(sequenceFile->fileID, i, bitmap);
+  }
+}
+
+void DiskCache::releasePrefetchedFile(const std::string& key) {
+  std::shared_ptr<SequenceFile> sequenceFile = nullptr;
+  std::lock_guard<std::mutex> autoLock(prefetchLocker);
+  for (auto item = prefetchedFiles.begin(); item != prefetchedFiles.end(); item++) {
+    if (item->first == key) {
+      sequenceFile = item->second;
+      prefetchedFiles.erase(item);
+      break;
+    }
   }
 }
 
 void DiskCache::removeAll() {
-  std::lock_guard<std::mutex> autoLock(locker);
   if (cacheFolder.empty()) {
     return;
   }
-  Directory::VisitFiles(cacheFolder, [&](const std::string& path, size_t) {
-    auto fileID = filePathToID(path);
-    if (openedFiles.count(fileID) > 0) {
-      return;
+  {
+    std::list<std::pair<std::string, std::shared_ptr<SequenceFile>>> releasedFiles = {};
+    std::lock_guard<std::mutex> autoLock(prefetchLocker);
+    prefetchRequests.clear();
+    releasedFiles.swap(prefetchedFiles);
+  }
+  memoryCache.removeAll();
+  {
+    // The opened files are checked under the same locker that openSequence() marks them with.
+    std::lock_guard<std::mutex> autoLock(locker);
+    Directory::VisitFiles(cacheFolder, [&](const std::string& path, size_t) {
+      auto fileID = filePathToID(path);
+      if (openedFileIDs.count(fileID) > 0) {
+        return;
+      }
+      remove(path.c_str());
+    });
+    for (auto& shard : keyShards) {
+      std::lock_guard<std::mutex> shardLock(shard.locker);
+      shard.fileIDs.clear();
     }
-    remove(path.c_str());
-  });
-  cachedFileIDs.clear();
-  cachedFiles.clear();
-  cachedFileInfos.clear();
-  totalDiskSize = 0;
-  saveConfig();
+    cachedFiles.clear();
+    cachedFileInfos.clear();
+    totalDiskSize = 0;
+  }
+  flushConfig(true);
   LOGI("DiskCache::removeAll() all cached files have been removed!");
 }
 
 std::shared_ptr<SequenceFile> DiskCache::openSequence(
     const std::string& key, const tgfx::ImageInfo& info, int frameCount, float frameRate,
     const std::vector<TimeRange>& staticTimeRanges) {
-  std::lock_guard<std::mutex> autoLock(locker);
   if (cacheFolder.empty()) {
     return nullptr;
   }
   auto fileID = getFileID(key);
-  auto result = openedFiles.find(fileID);
-  if (result != openedFiles.end()) {
+  auto shard = getOpenedShard(fileID);
+  std::unique_lock<std::mutex> shardLock(shard->locker);
+  auto result = shard->files.find(fileID);
+  if (result != shard->files.end()) {
     auto sequenceFile = result->second.lock();
     if (sequenceFile != nullptr) {
       if (sequenceFile->compatible(info, frameCount, frameRate, staticTimeRanges)) {
-        moveToFront(cachedFileInfos[fileID]);
         return sequenceFile;
       }
       changeToTemporary(fileID);
-      fileID = getFileID(key);
+      shardLock.unlock();
+      // The key has been detached from the opened file, so it maps to a new file ID now.
+      return openSequence(key, info, frameCount, frameRate, staticTimeRanges);
+    }
+  }
+  std::shared_ptr<FileInfo> fileInfo = nullptr;
+  auto mode = PAGCompressionMode::LZ4;
+  bool needsFlush = false;
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    mode = compressionMode;
+    openedFileIDs.insert(fileID);
+    if (!key.empty()) {
+      // Marks the file as opened before touching it on disk, so it can not be evicted meanwhile.
+      fileInfo = openFileInfo(key, fileID);
+      needsFlush = pendingConfigCount >= MAX_PENDING_CONFIG_RECORDS;
     }
   }
+  if (needsFlush) {
+    flushConfig();
+  }
   auto filePath = fileIDToPath(fileID);
-  auto sequenceFile = SequenceFile::Open(filePath, info, frameCount, frameRate, staticTimeRanges);
+  auto sequenceFile =
+      SequenceFile::Open(filePath, info, frameCount, frameRate, staticTimeRanges, mode);
   if (sequenceFile == nullptr) {
+    std::lock_guard<std::mutex> autoLock(locker);
+    openedFileIDs.erase(fileID);
+    if (fileInfo != nullptr) {
+      closeFileInfo(fileInfo);
+    }
     return nullptr;
   }
   sequenceFile->diskCache = this;
   sequenceFile->fileID = fileID;
-  openedFiles[fileID] = sequenceFile;
-  if (!key.empty()) {
-    auto oldFileInfo = cachedFileInfos[fileID];
-    if (oldFileInfo) {
-      auto fileSize = sequenceFile->fileSize();
-      totalDiskSize += fileSize - oldFileInfo->fileSize;
-      oldFileInfo->fileSize = fileSize;
-      moveToFront(oldFileInfo);
-    } else {
-      addToCachedFiles(std::make_shared<FileInfo>(key, fileID, 0));
-      saveConfig();
+  shard->files[fileID] = sequenceFile;
+  if (fileInfo != nullptr) {
+    auto fileSize = sequenceFile->fileSize();
+    std::lock_guard<std::mutex> autoLock(locker);
+    auto infoResult = cachedFileInfos.find(fileID);
+    if (infoResult != cachedFileInfos.end() && infoResult->second == fileInfo) {
+      totalDiskSize += fileSize - fileInfo->fileSize;
+      fileInfo->fileSize = fileSize;
     }
   }
   return sequenceFile;
 }
 
 std::shared_ptr<tgfx::Data> DiskCache::readFile(const std::string& key) {
-  std::lock_guard<std::mutex> autoLock(locker);
   if (cacheFolder.empty() || key.empty()) {
     return nullptr;
   }
@@ -179,18 +558,23 @@ std::shared_ptr<tgfx::Data> DiskCache::readFile(const std::string& key) {
 }
 
 bool DiskCache::writeFile(const std::string& key, std::shared_ptr<tgfx::Data> data) {
-  std::lock_guard<std::mutex> autoLock(locker);
   if (cacheFolder.empty() || key.empty() || data == nullptr) {
     return false;
   }
-  auto changed = checkDiskSpace(maxDiskSize - data->size());
+  auto fileID = getFileID(key);
+  auto success = saveFile(key, fileID, std::move(data));
+  // The records are written even if the write fails, since it may have evicted other files.
+  flushConfig();
+  return success;
+}
+
+bool DiskCache::saveFile(const std::string& key, uint32_t fileID,
+                                std::shared_ptr<tgfx::Data> data) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  checkDiskSpace(maxDiskSize - data->size());
   if (totalDiskSize + data->size() > maxDiskSize) {
-    if (changed) {
-      saveConfig();
-    }
     return false;
   }
-  auto fileID = getFileID(key);
   auto filePath = fileIDToPath(fileID);
   Directory::CreateRecursively(Directory::GetParentDirectory(filePath));
   auto file = fopen(filePath.c_str(), "wb");
@@ -203,50 +587,49 @@ bool DiskCache::writeFile(const std::string& key, std::shared_ptr<tgfx::Data> da
     return false;
   }
   totalDiskSize += data->size();
-  auto fileInfo = cachedFileInfos[fileID];
-  if (fileInfo) {
+  auto result = cachedFileInfos.find(fileID);
+  if (result != cachedFileInfos.end()) {
+    auto fileInfo = result->second;
     totalDiskSize -= fileInfo->fileSize;
     fileInfo->fileSize = data->size();
+    if (!fileInfo->opened) {
+      moveToFront(fileInfo);
+    }
   } else {
     addToCachedFiles(std::make_shared<FileInfo>(key, fileID, data->size()));
-    fileInfo = cachedFileInfos[fileID];
-    changed = true;
-  }
-  moveToBeforeOpenedFiles(fileInfo);
-  if (changed) {
-    saveConfig();
   }
+  appendConfig(fileID, &key);
   return true;
 }
 
-bool DiskCache::checkDiskSpace(size_t maxSize) {
-  bool changed = false;
+void DiskCache::checkDiskSpace(size_t maxSize) {
   if (totalDiskSize <= maxSize) {
-    return changed;
+    return;
   }
   LOGE("Cached data exceeds threshold, current threshold is:%lld !!! \n", maxSize);
-  while (totalDiskSize > maxSize) {
+  // Opened files are not in the LRU list, so every file at the back can be evicted directly.
+  while (totalDiskSize > maxSize && !cachedFiles.empty()) {
     auto fileInfo = cachedFiles.back();
-    if (openedFiles.count(fileInfo->fileID) > 0) {
-      break;
-    }
     auto filePath = fileIDToPath(fileInfo->fileID);
     remove(filePath.c_str());
     totalDiskSize -= fileInfo->fileSize;
     removeFromCachedFiles(fileInfo);
-    changed = true;
+    appendConfig(fileInfo->fileID, nullptr);
   }
-  return changed;
 }
 
 void DiskCache::addToCachedFiles(std::shared_ptr<FileInfo> fileInfo) {
-  cachedFiles.push_front(fileInfo);
-  fileInfo->cachedPosition = cachedFiles.begin();
+  if (!fileInfo->opened) {
+    cachedFiles.push_front(fileInfo);
+    fileInfo->cachedPosition = cachedFiles.begin();
+  }
   cachedFileInfos[fileInfo->fileID] = fileInfo;
 }
 
 void DiskCache::removeFromCachedFiles(std::shared_ptr<FileInfo> fileInfo) {
-  cachedFiles.erase(fileInfo->cachedPosition);
+  if (!fileInfo->opened) {
+    cachedFiles.erase(fileInfo->cachedPosition);
+  }
   cachedFileInfos.erase(fileInfo->fileID);
 }
 
@@ -256,19 +639,34 @@ void DiskCache::moveToFront(std::shared_ptr<FileInfo> fileInfo) {
   fileInfo->cachedPosition = cachedFiles.begin();
 }
 
-void DiskCache::moveToBeforeOpenedFiles(std::shared_ptr<FileInfo> fileInfo) {
-  cachedFiles.erase(fileInfo->cachedPosition);
-  for (auto it = cachedFiles.begin(); it != cachedFiles.end(); ++it) {
-    if (openedFiles.count((*it)->fileID) == 0) {
-      fileInfo->cachedPosition = cachedFiles.insert(it, fileInfo);
-      fileInfo = nullptr;
-      break;
+std::shared_ptr<FileInfo> DiskCache::openFileInfo(const std::string& key, uint32_t fileID) {
+  auto result = cachedFileInfos.find(fileID);
+  std::shared_ptr<FileInfo> fileInfo = nullptr;
+  if (result != cachedFileInfos.end()) {
+    fileInfo = result->second;
+    if (!fileInfo->opened) {
+      cachedFiles.erase(fileInfo->cachedPosition);
+      fileInfo->opened = true;
     }
+  } else {
+    fileInfo = std::make_shared<FileInfo>(key, fileID, 0);
+    fileInfo->opened = true;
+    addToCachedFiles(fileInfo);
+  }
+  // Records the access in the journal, so the LRU order survives restarts. The record is only
+  // queued in memory, it is written together with others when a file is closed.
+  appendConfig(fileID, &fileInfo->cacheKey);
+  return fileInfo;
+}
+
+void DiskCache::closeFileInfo(std::shared_ptr<FileInfo> fileInfo) {
+  if (!fileInfo->opened) {
+    return;
   }
-  if (fileInfo) {
-    cachedFiles.push_back(fileInfo);
-    fileInfo->cachedPosition = --cachedFiles.end();
-  }
+  fileInfo->opened = false;
+  cachedFiles.push_front(fileInfo);
+  fileInfo->cachedPosition = cachedFiles.begin();
+  checkDiskSpace(maxDiskSize);
 }
 
 bool DiskCache::readConfig() {
@@ -287,19 +685,37 @@ bool DiskCache::readConfig() {
   auto length = fread(buffer.data(), 1, size, file);
   fclose(file);
   tgfx::DataView dataView(buffer.bytes(), length);
+  // The config is a journal of records, each record is either [fileID][keyLength][key] which adds
+  // or touches a file, or [fileID][REMOVED_RECORD_FLAG] which removes a file. Replaying them in
+  // order restores both the cached files and their LRU order.
   size_t pos = 0;
-  while (pos + 8 < dataView.size()) {
+  while (pos + 8 <= dataView.size()) {
     auto fileID = dataView.getUint32(pos);
     auto keyLength = dataView.getUint32(pos + 4);
     pos += 8;
+    fileIDCount = std::max(fileIDCount.load(), fileID + 1);
+    if (keyLength == REMOVED_RECORD_FLAG) {
+      journalRecordCount++;
+      auto result = cachedFileInfos.find(fileID);
+      if (result != cachedFileInfos.end()) {
+        removeFileID(result->second->cacheKey);
+        removeFromCachedFiles(result->second);
+      }
+      continue;
+    }
     if (pos + keyLength > dataView.size()) {
       break;
     }
+    journalRecordCount++;
     auto cacheKey = std::string(reinterpret_cast<const char*>(dataView.bytes()) + pos, keyLength);
     pos += keyLength;
-    fileIDCount = std::max(fileIDCount, fileID + 1);
-    addToCachedFiles(std::make_shared<FileInfo>(cacheKey, fileID, 0));
-    cachedFileIDs[cacheKey] = fileID;
+    auto result = cachedFileInfos.find(fileID);
+    if (result != cachedFileInfos.end()) {
+      moveToFront(result->second);
+    } else {
+      addToCachedFiles(std::make_shared<FileInfo>(cacheKey, fileID, 0));
+    }
+    getKeyShard(cacheKey)->fileIDs[cacheKey] = fileID;
   }
   Directory::VisitFiles(cacheFolder, [&](const std::string& path, size_t fileSize) {
     auto fileID = filePathToID(path);
@@ -320,28 +736,29 @@ bool DiskCache::readConfig() {
   }
   for (auto& item : expiredFiles) {
     removeFromCachedFiles(item);
+    appendConfig(item->fileID, nullptr);
   }
-  if (checkDiskSpace(maxDiskSize) || !expiredFiles.empty()) {
-    saveConfig();
-  }
+  checkDiskSpace(maxDiskSize);
   return true;
 }
 
-void DiskCache::saveConfig() {
-  Directory::CreateRecursively(Directory::GetParentDirectory(configPath));
-  auto file = fopen(configPath.c_str(), "wb");
-  if (file == nullptr) {
-    return;
+std::shared_ptr<tgfx::Data> DiskCache::makeConfigData() {
+  // Writes the files from the least recently used to the most recently used, the opened files are
+  // treated as the most recently used ones.
+  std::vector<std::shared_ptr<FileInfo>> fileInfos(cachedFiles.rbegin(), cachedFiles.rend());
+  for (auto& item : cachedFileInfos) {
+    if (item.second->opened) {
+      fileInfos.push_back(item.second);
+    }
   }
   size_t bufferSize = 0;
-  for (auto& item : cachedFiles) {
+  for (auto& item : fileInfos) {
     bufferSize += 8 + item->cacheKey.size();
   }
   tgfx::Buffer buffer(bufferSize);
   tgfx::DataView dataView(buffer.bytes(), buffer.size());
   size_t pos = 0;
-  for (auto item = cachedFiles.rbegin(); item != cachedFiles.rend(); item++) {
-    auto& fileInfo = *item;
+  for (auto& fileInfo : fileInfos) {
     auto& cacheKey = fileInfo->cacheKey;
     dataView.setUint32(pos, fileInfo->fileID);
     dataView.setUint32(pos + 4, static_cast<uint32_t>(cacheKey.size()));
@@ -349,33 +766,106 @@ void DiskCache::saveConfig() {
     memcpy(dataView.writableBytes() + pos, cacheKey.data(), cacheKey.size());
     pos += cacheKey.size();
   }
-  fwrite(buffer.data(), 1, bufferSize, file);
+  journalRecordCount = fileInfos.size();
+  return buffer.release();
+}
+
+void DiskCache::appendConfig(uint32_t fileID, const std::string* cacheKey) {
+  auto keyLength = cacheKey ? cacheKey->size() : 0;
+  auto pos = pendingConfig.size();
+  pendingConfig.resize(pos + 8 + keyLength);
+  tgfx::DataView dataView(pendingConfig.data() + pos, 8 + keyLength);
+  dataView.setUint32(0, fileID);
+  dataView.setUint32(4, cacheKey ? static_cast<uint32_t>(keyLength) : REMOVED_RECORD_FLAG);
+  if (keyLength > 0) {
+    memcpy(dataView.writableBytes() + 8, cacheKey->data(), keyLength);
+  }
+  pendingConfigCount++;
+  journalRecordCount++;
+}
+
+void DiskCache::flushConfig(bool compact) {
+  if (configPath.empty()) {
+    return;
+  }
+  // Holding the config locker while taking the records keeps the batches in the journal in the
+  // same order as they were queued, and the file is written without blocking the locker.
+  std::lock_guard<std::mutex> configLock(configLocker);
+  std::shared_ptr<tgfx::Data> configData = nullptr;
+  std::vector<uint8_t> records = {};
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    if (compact ||
+        journalRecordCount >= cachedFileInfos.size() * 2 + JOURNAL_COMPACTION_THRESHOLD) {
+      // The state already includes the pending records, so they are dropped.
+      configData = makeConfigData();
+      compact = true;
+    } else {
+      records.swap(pendingConfig);
+    }
+    pendingConfig.clear();
+    pendingConfigCount = 0;
+  }
+  if (!compact && records.empty()) {
+    return;
+  }
+  auto mode = compact ? "wb" : "ab";
+  auto file = fopen(configPath.c_str(), mode);
+  if (file == nullptr) {
+    Directory::CreateRecursively(Directory::GetParentDirectory(configPath));
+    file = fopen(configPath.c_str(), mode);
+    if (file == nullptr) {
+      return;
+    }
+  }
+  if (compact) {
+    fwrite(configData->data(), 1, configData->size(), file);
+  } else {
+    fwrite(records.data(), 1, records.size(), file);
+  }
   fclose(file);
 }
 
+KeyIndexShard* DiskCache::getKeyShard(const std::string& key) {
+  return &keyShards[std::hash<std::string>{}(key) % INDEX_SHARD_COUNT];
+}
+
+OpenedFileShard* DiskCache::getOpenedShard(uint32_t fileID) {
+  return &openedShards[fileID % INDEX_SHARD_COUNT];
+}
+
 uint32_t DiskCache::getFileID(const std::string& key) {
   if (key.empty()) {
     return fileIDCount++;
   }
-  auto result = cachedFileIDs.find(key);
-  if (result != cachedFileIDs.end()) {
+  auto shard = getKeyShard(key);
+  std::lock_guard<std::mutex> shardLock(shard->locker);
+  auto result = shard->fileIDs.find(key);
+  if (result != shard->fileIDs.end()) {
     return result->second;
   }
   auto newFileID = fileIDCount++;
-  cachedFileIDs[key] = newFileID;
+  shard->fileIDs[key] = newFileID;
   return newFileID;
 }
 
+void DiskCache::removeFileID(const std::string& key) {
+  auto shard = getKeyShard(key);
+  std::lock_guard<std::mutex> shardLock(shard->locker);
+  shard->fileIDs.erase(key);
+}
+
 void DiskCache::changeToTemporary(uint32_t fileID) {
+  std::lock_guard<std::mutex> autoLock(locker);
   auto result = cachedFileInfos.find(fileID);
   if (result == cachedFileInfos.end()) {
     return;
   }
   auto fileInfo = result->second;
-  cachedFiles.erase(fileInfo->cachedPosition);
-  cachedFileInfos.erase(fileID);
+  removeFromCachedFiles(fileInfo);
   totalDiskSize -= fileInfo->fileSize;
-  cachedFileIDs.erase(fileInfo->cacheKey);
+  removeFileID(fileInfo->cacheKey);
+  appendConfig(fileID, nullptr);
 }
 
 std::string DiskCache::fileIDToPath(uint32_t fileID) {
@@ -391,31 +881,47 @@ uint32_t DiskCache::filePathToID(const std::string& path) {
 }
 
 void DiskCache::notifyFileClosed(uint32_t fileID) {
-  std::lock_guard<std::mutex> autoLock(locker);
-  openedFiles.erase(fileID);
-  auto result = cachedFileInfos.find(fileID);
-  if (result == cachedFileInfos.end()) {
-    auto filePath = fileIDToPath(fileID);
-    remove(filePath.c_str());
-  } else {
-    auto fileInfo = result->second;
-    moveToBeforeOpenedFiles(fileInfo);
-    if (checkDiskSpace(maxDiskSize)) {
-      saveConfig();
+  auto shard = getOpenedShard(fileID);
+  std::unique_lock<std::mutex> shardLock(shard->locker);
+  auto result = shard->files.find(fileID);
+  if (result != shard->files.end()) {
+    if (!result->second.expired()) {
+      // The file has been opened again by another sequence file.
+      return;
+    }
+    shard->files.erase(result);
+  }
+  memoryCache.removeFrames(fileID);
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    openedFileIDs.erase(fileID);
+    auto infoResult = cachedFileInfos.find(fileID);
+    if (infoResult == cachedFileInfos.end()) {
+      auto filePath = fileIDToPath(fileID);
+      remove(filePath.c_str());
+    } else {
+      closeFileInfo(infoResult->second);
     }
   }
+  shardLock.unlock();
+  flushConfig();
 }
 
 void DiskCache::notifyFileSizeChanged(uint32_t fileID, size_t fileSize) {
-  std::lock_guard<std::mutex> autoLock(locker);
-  auto result = cachedFileInfos.find(fileID);
-  if (result != cachedFileInfos.end()) {
-    totalDiskSize += fileSize - result->second->fileSize;
-    result->second->fileSize = fileSize;
-    if (checkDiskSpace(maxDiskSize)) {
-      saveConfig();
+  bool needsFlush = false;
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    auto result = cachedFileInfos.find(fileID);
+    if (result != cachedFileInfos.end()) {
+      totalDiskSize += fileSize - result->second->fileSize;
+      result->second->fileSize = fileSize;
+      checkDiskSpace(maxDiskSize);
+      needsFlush = pendingConfigCount >= MAX_PENDING_CONFIG_RECORDS;
     }
   }
+  if (needsFlush) {
+    flushConfig();
+  }
 }
 
 }  // namespace pag
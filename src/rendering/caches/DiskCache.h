@@ -18,13 +18,37 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
+#include "MemoryFrameCache.h"
 #include "SequenceFile.h"
 #include "pag/types.h"
 
 namespace pag {
 class FileInfo;
+class PendingFrame;
+class PrefetchRequest;
+
+/**
+ * The number of lock stripes used by the disk cache index. Lookups for different keys or files
+ * land on different stripes most of the time, so they rarely wait for each other.
+ */
+static constexpr size_t INDEX_SHARD_COUNT = 16;
+
+class KeyIndexShard {
+ public:
+  std::mutex locker = {};
+  std::unordered_map<std::string, uint32_t> fileIDs = {};
+};
+
+class OpenedFileShard {
+ public:
+  std::mutex locker = {};
+  std::unordered_map<uint32_t, std::weak_ptr<SequenceFile>> files = {};
+};
 
 class DiskCache {
  public:
@@ -49,17 +73,81 @@ class DiskCache {
    */
   static bool WriteFile(const std::string& key, std::shared_ptr<tgfx::Data> data);
 
+  /**
+   * Reads an image frame of the specified sequence file. The frame is served from memory if it is
+   * held by the memory cache, otherwise it is read from the disk and then kept in the memory cache.
+   */
+  static bool ReadFrame(std::shared_ptr<SequenceFile> sequenceFile, int index,
+                        std::shared_ptr<BitmapBuffer> bitmap);
+
+  /**
+   * Writes an image frame into the specified sequence file. If the write queue is enabled, the
+   * pixels are copied and written on a background thread, and the frame is dropped without failing
+   * if the queue is full. Otherwise, the frame is written synchronously.
+   */
+  static bool WriteFrame(std::shared_ptr<SequenceFile> sequenceFile, int index,
+                         std::shared_ptr<BitmapBuffer> bitmap);
+
+  /**
+   * Opens the sequence file of the specified key on a background thread and decompresses its first
+   * preloadFrames frames into the memory cache. The prefetched file is kept opened until the next
+   * OpenSequence() call with the same key takes it over. Requests with a higher priority are
+   * processed first.
+   */
+  static void Prefetch(const std::string& key, const tgfx::ImageInfo& info, int frameCount,
+                       float frameRate, const std::vector<TimeRange>& staticTimeRanges,
+                       int preloadFrames, int priority);
+
  private:
+  /**
+   * Serializes writes to the config file. It is acquired before the locker, and the file is
+   * written after the locker is released.
+   */
+  std::mutex configLocker = {};
+  /**
+   * Guards the file infos, the LRU list, the disk usage and the pending config records. The key
+   * index and the opened files are guarded by their own striped locks. To avoid deadlocks, the
+   * locks are always acquired in the order: opened file shard, config locker, locker, key index
+   * shard.
+   */
   std::mutex locker = {};
   std::string configPath;
   std::string cacheFolder;
-  uint32_t fileIDCount = 1;
+  std::atomic<uint32_t> fileIDCount = {1};
   size_t totalDiskSize = 0;
   size_t maxDiskSize = 1073741824;  // 1 GB
-  std::unordered_map<std::string, uint32_t> cachedFileIDs = {};
+  PAGCompressionMode compressionMode = PAGCompressionMode::LZ4;
+  size_t journalRecordCount = 0;
+  /**
+   * The journal records which have not been written to the config file yet.
+   */
+  std::vector<uint8_t> pendingConfig = {};
+  size_t pendingConfigCount = 0;
   std::unordered_map<uint32_t, std::shared_ptr<FileInfo>> cachedFileInfos = {};
+  /**
+   * The closed files ordered from the most recently used to the least recently used. Opened files
+   * can not be evicted, so they are kept out of this list until they are closed.
+   */
   std::list<std::shared_ptr<FileInfo>> cachedFiles = {};
-  std::unordered_map<uint32_t, std::weak_ptr<SequenceFile>> openedFiles = {};
+  /**
+   * The IDs of the files being opened or still opened, including the temporary ones. A file is
+   * added before it is touched on disk, so removeAll() never removes a file in the middle of being
+   * opened.
+   */
+  std::unordered_set<uint32_t> openedFileIDs = {};
+  KeyIndexShard keyShards[INDEX_SHARD_COUNT] = {};
+  OpenedFileShard openedShards[INDEX_SHARD_COUNT] = {};
+  std::mutex writeLocker = {};
+  size_t maxWriteQueueSize = 0;
+  size_t writeQueueSize = 0;
+  size_t droppedWriteCount = 0;
+  bool writeTaskRunning = false;
+  std::deque<std::shared_ptr<PendingFrame>> pendingFrames = {};
+  MemoryFrameCache memoryCache = {};
+  std::mutex prefetchLocker = {};
+  bool prefetchTaskRunning = false;
+  std::list<std::shared_ptr<PrefetchRequest>> prefetchRequests = {};
+  std::list<std::pair<std::string, std::shared_ptr<SequenceFile>>> prefetchedFiles = {};
 
   static DiskCache* GetInstance();
 
@@ -67,21 +155,43 @@ class DiskCache {
 
   size_t getMaxDiskSize();
   void setMaxDiskSize(size_t size);
+  PAGCompressionMode getCompressionMode();
+  void setCompressionMode(PAGCompressionMode mode);
   void removeAll();
   std::shared_ptr<SequenceFile> openSequence(const std::string& key, const tgfx::ImageInfo& info,
                                              int frameCount, float frameRate,
                                              const std::vector<TimeRange>& staticTimeRanges);
   std::shared_ptr<tgfx::Data> readFile(const std::string& key);
   bool writeFile(const std::string& key, std::shared_ptr<tgfx::Data> data);
+  bool saveFile(const std::string& key, uint32_t fileID, std::shared_ptr<tgfx::Data> data);
+  size_t getMaxWriteQueueSize();
+  void setMaxWriteQueueSize(size_t size);
+  size_t getWriteQueueDepth();
+  size_t getDroppedWriteCount();
+  bool writeFrame(std::shared_ptr<SequenceFile> sequenceFile, int index,
+                  std::shared_ptr<BitmapBuffer> bitmap);
+  bool readPendingFrame(SequenceFile* sequenceFile, int index,
+                        std::shared_ptr<BitmapBuffer> bitmap);
+  void processWriteQueue();
+  void prefetch(std::shared_ptr<PrefetchRequest> request);
+  void processPrefetchQueue();
+  void preloadFrames(SequenceFile* sequenceFile, int count);
+  void releasePrefetchedFile(const std::string& key);
 
-  bool checkDiskSpace(size_t maxSize);
+  void checkDiskSpace(size_t maxSize);
   void addToCachedFiles(std::shared_ptr<FileInfo> fileInfo);
   void removeFromCachedFiles(std::shared_ptr<FileInfo> fileInfo);
   void moveToFront(std::shared_ptr<FileInfo> fileInfo);
-  void moveToBeforeOpenedFiles(std::shared_ptr<FileInfo> fileInfo);
+  std::shared_ptr<FileInfo> openFileInfo(const std::string& key, uint32_t fileID);
+  void closeFileInfo(std::shared_ptr<FileInfo> fileInfo);
   bool readConfig();
-  void saveConfig();
+  std::shared_ptr<tgfx::Data> makeConfigData();
+  void appendConfig(uint32_t fileID, const std::string* cacheKey);
+  void flushConfig(bool compact = false);
+  KeyIndexShard* getKeyShard(const std::string& key);
+  OpenedFileShard* getOpenedShard(uint32_t fileID);
   uint32_t getFileID(const std::string& key);
+  void removeFileID(const std::string& key);
   void changeToTemporary(uint32_t fileID);
   std::string fileIDToPath(uint32_t fileID);
   uint32_t filePathToID(const std::string& path);
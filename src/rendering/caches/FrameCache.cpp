@@ -0,0 +1,92 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCache.h"
+#include <algorithm>
+#include <vector>
+
+namespace pag {
+/**
+ * HitCounter counts the cache hits of one thread. Only the owner thread writes it, so a hit is a
+ * plain store to a cache line no other thread writes.
+ */
+class HitCounter {
+ public:
+  HitCounter();
+
+  ~HitCounter();
+
+  std::atomic_int64_t count = {0};
+};
+
+static std::mutex hitCounterLocker = {};
+static std::vector<HitCounter*> hitCounters = {};
+// The hits counted by the threads that have exited.
+static int64_t exitedHitCount = 0;
+
+HitCounter::HitCounter() {
+  std::lock_guard<std::mutex> autoLock(hitCounterLocker);
+  hitCounters.push_back(this);
+}
+
+HitCounter::~HitCounter() {
+  std::lock_guard<std::mutex> autoLock(hitCounterLocker);
+  exitedHitCount += count.load(std::memory_order_relaxed);
+  hitCounters.erase(std::find(hitCounters.begin(), hitCounters.end(), this));
+}
+
+std::atomic_size_t FrameCacheStats::maxFrameCount = {0};
+std::atomic_int64_t FrameCacheStats::missCount = {0};
+std::atomic_int64_t FrameCacheStats::evictionCount = {0};
+std::atomic_int64_t FrameCacheStats::memoryUsage = {0};
+
+size_t FrameCacheStats::MaxFrameCount() {
+  return maxFrameCount;
+}
+
+void FrameCacheStats::SetMaxFrameCount(size_t count) {
+  maxFrameCount = count;
+}
+
+void FrameCacheStats::RecordHit() {
+  static thread_local HitCounter hitCounter;
+  hitCounter.count.store(hitCounter.count.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+}
+
+int64_t FrameCacheStats::HitCount() {
+  std::lock_guard<std::mutex> autoLock(hitCounterLocker);
+  auto hitCount = exitedHitCount;
+  for (auto counter : hitCounters) {
+    hitCount += counter->count.load(std::memory_order_relaxed);
+  }
+  return hitCount;
+}
+
+int64_t FrameCacheStats::MissCount() {
+  return missCount;
+}
+
+int64_t FrameCacheStats::EvictionCount() {
+  return evictionCount;
+}
+
+int64_t FrameCacheStats::MemoryUsage() {
+  return memoryUsage;
+}
+}  // namespace pag
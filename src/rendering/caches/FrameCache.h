@@ -18,10 +18,65 @@
 
 #pragma once
 
-#include <unordered_map>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "pag/file.h"
 
 namespace pag {
+/**
+ * FrameCacheStats holds the global settings and statistics shared by all frame caches.
+ */
+class FrameCacheStats {
+ public:
+  /**
+   * Returns the maximum number of frames kept by each frame cache. The default value is 0, which
+   * means unlimited.
+   */
+  static size_t MaxFrameCount();
+
+  /**
+   * Sets the maximum number of frames kept by each frame cache. The least recently used frames are
+   * evicted once a cache exceeds it.
+   */
+  static void SetMaxFrameCount(size_t count);
+
+  /**
+   * Returns the number of cache lookups that found an existing frame. The hits are counted per
+   * thread to keep them off a shared cache line, and added up when this method is called.
+   */
+  static int64_t HitCount();
+
+  /**
+   * Returns the number of cache lookups that had to create a new frame.
+   */
+  static int64_t MissCount();
+
+  /**
+   * Returns the number of frames evicted from the caches.
+   */
+  static int64_t EvictionCount();
+
+  /**
+   * Returns the estimated memory usage of all the frames currently cached, in bytes.
+   */
+  static int64_t MemoryUsage();
+
+ private:
+  static void RecordHit();
+
+  static std::atomic_size_t maxFrameCount;
+  static std::atomic_int64_t missCount;
+  static std::atomic_int64_t evictionCount;
+  static std::atomic_int64_t memoryUsage;
+
+  template <typename T>
+  friend class FrameCache;
+};
+
 template <typename T>
 class FrameCache : public Cache {
  public:
@@ -32,15 +87,32 @@ class FrameCache : public Cache {
 
     TimeRange range = {0, duration - 1};
     staticTimeRanges.push_back(range);
+    pageCount = static_cast<size_t>((duration + PAGE_SIZE - 1) / PAGE_SIZE);
+    pages = std::unique_ptr<std::atomic<CachePage*>[]>(new std::atomic<CachePage*>[pageCount]());
   }
 
   ~FrameCache() override {
-    for (auto& item : frames) {
-      delete item.second;
+    for (size_t i = 0; i < pageCount; i++) {
+      auto page = pages[i].load(std::memory_order_relaxed);
+      if (page == nullptr) {
+        continue;
+      }
+      for (auto& slot : page->slots) {
+        auto entry = slot.entry.load(std::memory_order_relaxed);
+        if (entry != nullptr) {
+          FrameCacheStats::memoryUsage -= static_cast<int64_t>(slot.size);
+          delete entry;
+        }
+      }
+      delete page;
     }
   }
 
-  virtual T* getCache(Frame contentFrame) {
+  /**
+   * Returns the cache of the specified frame. The returned cache stays valid as long as the caller
+   * holds it, even if it is evicted by another thread in the meantime.
+   */
+  virtual std::shared_ptr<T> getCache(Frame contentFrame) {
     contentFrame = ConvertFrameByStaticTimeRanges(staticTimeRanges, contentFrame);
     if (contentFrame >= duration) {
       contentFrame = duration - 1;
@@ -48,13 +120,27 @@ class FrameCache : public Cache {
     if (contentFrame < 0) {
       contentFrame = 0;
     }
-    std::lock_guard<std::mutex> autoLock(locker);
-    auto cache = frames[contentFrame];
-    if (cache == nullptr) {
-      cache = createCache(contentFrame + startTime);
-      frames[contentFrame] = cache;
+    // The hits are wait-free: the entries are published with release stores and never modified
+    // afterward, so only the misses and evictions need to take the locker. The reader count of the
+    // slot keeps an evicted entry alive until no reader can still be copying the cache out of it.
+    // It is kept per slot, so the threads hitting different frames never touch the same counter.
+    auto pageIndex = static_cast<size_t>(contentFrame / PAGE_SIZE);
+    auto page = pages[pageIndex].load(std::memory_order_acquire);
+    if (page != nullptr) {
+      auto& slot = page->slots[contentFrame % PAGE_SIZE];
+      slot.readers.fetch_add(1, std::memory_order_seq_cst);
+      auto entry = slot.entry.load(std::memory_order_seq_cst);
+      std::shared_ptr<T> cache = entry != nullptr ? *entry : nullptr;
+      slot.readers.fetch_sub(1, std::memory_order_release);
+      if (cache != nullptr) {
+        if (!slot.referenced.load(std::memory_order_relaxed)) {
+          slot.referenced.store(true, std::memory_order_relaxed);
+        }
+        FrameCacheStats::RecordHit();
+        return cache;
+      }
     }
-    return cache;
+    return createCacheLocked(contentFrame);
   }
 
   const std::vector<TimeRange>* getStaticTimeRanges() const {
@@ -68,8 +154,97 @@ class FrameCache : public Cache {
 
   virtual T* createCache(Frame layerFrame) = 0;
 
+  /**
+   * Returns the estimated memory usage of the specified cache in bytes.
+   */
+  virtual size_t estimateCacheSize(T*) const {
+    return sizeof(T);
+  }
+
  private:
+  static constexpr Frame PAGE_SIZE = 64;
+
+  struct CacheSlot {
+    std::atomic<std::shared_ptr<T>*> entry = {nullptr};
+    // Set when the cache is hit, which gives it a second chance before being evicted.
+    std::atomic_bool referenced = {false};
+    // The number of threads currently copying the cache out of the slot without holding the locker.
+    std::atomic_int readers = {0};
+    size_t size = 0;
+  };
+
+  struct CachePage {
+    CacheSlot slots[PAGE_SIZE];
+  };
+
   std::mutex locker = {};
-  std::unordered_map<Frame, T*> frames;
+  size_t pageCount = 0;
+  std::unique_ptr<std::atomic<CachePage*>[]> pages = nullptr;
+  // The cached frames in the order they were created, which the CLOCK eviction walks through.
+  std::deque<Frame> cachedFrames = {};
+
+  CacheSlot& getSlot(Frame frame) {
+    auto& page = pages[static_cast<size_t>(frame / PAGE_SIZE)];
+    auto pagePointer = page.load(std::memory_order_relaxed);
+    if (pagePointer == nullptr) {
+      pagePointer = new CachePage();
+      page.store(pagePointer, std::memory_order_release);
+    }
+    return pagePointer->slots[frame % PAGE_SIZE];
+  }
+
+  std::shared_ptr<T> createCacheLocked(Frame contentFrame) {
+    std::lock_guard<std::mutex> autoLock(locker);
+    auto& slot = getSlot(contentFrame);
+    auto entry = slot.entry.load(std::memory_order_relaxed);
+    if (entry != nullptr) {
+      FrameCacheStats::RecordHit();
+      return *entry;
+    }
+    FrameCacheStats::missCount++;
+    auto cache = std::shared_ptr<T>(createCache(contentFrame + startTime));
+    slot.size = estimateCacheSize(cache.get());
+    slot.referenced.store(false, std::memory_order_relaxed);
+    slot.entry.store(new std::shared_ptr<T>(cache), std::memory_order_seq_cst);
+    cachedFrames.push_back(contentFrame);
+    FrameCacheStats::memoryUsage += static_cast<int64_t>(slot.size);
+    auto maxCount = FrameCacheStats::MaxFrameCount();
+    if (maxCount > 0 && cachedFrames.size() > maxCount) {
+      evictFrames(maxCount);
+    }
+    return cache;
+  }
+
+  void evictFrames(size_t maxCount) {
+    std::vector<std::pair<CacheSlot*, std::shared_ptr<T>*>> evictedEntries = {};
+    // Each frame gets at most one second chance, so the loop always terminates.
+    auto secondChances = cachedFrames.size();
+    while (cachedFrames.size() > maxCount) {
+      auto frame = cachedFrames.front();
+      cachedFrames.pop_front();
+      auto& slot = getSlot(frame);
+      if (secondChances > 0 && slot.referenced.exchange(false, std::memory_order_relaxed)) {
+        secondChances--;
+        cachedFrames.push_back(frame);
+        continue;
+      }
+      FrameCacheStats::evictionCount++;
+      FrameCacheStats::memoryUsage -= static_cast<int64_t>(slot.size);
+      evictedEntries.emplace_back(&slot, slot.entry.load(std::memory_order_relaxed));
+      slot.entry.store(nullptr, std::memory_order_seq_cst);
+      slot.size = 0;
+    }
+    // The slots are cleared before their reader counts are checked, so a reader that starts after
+    // the check can not find any evicted entry. The readers only copy a shared_ptr out of the slot,
+    // so the wait is short, and the evicted caches are released right away instead of piling up.
+    // Deleting an entry only drops the cache's owner inside the FrameCache, the callers still
+    // holding the cache keep it alive.
+    for (auto& item : evictedEntries) {
+      while (item.first->readers.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+      }
+      delete item.second;
+    }
+  }
 };
 }  // namespace pag
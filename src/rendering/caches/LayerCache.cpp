@@ -82,12 +82,15 @@ LayerCache::~LayerCache() {
   delete featherMaskCache;
 }
 
-Transform* LayerCache::getTransform(Frame contentFrame) {
+std::shared_ptr<Transform> LayerCache::getTransform(Frame contentFrame) {
   return transformCache->getCache(contentFrame);
 }
 
-tgfx::Path* LayerCache::getMasks(Frame contentFrame) {
-  auto mask = maskCache ? maskCache->getCache(contentFrame) : nullptr;
+std::shared_ptr<tgfx::Path> LayerCache::getMasks(Frame contentFrame) {
+  if (maskCache == nullptr) {
+    return nullptr;
+  }
+  auto mask = maskCache->getCache(contentFrame);
   if (mask && mask->isEmpty()) {
     return nullptr;
   }
@@ -102,7 +105,7 @@ std::shared_ptr<Modifier> LayerCache::getFeatherMask(Frame contentFrame) {
   return Modifier::MakeMask(featherMaskContent->graphic, false, false);
 }
 
-Content* LayerCache::getContent(Frame contentFrame) {
+std::shared_ptr<Content> LayerCache::getContent(Frame contentFrame) {
   return contentCache->getCache(contentFrame);
 }
 
@@ -31,13 +31,13 @@ class LayerCache : public Cache {
 
   ~LayerCache() override;
 
-  Transform* getTransform(Frame contentFrame);
+  std::shared_ptr<Transform> getTransform(Frame contentFrame);
 
-  tgfx::Path* getMasks(Frame contentFrame);
+  std::shared_ptr<tgfx::Path> getMasks(Frame contentFrame);
 
   std::shared_ptr<Modifier> getFeatherMask(Frame contentFrame);
 
-  Content* getContent(Frame contentFrame);
+  std::shared_ptr<Content> getContent(Frame contentFrame);
 
   Layer* getLayer() const;
 
@@ -36,6 +36,10 @@ tgfx::Path* MaskCache::createCache(Frame layerFrame) {
   return maskContent;
 }
 
+size_t MaskCache::estimateCacheSize(tgfx::Path* path) const {
+  return sizeof(tgfx::Path) + static_cast<size_t>(path->countPoints()) * sizeof(tgfx::Point);
+}
+
 FeatherMaskCache::FeatherMaskCache(Layer* layer)
     : FrameCache<GraphicContent>(layer->startTime, layer->duration), layer(layer) {
   std::vector<TimeRange> timeRanges = {layer->visibleRange()};
@@ -30,6 +30,8 @@ class MaskCache : public FrameCache<tgfx::Path> {
  protected:
   tgfx::Path* createCache(Frame layerFrame) override;
 
+  size_t estimateCacheSize(tgfx::Path* path) const override;
+
  private:
   Layer* layer = nullptr;
 };
@@ -0,0 +1,141 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "MemoryFrameCache.h"
+#include <cstring>
+
+namespace pag {
+class MemoryFrame {
+ public:
+  MemoryFrame(uint64_t key, std::shared_ptr<tgfx::Buffer> pixels)
+      : key(key), pixels(std::move(pixels)) {
+  }
+
+  uint64_t key = 0;
+  std::shared_ptr<tgfx::Buffer> pixels = nullptr;
+};
+
+static uint64_t MakeFrameKey(uint32_t fileID, int index) {
+  return (static_cast<uint64_t>(fileID) << 32) | static_cast<uint32_t>(index);
+}
+
+size_t MemoryFrameCache::maxMemorySize() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return maxSize;
+}
+
+void MemoryFrameCache::setMaxMemorySize(size_t size) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  maxSize = size;
+  purge(maxSize);
+}
+
+size_t MemoryFrameCache::memoryUsage() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return usedSize;
+}
+
+bool MemoryFrameCache::hasFrame(uint32_t fileID, int index) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return frameMap.count(MakeFrameKey(fileID, index)) > 0;
+}
+
+bool MemoryFrameCache::readFrame(uint32_t fileID, int index, std::shared_ptr<BitmapBuffer> bitmap) {
+  std::shared_ptr<tgfx::Buffer> pixels = nullptr;
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    auto result = frameMap.find(MakeFrameKey(fileID, index));
+    if (result == frameMap.end()) {
+      return false;
+    }
+    frameList.splice(frameList.begin(), frameList, result->second);
+    pixels = (*result->second)->pixels;
+  }
+  // The pixels never change once cached, so they can be copied without holding the lock.
+  if (pixels->size() != bitmap->info().byteSize()) {
+    return false;
+  }
+  auto dstPixels = bitmap->lockPixels();
+  if (dstPixels == nullptr) {
+    return false;
+  }
+  memcpy(dstPixels, pixels->data(), pixels->size());
+  bitmap->unlockPixels();
+  return true;
+}
+
+void MemoryFrameCache::writeFrame(uint32_t fileID, int index,
+                                  std::shared_ptr<BitmapBuffer> bitmap) {
+  auto byteSize = bitmap->info().byteSize();
+  auto key = MakeFrameKey(fileID, index);
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    if (byteSize > maxSize || frameMap.count(key) > 0) {
+      return;
+    }
+  }
+  auto pixels = std::make_shared<tgfx::Buffer>(byteSize);
+  if (pixels->isEmpty()) {
+    return;
+  }
+  auto srcPixels = bitmap->lockPixels();
+  if (srcPixels == nullptr) {
+    return;
+  }
+  memcpy(pixels->data(), srcPixels, byteSize);
+  bitmap->unlockPixels();
+  std::lock_guard<std::mutex> autoLock(locker);
+  if (frameMap.count(key) > 0) {
+    return;
+  }
+  frameList.push_front(std::make_shared<MemoryFrame>(key, pixels));
+  frameMap[key] = frameList.begin();
+  usedSize += byteSize;
+  purge(maxSize);
+}
+
+void MemoryFrameCache::removeFrames(uint32_t fileID) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  for (auto item = frameList.begin(); item != frameList.end();) {
+    auto& frame = *item;
+    if ((frame->key >> 32) != fileID) {
+      item++;
+      continue;
+    }
+    usedSize -= frame->pixels->size();
+    frameMap.erase(frame->key);
+    item = frameList.erase(item);
+  }
+}
+
+void MemoryFrameCache::removeAll() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  frameList.clear();
+  frameMap.clear();
+  usedSize = 0;
+}
+
+void MemoryFrameCache::purge(size_t limit) {
+  while (usedSize > limit && !frameList.empty()) {
+    auto& frame = frameList.back();
+    usedSize -= frame->pixels->size();
+    frameMap.erase(frame->key);
+    frameList.pop_back();
+  }
+}
+}  // namespace pag
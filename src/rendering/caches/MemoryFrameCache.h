@@ -0,0 +1,87 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "rendering/utils/BitmapBuffer.h"
+#include "tgfx/core/Buffer.h"
+
+namespace pag {
+class MemoryFrame;
+
+/**
+ * MemoryFrameCache keeps recently used image frames of sequence files in memory, which is shared by
+ * all decoders and sits in front of the disk cache. Frames are stored decompressed and evicted in
+ * least recently used order once the total size exceeds the memory limit.
+ */
+class MemoryFrameCache {
+ public:
+  /**
+   * Returns the memory limit in bytes. The default value is 0, which disables the cache.
+   */
+  size_t maxMemorySize();
+
+  /**
+   * Sets the memory limit in bytes, the frames exceeding the limit are evicted immediately.
+   */
+  void setMaxMemorySize(size_t size);
+
+  /**
+   * Returns the total size in bytes of the frames currently in memory.
+   */
+  size_t memoryUsage();
+
+  /**
+   * Returns true if the frame of the specified file and index is in memory.
+   */
+  bool hasFrame(uint32_t fileID, int index);
+
+  /**
+   * Copies the frame of the specified file and index into the bitmap. Returns false if the frame is
+   * not in memory.
+   */
+  bool readFrame(uint32_t fileID, int index, std::shared_ptr<BitmapBuffer> bitmap);
+
+  /**
+   * Copies the pixels of the bitmap into memory as the frame of the specified file and index.
+   */
+  void writeFrame(uint32_t fileID, int index, std::shared_ptr<BitmapBuffer> bitmap);
+
+  /**
+   * Removes all frames of the specified file.
+   */
+  void removeFrames(uint32_t fileID);
+
+  /**
+   * Removes all frames.
+   */
+  void removeAll();
+
+ private:
+  std::mutex locker = {};
+  size_t maxSize = 0;
+  size_t usedSize = 0;
+  std::list<std::shared_ptr<MemoryFrame>> frameList = {};
+  std::unordered_map<uint64_t, std::list<std::shared_ptr<MemoryFrame>>::iterator> frameMap = {};
+
+  void purge(size_t limit);
+};
+}  // namespace pag
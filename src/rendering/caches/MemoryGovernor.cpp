@@ -0,0 +1,164 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "MemoryGovernor.h"
+#include "pag/pag.h"
+#include "rendering/caches/RenderCache.h"
+#include "rendering/caches/SharedAssetCache.h"
+
+namespace pag {
+class CacheRecord {
+ public:
+  CacheRecord(RenderCache* cache, std::shared_ptr<std::mutex> locker)
+      : cache(cache), locker(std::move(locker)) {
+  }
+
+  RenderCache* cache = nullptr;
+  std::shared_ptr<std::mutex> locker = nullptr;
+  size_t memoryUsage = 0;
+  bool pressurePending = false;
+  PAGMemoryPressureLevel pressureLevel = PAGMemoryPressureLevel::Moderate;
+};
+
+MemoryGovernor* MemoryGovernor::GetInstance() {
+  static auto& governor = *new MemoryGovernor();
+  return &governor;
+}
+
+size_t MemoryGovernor::maxMemorySize() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return maxSize;
+}
+
+void MemoryGovernor::setMaxMemorySize(size_t size) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  maxSize = size;
+  checkMemoryUsage(nullptr);
+}
+
+size_t MemoryGovernor::memoryUsage() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return usedSize;
+}
+
+void MemoryGovernor::onMemoryPressure(PAGMemoryPressureLevel level) {
+  SharedAssetCache::GetInstance()->removeUnusedAssets();
+  std::lock_guard<std::mutex> autoLock(locker);
+  for (auto& record : cacheList) {
+    if (record->locker->try_lock()) {
+      purgeCache(record.get(), level);
+      record->locker->unlock();
+      continue;
+    }
+    // The cache is busy drawing, it will be purged after the current frame.
+    if (!record->pressurePending || record->pressureLevel < level) {
+      record->pressureLevel = level;
+    }
+    record->pressurePending = true;
+  }
+}
+
+void MemoryGovernor::addCache(RenderCache* cache, std::shared_ptr<std::mutex> cacheLocker) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  cacheList.push_back(std::make_shared<CacheRecord>(cache, std::move(cacheLocker)));
+  cacheMap[cache] = std::prev(cacheList.end());
+}
+
+void MemoryGovernor::removeCache(RenderCache* cache) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  auto result = cacheMap.find(cache);
+  if (result == cacheMap.end()) {
+    return;
+  }
+  usedSize -= (*result->second)->memoryUsage;
+  cacheList.erase(result->second);
+  cacheMap.erase(result);
+}
+
+void MemoryGovernor::notifyFrameDrawn(RenderCache* cache) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  auto result = cacheMap.find(cache);
+  if (result == cacheMap.end()) {
+    return;
+  }
+  cacheList.splice(cacheList.begin(), cacheList, result->second);
+  auto record = result->second->get();
+  if (record->pressurePending) {
+    record->pressurePending = false;
+    purgeCache(record, record->pressureLevel);
+  } else {
+    auto memoryUsage = cache->memoryUsage();
+    usedSize = usedSize - record->memoryUsage + memoryUsage;
+    record->memoryUsage = memoryUsage;
+  }
+  checkMemoryUsage(cache);
+}
+
+void MemoryGovernor::purgeCache(CacheRecord* record, PAGMemoryPressureLevel level) {
+  if (level == PAGMemoryPressureLevel::Critical) {
+    record->cache->purgeAllCaches();
+  } else {
+    record->cache->purgeUnusedCaches();
+  }
+  auto memoryUsage = record->cache->memoryUsage();
+  usedSize = usedSize - record->memoryUsage + memoryUsage;
+  record->memoryUsage = memoryUsage;
+}
+
+void MemoryGovernor::purgeOtherCaches(RenderCache* current, PAGMemoryPressureLevel level) {
+  for (auto iter = cacheList.rbegin(); iter != cacheList.rend() && usedSize > maxSize; iter++) {
+    auto record = iter->get();
+    // Never wait for the locker here, the owner of the locker may be waiting for the governor.
+    if (record->cache == current || !record->locker->try_lock()) {
+      continue;
+    }
+    purgeCache(record, level);
+    record->locker->unlock();
+  }
+}
+
+void MemoryGovernor::checkMemoryUsage(RenderCache* current) {
+  if (maxSize == 0 || usedSize <= maxSize) {
+    return;
+  }
+  // Purges the caches in the order of their priorities: the unused caches of the other players,
+  // the unused caches of the current player, and then all caches of the other players. The caches
+  // the current player is drawing are always kept.
+  purgeOtherCaches(current, PAGMemoryPressureLevel::Moderate);
+  if (current != nullptr && usedSize > maxSize) {
+    purgeCache(cacheMap[current]->get(), PAGMemoryPressureLevel::Moderate);
+  }
+  purgeOtherCaches(current, PAGMemoryPressureLevel::Critical);
+}
+
+size_t PAGMemoryGovernor::MaxMemorySize() {
+  return MemoryGovernor::GetInstance()->maxMemorySize();
+}
+
+void PAGMemoryGovernor::SetMaxMemorySize(size_t size) {
+  MemoryGovernor::GetInstance()->setMaxMemorySize(size);
+}
+
+size_t PAGMemoryGovernor::MemoryUsage() {
+  return MemoryGovernor::GetInstance()->memoryUsage();
+}
+
+void PAGMemoryGovernor::OnMemoryPressure(PAGMemoryPressureLevel level) {
+  MemoryGovernor::GetInstance()->onMemoryPressure(level);
+}
+}  // namespace pag
@@ -0,0 +1,95 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "pag/types.h"
+
+namespace pag {
+class RenderCache;
+class CacheRecord;
+
+/**
+ * MemoryGovernor tracks the memory usage of all RenderCaches and keeps their total usage within a
+ * process-wide memory limit. RenderCaches are only modified while their players are locked, so the
+ * governor purges the caches of the other players only if their lockers are free, starting from
+ * the least recently drawn one. Caches that are busy drawing purge themselves after their current
+ * frame.
+ */
+class MemoryGovernor {
+ public:
+  static MemoryGovernor* GetInstance();
+
+  /**
+   * Returns the memory limit in bytes of all RenderCaches. The default value is 0, which means no
+   * limit.
+   */
+  size_t maxMemorySize();
+
+  /**
+   * Sets the memory limit in bytes of all RenderCaches, the caches exceeding the limit are purged
+   * immediately if possible.
+   */
+  void setMaxMemorySize(size_t size);
+
+  /**
+   * Returns the total memory usage in bytes of all RenderCaches, which is updated every time a
+   * cache finishes drawing a frame.
+   */
+  size_t memoryUsage();
+
+  /**
+   * Purges the caches of all RenderCaches according to the pressure level.
+   */
+  void onMemoryPressure(PAGMemoryPressureLevel level);
+
+  /**
+   * Starts tracking the specified cache, which is guarded by the specified locker.
+   */
+  void addCache(RenderCache* cache, std::shared_ptr<std::mutex> locker);
+
+  /**
+   * Stops tracking the specified cache. It must be called before the cache is destroyed.
+   */
+  void removeCache(RenderCache* cache);
+
+  /**
+   * Notifies that the specified cache has finished drawing a frame. It must be called while the
+   * locker of the cache is held.
+   */
+  void notifyFrameDrawn(RenderCache* cache);
+
+ private:
+  std::mutex locker = {};
+  size_t maxSize = 0;
+  size_t usedSize = 0;
+  /**
+   * The tracked caches ordered from the most recently drawn to the least recently drawn.
+   */
+  std::list<std::shared_ptr<CacheRecord>> cacheList = {};
+  std::unordered_map<RenderCache*, std::list<std::shared_ptr<CacheRecord>>::iterator> cacheMap =
+      {};
+
+  void purgeCache(CacheRecord* record, PAGMemoryPressureLevel level);
+  void purgeOtherCaches(RenderCache* current, PAGMemoryPressureLevel level);
+  void checkMemoryUsage(RenderCache* current);
+};
+}  // namespace pag
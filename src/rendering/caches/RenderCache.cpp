@@ -22,6 +22,8 @@
 #include "base/utils/UniqueID.h"
 #include "rendering/caches/ImageContentCache.h"
 #include "rendering/caches/LayerCache.h"
+#include "rendering/caches/MemoryGovernor.h"
+#include "rendering/caches/SharedAssetCache.h"
 #include "rendering/editing/ImageReplacement.h"
 #include "rendering/filters/utils/Filter3DFactory.h"
 #include "rendering/renderers/FilterRenderer.h"
@@ -39,10 +41,14 @@ static constexpr float MIPMAP_ENABLED_THRESHOLD = 0.4f;
 static constexpr int64_t DECODING_VISIBLE_DISTANCE = 500000;  // 提前 500ms 开始解码。
 
 RenderCache::RenderCache(PAGStage* stage) : _uniqueID(UniqueID::Next()), stage(stage) {
+  MemoryGovernor::GetInstance()->addCache(this, stage->rootLocker);
 }
 
 RenderCache::~RenderCache() {
+  waitForNextContents();
+  MemoryGovernor::GetInstance()->removeCache(this);
   releaseAll();
+  clearSharedAssetImages();
 }
 
 uint32_t RenderCache::getContentVersion() const {
@@ -127,6 +133,75 @@ void RenderCache::prepareNextFrame() {
 #endif
 }
 
+struct NextLayerContent {
+  // Keeps the LayerCache alive until the task finishes.
+  std::shared_ptr<File> file = nullptr;
+  LayerCache* layerCache = nullptr;
+  Frame contentFrame = 0;
+};
+
+void RenderCache::setPipelinedRenderingEnabled(bool value) {
+  if (_pipelinedRenderingEnabled == value) {
+    return;
+  }
+  _pipelinedRenderingEnabled = value;
+  if (!_pipelinedRenderingEnabled) {
+    waitForNextContents();
+  }
+}
+
+void RenderCache::prepareNextContents() {
+  if (!_pipelinedRenderingEnabled) {
+    return;
+  }
+  // The LayerCaches are thread-safe, but there is no need to run two tasks at the same time.
+  waitForNextContents();
+  std::vector<NextLayerContent> contents = {};
+  for (auto& pagLayer : stage->layers) {
+    collectNextContents(pagLayer.get(), &contents);
+  }
+  if (contents.empty()) {
+    return;
+  }
+  contentTask = tgfx::Task::Run([contents = std::move(contents)]() {
+    for (auto& item : contents) {
+      auto layerCache = item.layerCache;
+      if (!layerCache->contentVisible(item.contentFrame)) {
+        continue;
+      }
+      layerCache->getMasks(item.contentFrame);
+      layerCache->getContent(item.contentFrame);
+    }
+  });
+}
+
+void RenderCache::collectNextContents(PAGLayer* pagLayer, std::vector<NextLayerContent>* contents) {
+  if (pagLayer->_trackMatteLayer != nullptr) {
+    // The track matte layer is usually invisible, but it is still drawn by its owner.
+    collectNextContents(pagLayer->_trackMatteLayer.get(), contents);
+  }
+  if (!pagLayer->layerVisible) {
+    return;
+  }
+  // The replaced contents are owned by the PAGLayers, which can not be accessed off the lock.
+  if (pagLayer->layerCache != nullptr && pagLayer->file != nullptr &&
+      !pagLayer->contentModified()) {
+    contents->push_back({pagLayer->file, pagLayer->layerCache, pagLayer->contentFrame + 1});
+  }
+  if (pagLayer->layerType() == LayerType::PreCompose) {
+    for (auto& childLayer : static_cast<PAGComposition*>(pagLayer)->layers) {
+      collectNextContents(childLayer.get(), contents);
+    }
+  }
+}
+
+void RenderCache::waitForNextContents() {
+  if (contentTask != nullptr) {
+    contentTask->wait();
+    contentTask = nullptr;
+  }
+}
+
 void RenderCache::clearExpiredSequences() {
   std::vector<ID> expiredSequences = {};
   for (auto& item : sequenceCaches) {
@@ -139,6 +214,42 @@ void RenderCache::clearExpiredSequences() {
   }
 }
 
+size_t RenderCache::memoryUsage() const {
+  auto usage = graphicsMemory;
+  for (auto& item : sequenceCaches) {
+    for (auto queue : item.second) {
+      usage += queue->memoryUsage();
+    }
+  }
+  return usage;
+}
+
+void RenderCache::setSequencePrefetchDepth(int value) {
+  value = std::max(value, 1);
+  if (_sequencePrefetchDepth == value) {
+    return;
+  }
+  _sequencePrefetchDepth = value;
+  for (auto& item : sequenceCaches) {
+    for (auto queue : item.second) {
+      queue->setPrefetchDepth(value);
+    }
+  }
+}
+
+void RenderCache::setSequenceCheckpointInterval(int value) {
+  value = std::max(value, 0);
+  if (_sequenceCheckpointInterval == value) {
+    return;
+  }
+  _sequenceCheckpointInterval = value;
+  for (auto& item : sequenceCaches) {
+    for (auto queue : item.second) {
+      queue->setCheckpointInterval(value);
+    }
+  }
+}
+
 bool RenderCache::snapshotEnabled() const {
   return _snapshotEnabled;
 }
@@ -173,7 +284,7 @@ void RenderCache::attachToContext(tgfx::Context* current, bool forDrawing) {
   auto removedAssets = stage->getRemovedAssets();
   for (auto assetID : removedAssets) {
     removeSnapshot(assetID);
-    assetImages.erase(assetID);
+    removeAssetImage(assetID);
     decodedAssetImages.erase(assetID);
     clearSequenceCache(assetID);
     removeTextAtlas(assetID);
@@ -188,6 +299,35 @@ void RenderCache::releaseAll() {
   contextID = 0;
 }
 
+void RenderCache::purgeUnusedCaches() {
+  clearExpiredSequences();
+  clearExpiredDecodedImages();
+  std::vector<ID> expiredAssets = {};
+  for (auto& item : snapshotCaches) {
+    if (usedAssets.count(item.first) == 0) {
+      expiredAssets.push_back(item.first);
+    }
+  }
+  for (auto& item : textAtlases) {
+    if (usedAssets.count(item.first) == 0) {
+      expiredAssets.push_back(item.first);
+    }
+  }
+  for (auto assetID : expiredAssets) {
+    removeSnapshot(assetID);
+    removeTextAtlas(assetID);
+  }
+  clearExpiredGlyphPages(0);
+}
+
+void RenderCache::purgeAllCaches() {
+  clearAllSnapshots();
+  clearAllTextAtlas();
+  clearAllSequenceCaches();
+  decodedAssetImages = {};
+  usedSequences = {};
+}
+
 void RenderCache::detachFromContext() {
   if (!isDrawingFrame) {
     context = nullptr;
@@ -198,6 +338,7 @@ void RenderCache::detachFromContext() {
   clearExpiredSequences();
   clearExpiredDecodedImages();
   clearExpiredSnapshots();
+  clearExpiredGlyphPages(PURGEABLE_EXPIRED_FRAME);
   if (!timestamps.empty()) {
     // Always purge recycled resources that haven't been used in 1 frame.
     context->purgeResourcesNotUsedSince(timestamps.back(), true);
@@ -212,6 +353,7 @@ void RenderCache::detachFromContext() {
   while (timestamps.size() > PURGEABLE_EXPIRED_FRAME) {
     timestamps.pop();
   }
+  MemoryGovernor::GetInstance()->notifyFrameDrawn(this);
   context = nullptr;
 }
 
@@ -299,20 +441,23 @@ TextAtlas* RenderCache::getTextAtlas(ID assetID) const {
 TextAtlas* RenderCache::getTextAtlas(const TextBlock* textBlock) {
   auto maxScaleFactor = stage->getAssetMaxScale(textBlock->assetID());
   auto textAtlas = getTextAtlas(textBlock->assetID());
-  if (textAtlas && (textAtlas->textGlyphsID() != textBlock->id() ||
-                    fabsf(textAtlas->scaleFactor() - maxScaleFactor) > SCALE_FACTOR_PRECISION)) {
-    removeTextAtlas(textBlock->assetID());
-    textAtlas = nullptr;
-  }
-  if (textAtlas) {
+  if (textAtlas && textAtlas->textGlyphsID() == textBlock->id() &&
+      fabsf(textAtlas->scaleFactor() - maxScaleFactor) <= SCALE_FACTOR_PRECISION) {
     return textAtlas;
   }
   if (maxScaleFactor < SCALE_FACTOR_PRECISION) {
+    removeTextAtlas(textBlock->assetID());
     return nullptr;
   }
-  textAtlas = TextAtlas::Make(textBlock, this, maxScaleFactor).release();
+  auto oldUsage = maskGlyphAtlas.memoryUsage() + colorGlyphAtlas.memoryUsage();
+  textAtlas = TextAtlas::Make(textBlock, context, &maskGlyphAtlas, &colorGlyphAtlas, maxScaleFactor)
+                  .release();
+  graphicsMemory += maskGlyphAtlas.memoryUsage() + colorGlyphAtlas.memoryUsage();
+  graphicsMemory -= oldUsage;
+  // The outdated atlas is removed after the new one is made, so the glyphs they have in common
+  // are looked up from the shared pages instead of being rasterized again.
+  removeTextAtlas(textBlock->assetID());
   if (textAtlas) {
-    graphicsMemory += textAtlas->memoryUsage();
     textAtlases[textBlock->assetID()] = textAtlas;
   }
   return textAtlas;
@@ -323,17 +468,21 @@ void RenderCache::removeTextAtlas(ID assetID) {
   if (textAtlas == textAtlases.end()) {
     return;
   }
-  graphicsMemory -= textAtlas->second->memoryUsage();
   delete textAtlas->second;
   textAtlases.erase(textAtlas);
 }
 
 void RenderCache::clearAllTextAtlas() {
   for (auto atlas : textAtlases) {
-    graphicsMemory -= atlas.second->memoryUsage();
     delete atlas.second;
   }
   textAtlases.clear();
+  clearExpiredGlyphPages(0);
+}
+
+void RenderCache::clearExpiredGlyphPages(int expiredFrames) {
+  graphicsMemory -= maskGlyphAtlas.purgeExpiredPages(expiredFrames);
+  graphicsMemory -= colorGlyphAtlas.purgeExpiredPages(expiredFrames);
 }
 
 void RenderCache::clearAllSnapshots() {
@@ -403,18 +552,64 @@ std::shared_ptr<tgfx::Image> RenderCache::getAssetImageInternal(ID assetID,
   if (image != nullptr) {
     return image;
   }
-  image = proxy->makeImage(this);
+  auto scaleFactor = stage->getAssetMinScale(assetID);
+  auto mipmapped = scaleFactor < MIPMAP_ENABLED_THRESHOLD;
+  if (_useSharedAssetCache && !proxy->isContextBound()) {
+    auto sharedCache = SharedAssetCache::GetInstance();
+    image = sharedCache->retain(assetID, mipmapped);
+    if (image == nullptr) {
+      image = sharedCache->add(assetID, mipmapped, makeAssetImage(proxy, mipmapped));
+    }
+    if (image != nullptr) {
+      sharedAssets[assetID] = mipmapped;
+    }
+  } else {
+    image = makeAssetImage(proxy, mipmapped);
+  }
   if (image == nullptr) {
     return nullptr;
   }
-  auto scaleFactor = stage->getAssetMinScale(assetID);
-  if (scaleFactor < MIPMAP_ENABLED_THRESHOLD) {
+  assetImages[assetID] = image;
+  return image;
+}
+
+std::shared_ptr<tgfx::Image> RenderCache::makeAssetImage(const ImageProxy* proxy, bool mipmapped) {
+  auto image = proxy->makeImage(this);
+  if (image != nullptr && mipmapped) {
     image = image->makeMipmapped(true);
   }
-  assetImages[assetID] = image;
   return image;
 }
 
+void RenderCache::setUseSharedAssetCache(bool value) {
+  if (_useSharedAssetCache == value) {
+    return;
+  }
+  _useSharedAssetCache = value;
+  if (!_useSharedAssetCache) {
+    // Drops the shared images so that they are made again for this player only.
+    clearSharedAssetImages();
+  }
+}
+
+void RenderCache::removeAssetImage(ID assetID) {
+  assetImages.erase(assetID);
+  auto result = sharedAssets.find(assetID);
+  if (result != sharedAssets.end()) {
+    SharedAssetCache::GetInstance()->release(assetID, result->second);
+    sharedAssets.erase(result);
+  }
+}
+
+void RenderCache::clearSharedAssetImages() {
+  auto sharedCache = SharedAssetCache::GetInstance();
+  for (auto& item : sharedAssets) {
+    assetImages.erase(item.first);
+    sharedCache->release(item.first, item.second);
+  }
+  sharedAssets = {};
+}
+
 void RenderCache::clearExpiredDecodedImages() {
   std::vector<ID> expiredList = {};
   for (auto& item : decodedAssetImages) {
@@ -526,6 +721,8 @@ SequenceImageQueue* RenderCache::makeSequenceImageQueue(std::shared_ptr<Sequence
   if (queue == nullptr) {
     return nullptr;
   }
+  queue->setPrefetchDepth(_sequencePrefetchDepth);
+  queue->setCheckpointInterval(_sequenceCheckpointInterval);
   auto assetID = sequence->uniqueID();
   sequenceCaches[assetID].push_back(queue);
   return queue;
@@ -37,9 +37,12 @@
 #include "rendering/sequences/SequenceImageQueue.h"
 #include "rendering/sequences/SequenceInfo.h"
 #include "rendering/utils/PathHasher.h"
+#include "tgfx/core/Task.h"
 #include "tgfx/gpu/Device.h"
 
 namespace pag {
+struct NextLayerContent;
+
 class RenderCache : public Performance {
  public:
   explicit RenderCache(PAGStage* stage);
@@ -59,9 +62,7 @@ class RenderCache : public Performance {
   /**
    * Returns the total memory usage of this cache.
    */
-  size_t memoryUsage() const {
-    return graphicsMemory;
-  }
+  size_t memoryUsage() const;
 
   /**
    * Returns the GPU context associated with this cache.
@@ -109,6 +110,65 @@ class RenderCache : public Performance {
     _useDiskCache = value;
   }
 
+  /**
+   * Returns the number of frames decoded ahead of playback for each image sequence. The default
+   * value is 1.
+   */
+  int sequencePrefetchDepth() const {
+    return _sequencePrefetchDepth;
+  }
+
+  /**
+   * Set the value of sequencePrefetchDepth property.
+   */
+  void setSequencePrefetchDepth(int value);
+
+  /**
+   * Returns the interval of frames at which the image sequences keep a snapshot of the decoded
+   * frame to speed up seeking. The default value is 0, which disables the snapshots.
+   */
+  int sequenceCheckpointInterval() const {
+    return _sequenceCheckpointInterval;
+  }
+
+  /**
+   * Set the value of sequenceCheckpointInterval property.
+   */
+  void setSequenceCheckpointInterval(int value);
+
+  /**
+   * If set to true, the asset images are shared with other players that also enable it, so that
+   * the same image is decoded and uploaded to the GPU only once. The default value is false.
+   */
+  bool useSharedAssetCache() const {
+    return _useSharedAssetCache;
+  }
+
+  /**
+   * Set the value of useSharedAssetCache property.
+   */
+  void setUseSharedAssetCache(bool value);
+
+  /**
+   * If set to true, the layer contents of the next frame are evaluated on a worker thread while
+   * the current frame is being drawn. The default value is false.
+   */
+  bool pipelinedRenderingEnabled() const {
+    return _pipelinedRenderingEnabled;
+  }
+
+  /**
+   * Set the value of pipelinedRenderingEnabled property.
+   */
+  void setPipelinedRenderingEnabled(bool value);
+
+  /**
+   * Starts evaluating the transforms, masks and contents of the visible layers at the frame
+   * following the current one asynchronously. It should be called right after the current frame
+   * is recorded. Does nothing if pipelinedRenderingEnabled is false.
+   */
+  void prepareNextContents();
+
   /**
    * Returns a snapshot cache of specified asset id. Returns null if there is no associated cache
    * available. This is a read-only query which is used usually during hit testing.
@@ -162,6 +222,16 @@ class RenderCache : public Performance {
 
   void releaseAll();
 
+  /**
+   * Frees the caches that were not used in the last drawn frame immediately.
+   */
+  void purgeUnusedCaches();
+
+  /**
+   * Frees all snapshots, text atlases, decoded images and sequence caches immediately.
+   */
+  void purgeAllCaches();
+
  private:
   ID _uniqueID = 0;
   PAGStage* stage = nullptr;
@@ -173,18 +243,32 @@ class RenderCache : public Performance {
   bool _videoEnabled = true;
   bool _snapshotEnabled = true;
   bool _useDiskCache = false;
+  int _sequencePrefetchDepth = 1;
+  int _sequenceCheckpointInterval = 0;
+  bool _useSharedAssetCache = false;
+  bool _pipelinedRenderingEnabled = false;
+  std::shared_ptr<tgfx::Task> contentTask = nullptr;
   std::unordered_set<ID> usedAssets = {};
   std::unordered_map<ID, Snapshot*> snapshotCaches = {};
   std::list<Snapshot*> snapshotLRU = {};
   std::unordered_map<Snapshot*, std::list<Snapshot*>::iterator> snapshotPositions = {};
   std::unordered_map<ID, TextAtlas*> textAtlases = {};
+  GlyphAtlas maskGlyphAtlas = GlyphAtlas(true);
+  GlyphAtlas colorGlyphAtlas = GlyphAtlas(false);
   std::unordered_map<ID, std::shared_ptr<tgfx::Image>> assetImages = {};
   std::unordered_map<ID, std::shared_ptr<tgfx::Image>> decodedAssetImages = {};
+  /**
+   * The asset images retained from the SharedAssetCache, mapped to whether they are mipmapped.
+   */
+  std::unordered_map<ID, bool> sharedAssets = {};
   std::unordered_map<ID, std::vector<SequenceImageQueue*>> sequenceCaches = {};
   std::unordered_map<ID, std::unordered_map<Frame, SequenceImageQueue*>> usedSequences = {};
 
   // decoded image caches:
   void clearExpiredDecodedImages();
+  std::shared_ptr<tgfx::Image> makeAssetImage(const ImageProxy* proxy, bool mipmapped);
+  void removeAssetImage(ID assetID);
+  void clearSharedAssetImages();
 
   // snapshot caches:
   void clearAllSnapshots();
@@ -206,10 +290,13 @@ class RenderCache : public Performance {
   void clearAllTextAtlas();
   void removeTextAtlas(ID assetID);
   TextAtlas* getTextAtlas(ID assetID) const;
+  void clearExpiredGlyphPages(int expiredFrames);
 
   void preparePreComposeLayer(PreComposeLayer* layer);
   void prepareImageLayer(PAGImageLayer* layer);
   void prepareNextFrame();
+  void collectNextContents(PAGLayer* pagLayer, std::vector<NextLayerContent>* contents);
+  void waitForNextContents();
   std::shared_ptr<tgfx::Image> getAssetImageInternal(ID assetID, const ImageProxy* proxy);
   void recordPerformance();
 
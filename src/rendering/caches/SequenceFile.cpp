@@ -17,6 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "SequenceFile.h"
+#include <algorithm>
 #include <cstring>
 #include "DiskCache.h"
 #include "base/utils/Log.h"
@@ -26,7 +27,12 @@
 #include "tgfx/core/DataView.h"
 
 namespace pag {
-static constexpr uint8_t FILE_VERSION = 1;
+static constexpr uint8_t FILE_VERSION = 2;
+/**
+ * The oldest file version that can still be read and appended. Frames in version 1 files are all
+ * compressed with the compression type in the file head.
+ */
+static constexpr uint8_t LEGACY_FILE_VERSION = 1;
 /**
  * [version: uint8_t]
  * [compression: uint8_t]
@@ -49,31 +55,148 @@ static constexpr uint32_t TIME_RANGE_SIZE = 8;
  * [frameIndex: uint32_t]
  * [frameSize: uint64_t]
  */
-static constexpr uint32_t FRAME_HEAD_SIZE = 12;
+static constexpr uint32_t LEGACY_FRAME_HEAD_SIZE = 12;
+/**
+ * [frameIndex: uint32_t]
+ * [frameSize: uint64_t]
+ * [compression: uint8_t]
+ */
+static constexpr uint32_t FRAME_HEAD_SIZE = 13;
+/**
+ * [keyframeIndex: uint32_t]
+ * [tileCount: uint32_t]
+ * [tileIndices: uint32_t * tileCount]
+ * [compressed tile pixels]
+ */
+static constexpr uint32_t DELTA_HEAD_SIZE = 8;
+static constexpr int DELTA_TILE_SIZE = 64;
+/**
+ * The maximum number of delta frames that can refer to the same keyframe.
+ */
+static constexpr int KEYFRAME_INTERVAL = 30;
+
+struct TileRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+static uint32_t GetTileColumns(const tgfx::ImageInfo& info) {
+  return static_cast<uint32_t>((info.width() + DELTA_TILE_SIZE - 1) / DELTA_TILE_SIZE);
+}
+
+static uint32_t GetTileCount(const tgfx::ImageInfo& info) {
+  auto rows = static_cast<uint32_t>((info.height() + DELTA_TILE_SIZE - 1) / DELTA_TILE_SIZE);
+  return GetTileColumns(info) * rows;
+}
+
+static TileRect GetTileRect(const tgfx::ImageInfo& info, uint32_t tile) {
+  auto columns = GetTileColumns(info);
+  TileRect rect = {};
+  rect.x = static_cast<int>(tile % columns) * DELTA_TILE_SIZE;
+  rect.y = static_cast<int>(tile / columns) * DELTA_TILE_SIZE;
+  rect.width = std::min(DELTA_TILE_SIZE, info.width() - rect.x);
+  rect.height = std::min(DELTA_TILE_SIZE, info.height() - rect.y);
+  return rect;
+}
+
+static size_t GetTilesByteSize(const tgfx::ImageInfo& info, const std::vector<uint32_t>& tiles) {
+  size_t byteSize = 0;
+  for (auto tile : tiles) {
+    auto rect = GetTileRect(info, tile);
+    byteSize += static_cast<size_t>(rect.width * rect.height * info.bytesPerPixel());
+  }
+  return byteSize;
+}
+
+static std::vector<uint32_t> FindDirtyTiles(const tgfx::ImageInfo& info, const uint8_t* pixels,
+                                            const uint8_t* keyframe) {
+  std::vector<uint32_t> dirtyTiles = {};
+  auto tileCount = GetTileCount(info);
+  for (uint32_t tile = 0; tile < tileCount; tile++) {
+    auto rect = GetTileRect(info, tile);
+    auto offset = rect.y * info.rowBytes() + rect.x * info.bytesPerPixel();
+    auto lineBytes = static_cast<size_t>(rect.width * info.bytesPerPixel());
+    for (int row = 0; row < rect.height; row++) {
+      if (memcmp(pixels + offset, keyframe + offset, lineBytes) != 0) {
+        dirtyTiles.push_back(tile);
+        break;
+      }
+      offset += info.rowBytes();
+    }
+  }
+  return dirtyTiles;
+}
+
+static void GatherTiles(const tgfx::ImageInfo& info, const std::vector<uint32_t>& tiles,
+                        const uint8_t* pixels, uint8_t* tileBytes) {
+  for (auto tile : tiles) {
+    auto rect = GetTileRect(info, tile);
+    auto offset = rect.y * info.rowBytes() + rect.x * info.bytesPerPixel();
+    auto lineBytes = static_cast<size_t>(rect.width * info.bytesPerPixel());
+    for (int row = 0; row < rect.height; row++) {
+      memcpy(tileBytes, pixels + offset, lineBytes);
+      tileBytes += lineBytes;
+      offset += info.rowBytes();
+    }
+  }
+}
+
+static void ScatterTiles(const tgfx::ImageInfo& info, const std::vector<uint32_t>& tiles,
+                         const uint8_t* tileBytes, uint8_t* pixels) {
+  for (auto tile : tiles) {
+    auto rect = GetTileRect(info, tile);
+    auto offset = rect.y * info.rowBytes() + rect.x * info.bytesPerPixel();
+    auto lineBytes = static_cast<size_t>(rect.width * info.bytesPerPixel());
+    for (int row = 0; row < rect.height; row++) {
+      memcpy(pixels + offset, tileBytes, lineBytes);
+      tileBytes += lineBytes;
+      offset += info.rowBytes();
+    }
+  }
+}
+
+static FILE* OpenFile(const std::string& filePath, const char* mode) {
+  auto file = fopen(filePath.c_str(), mode);
+  if (file != nullptr) {
+    // Writes go to the disk directly, so a short write is reported by fwrite() itself and never
+    // leaves pending bytes in the stdio buffer.
+    setvbuf(file, nullptr, _IONBF, 0);
+  }
+  return file;
+}
 
 std::shared_ptr<SequenceFile> SequenceFile::Open(const std::string& filePath,
                                                  const tgfx::ImageInfo& info, int frameCount,
                                                  float frameRate,
-                                                 const std::vector<TimeRange>& staticTimeRanges) {
+                                                 const std::vector<TimeRange>& staticTimeRanges,
+                                                 PAGCompressionMode compressionMode) {
   if (filePath.empty() || info.isEmpty() || frameCount == 0 || frameRate <= 0) {
     return nullptr;
   }
   auto sequenceFile = std::shared_ptr<SequenceFile>(
-      new SequenceFile(filePath, info, frameCount, frameRate, staticTimeRanges));
+      new SequenceFile(filePath, info, frameCount, frameRate, staticTimeRanges, compressionMode));
   return sequenceFile->file ? sequenceFile : nullptr;
 }
 
 SequenceFile::SequenceFile(const std::string& filePath, const tgfx::ImageInfo& info, int frameCount,
-                           float frameRate, std::vector<TimeRange> staticTimeRanges)
-    : _info(info), _numFrames(frameCount), _frameRate(frameRate),
+                           float frameRate, std::vector<TimeRange> staticTimeRanges,
+                           PAGCompressionMode compressionMode)
+    : fileVersion(FILE_VERSION), compressionMode(compressionMode), _info(info),
+      _numFrames(frameCount), _frameRate(frameRate),
       _staticTimeRanges(std::move(staticTimeRanges)) {
   decoder = LZ4Decoder::Make();
   Directory::CreateRecursively(Directory::GetParentDirectory(filePath));
 #ifdef __APPLE__
   compressionType = CompressionType::LZ4_APPLE;
 #endif
-  frames.resize(frameCount, {0, 0});
-  file = fopen(filePath.c_str(), "ab+");
+  frames.resize(frameCount, {});
+  // The file is not opened in append mode, which would ignore the seeks before writing frames.
+  file = OpenFile(filePath, "rb+");
+  if (file == nullptr) {
+    file = OpenFile(filePath, "wb+");
+  }
   if (file == nullptr) {
     return;
   }
@@ -84,12 +207,15 @@ SequenceFile::SequenceFile(const std::string& filePath, const tgfx::ImageInfo& i
   }
   if (!readFramesFromFile()) {
     cachedFrames = 0;
-    memset(frames.data(), 0, sizeof(FrameLocation) * frames.size());
+    std::fill(frames.begin(), frames.end(), FrameLocation());
     _fileSize = 0;
+    fileVersion = FILE_VERSION;
     fclose(file);
-    file = fopen(filePath.c_str(), "wb+");
+    file = OpenFile(filePath, "wb+");
     LOGE("The existing sequence file has been reset, which may be corrupted!");
+    return;
   }
+  mapFileIfComplete();
 }
 
 SequenceFile::~SequenceFile() {
@@ -122,7 +248,8 @@ bool SequenceFile::readFramesFromFile() {
   auto info = tgfx::ImageInfo::Make(static_cast<int>(fileWidth), static_cast<int>(fileHeight),
                                     static_cast<tgfx::ColorType>(colorType),
                                     static_cast<tgfx::AlphaType>(alphaType), rowBytes);
-  if (version != FILE_VERSION || compression != static_cast<uint8_t>(compressionType) ||
+  if ((version != FILE_VERSION && version != LEGACY_FILE_VERSION) ||
+      compression != static_cast<uint8_t>(compressionType) ||
       info != _info || fileFrameCount != static_cast<uint32_t>(_numFrames) ||
       fileFrameRate != _frameRate || staticTimeRangeCount != _staticTimeRanges.size()) {
     return false;
@@ -137,25 +264,41 @@ bool SequenceFile::readFramesFromFile() {
       return false;
     }
   }
+  fileVersion = version;
+  auto headSize = frameHeadSize();
   long position = 0;
   while (true) {
-    readLength = fread(data.writableBytes(), 1, FRAME_HEAD_SIZE, file);
+    readLength = fread(data.writableBytes(), 1, headSize, file);
     if (readLength == 0) {
       break;
     }
-    if (readLength != FRAME_HEAD_SIZE) {
+    if (readLength != headSize) {
       return false;
     }
     auto frameIndex = data.getUint32(0);
     auto frameSize = data.getUint64(4);
-    if (frameIndex >= static_cast<uint32_t>(_numFrames)) {
+    auto frameCompression = version == LEGACY_FILE_VERSION ? compression : data.getUint8(12);
+    if (frameIndex >= static_cast<uint32_t>(_numFrames) ||
+        (frameCompression != compression &&
+         frameCompression != static_cast<uint8_t>(CompressionType::None) &&
+         frameCompression != static_cast<uint8_t>(CompressionType::Delta))) {
       return false;
     }
     auto& frame = frames[frameIndex];
     frame.offset = static_cast<size_t>(ftell(file));
     frame.size = frameSize;
+    frame.compression = static_cast<CompressionType>(frameCompression);
+    frame.keyframe = frameIndex;
+    auto skipSize = frameSize;
+    if (frame.compression == CompressionType::Delta) {
+      if (frameSize < DELTA_HEAD_SIZE || fread(data.writableBytes(), 1, 4, file) != 4) {
+        return false;
+      }
+      frame.keyframe = data.getUint32(0);
+      skipSize -= 4;
+    }
     cachedFrames++;
-    if (fseek(file, static_cast<long>(frameSize), SEEK_CUR)) {
+    if (fseek(file, static_cast<long>(skipSize), SEEK_CUR)) {
       return false;
     }
     position = ftell(file);
@@ -163,6 +306,18 @@ bool SequenceFile::readFramesFromFile() {
   if (position != static_cast<long>(_fileSize)) {
     return false;
   }
+  for (auto& frame : frames) {
+    if (frame.compression != CompressionType::Delta) {
+      continue;
+    }
+    if (frame.keyframe >= static_cast<uint32_t>(_numFrames)) {
+      return false;
+    }
+    const auto& keyframe = frames[frame.keyframe];
+    if (keyframe.size == 0 || keyframe.compression == CompressionType::Delta) {
+      return false;
+    }
+  }
   for (auto& timeRange : _staticTimeRanges) {
     auto& firstFrame = frames[timeRange.start];
     if (firstFrame.size > 0) {
@@ -193,12 +348,13 @@ bool SequenceFile::writeFileHead() {
     data.setUint32(offset, static_cast<uint32_t>(_staticTimeRanges[i].start));
     data.setUint32(offset + 4, static_cast<uint32_t>(_staticTimeRanges[i].end));
   }
-  auto writeLength = fwrite(data.bytes(), 1, data.size(), file);
-  _fileSize = writeLength;
-  if (writeLength != data.size()) {
+  if (fseek(file, 0, SEEK_SET) || fwrite(data.bytes(), 1, data.size(), file) != data.size()) {
+    // The file head is written again before the next frame.
+    clearerr(file);
     LOGE("SequenceFile::writeFileHead() write file head failed!");
     return false;
   }
+  _fileSize = data.size();
   return true;
 }
 
@@ -213,7 +369,6 @@ bool SequenceFile::isComplete() {
 }
 
 bool SequenceFile::readFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
-  std::lock_guard<std::mutex> autoLock(locker);
   if (index < 0 || index >= _numFrames || bitmap == nullptr) {
     LOGE("SequenceFile::readFrame() invalid index or pixels!");
     return false;
@@ -222,20 +377,56 @@ bool SequenceFile::readFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
     LOGE("SequenceFile::readFrame() the info of the specified bitmap is different from ours!");
     return false;
   }
-  const auto& frame = frames[index];
-  if (frame.size == 0) {
-    return false;
+  if (fileMapped.load(std::memory_order_acquire)) {
+    // The frame locations never change after the file is complete.
+    static thread_local auto threadDecoder = LZ4Decoder::Make();
+    return decodeFrame(index, threadDecoder.get(), std::move(bitmap));
+  }
+  std::lock_guard<std::mutex> autoLock(locker);
+  if (frames[index].size == 0) {
+    // The frame may be still waiting in the write queue of the disk cache.
+    return diskCache != nullptr && diskCache->readPendingFrame(this, index, std::move(bitmap));
+  }
+  return decodeFrame(index, decoder.get(), std::move(bitmap));
+}
+
+const uint8_t* SequenceFile::readFrameBytes(const FrameLocation& frame) {
+  if (fileMapped) {
+    return mappedFile->data() + frame.offset;
   }
   if (!checkScratchBuffer()) {
-    return false;
+    return nullptr;
   }
   if (fseek(file, static_cast<long>(frame.offset), SEEK_SET)) {
     LOGE("SequenceFile::readFrame() fseek failed! (offset: %zu)", frame.offset);
-    return false;
+    return nullptr;
   }
   auto encodedLength = fread(scratchBuffer.bytes(), 1, frame.size, file);
   if (encodedLength != frame.size) {
     LOGE("SequenceFile::readFrame() fread failed! (size: %zu)", frame.size);
+    return nullptr;
+  }
+  return scratchBuffer.bytes();
+}
+
+bool SequenceFile::decodeFrame(int index, const LZ4Decoder* frameDecoder,
+                               std::shared_ptr<BitmapBuffer> bitmap) {
+  const auto& frame = frames[index];
+  if (frame.size == 0) {
+    return false;
+  }
+  if (frame.compression == CompressionType::Delta) {
+    if (!decodeKeyframe(frame.keyframe, frameDecoder, bitmap)) {
+      return false;
+    }
+    auto bytes = readFrameBytes(frame);
+    if (bytes == nullptr) {
+      return false;
+    }
+    return decodeDeltaFrame(frameDecoder, frame, bytes, std::move(bitmap));
+  }
+  auto bytes = readFrameBytes(frame);
+  if (bytes == nullptr) {
     return false;
   }
   auto byteSize = _info.byteSize();
@@ -244,8 +435,16 @@ bool SequenceFile::readFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
     LOGE("SequenceFile::readFrame() failed to lock pixels from the specified bitmap!");
     return false;
   }
-  auto decodedLength = decoder->decode(reinterpret_cast<uint8_t*>(pixels), byteSize,
-                                       scratchBuffer.bytes(), encodedLength);
+  size_t decodedLength = 0;
+  if (frame.compression == CompressionType::None) {
+    if (frame.size == byteSize) {
+      memcpy(pixels, bytes, byteSize);
+      decodedLength = byteSize;
+    }
+  } else {
+    decodedLength =
+        frameDecoder->decode(reinterpret_cast<uint8_t*>(pixels), byteSize, bytes, frame.size);
+  }
   bitmap->unlockPixels();
   if (decodedLength != byteSize) {
     LOGE("SequenceFile::readFrame() decode failed! (decoded: %zu, expected: %zu)", decodedLength,
@@ -255,6 +454,90 @@ bool SequenceFile::readFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
   return true;
 }
 
+bool SequenceFile::decodeKeyframe(uint32_t index, const LZ4Decoder* frameDecoder,
+                                  std::shared_ptr<BitmapBuffer> bitmap) {
+  // Consecutive delta frames usually share the same keyframe, so the last decoded keyframe is kept
+  // to skip decoding it again for each of them.
+  std::shared_ptr<DecodedKeyframe> keyframe = nullptr;
+  {
+    std::lock_guard<std::mutex> autoLock(keyframeLocker);
+    keyframe = decodedKeyframe;
+  }
+  auto byteSize = _info.byteSize();
+  if (keyframe != nullptr && keyframe->index == index) {
+    auto pixels = bitmap->lockPixels();
+    if (pixels == nullptr) {
+      LOGE("SequenceFile::readFrame() failed to lock pixels from the specified bitmap!");
+      return false;
+    }
+    memcpy(pixels, keyframe->pixels.bytes(), byteSize);
+    bitmap->unlockPixels();
+    return true;
+  }
+  // Keyframes are always stored as full frames.
+  if (!decodeFrame(static_cast<int>(index), frameDecoder, bitmap)) {
+    return false;
+  }
+  keyframe = std::make_shared<DecodedKeyframe>();
+  keyframe->index = index;
+  keyframe->pixels.alloc(byteSize);
+  if (keyframe->pixels.isEmpty()) {
+    return true;
+  }
+  auto pixels = bitmap->lockPixels();
+  if (pixels == nullptr) {
+    return true;
+  }
+  memcpy(keyframe->pixels.bytes(), pixels, byteSize);
+  bitmap->unlockPixels();
+  std::lock_guard<std::mutex> autoLock(keyframeLocker);
+  decodedKeyframe = std::move(keyframe);
+  return true;
+}
+
+bool SequenceFile::decodeDeltaFrame(const LZ4Decoder* frameDecoder, const FrameLocation& frame,
+                                    const uint8_t* bytes, std::shared_ptr<BitmapBuffer> bitmap) {
+  tgfx::DataView data(const_cast<uint8_t*>(bytes), frame.size);
+  auto tileCount = data.getUint32(4);
+  auto tileTableSize = DELTA_HEAD_SIZE + static_cast<size_t>(tileCount) * 4;
+  if (tileCount > GetTileCount(_info) || tileTableSize > frame.size) {
+    LOGE("SequenceFile::readFrame() the delta frame is corrupted!");
+    return false;
+  }
+  std::vector<uint32_t> tiles(tileCount);
+  for (uint32_t i = 0; i < tileCount; i++) {
+    tiles[i] = data.getUint32(DELTA_HEAD_SIZE + i * 4);
+    // The dirty tiles are always written in increasing order without duplicates.
+    if (tiles[i] >= GetTileCount(_info) || (i > 0 && tiles[i] <= tiles[i - 1])) {
+      LOGE("SequenceFile::readFrame() the delta frame is corrupted!");
+      return false;
+    }
+  }
+  auto tilesByteSize = GetTilesByteSize(_info, tiles);
+  if (tilesByteSize == 0) {
+    return true;
+  }
+  tgfx::Buffer tileBuffer(tilesByteSize);
+  if (tileBuffer.isEmpty()) {
+    return false;
+  }
+  auto decodedLength = frameDecoder->decode(tileBuffer.bytes(), tilesByteSize,
+                                            bytes + tileTableSize, frame.size - tileTableSize);
+  if (decodedLength != tilesByteSize) {
+    LOGE("SequenceFile::readFrame() decode failed! (decoded: %zu, expected: %zu)", decodedLength,
+         tilesByteSize);
+    return false;
+  }
+  auto pixels = bitmap->lockPixels();
+  if (pixels == nullptr) {
+    LOGE("SequenceFile::readFrame() failed to lock pixels from the specified bitmap!");
+    return false;
+  }
+  ScatterTiles(_info, tiles, tileBuffer.bytes(), reinterpret_cast<uint8_t*>(pixels));
+  bitmap->unlockPixels();
+  return true;
+}
+
 bool SequenceFile::writeFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
   std::lock_guard<std::mutex> autoLock(locker);
   if (index < 0 || index >= _numFrames || bitmap == nullptr) {
@@ -274,50 +557,112 @@ bool SequenceFile::writeFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
     LOGE("SequenceFile::writeFrame() failed to lock pixels from the specified bitmap!");
     return false;
   }
-  auto compressedSize = compressFrame(static_cast<int>(timeRange.start), pixels, _info.byteSize());
+  FrameLocation location = {};
+  auto success = writeCompressedFrame(static_cast<int>(timeRange.start),
+                                      reinterpret_cast<const uint8_t*>(pixels), &location);
   bitmap->unlockPixels();
+  if (!success) {
+    return false;
+  }
+  auto headSize = frameHeadSize();
+  for (auto i = timeRange.start; i <= timeRange.end; i++) {
+    auto& frame = frames[i];
+    frame.offset = _fileSize + headSize;
+    frame.size = location.size;
+    frame.compression = location.compression;
+    frame.keyframe = location.keyframe;
+    cachedFrames++;
+  }
+  _fileSize += headSize + location.size;
+  if (cachedFrames == _numFrames) {
+    scratchBuffer.reset();
+    keyframePixels.reset();
+    encoder = nullptr;
+    mapFileIfComplete();
+  }
+  if (diskCache) {
+    diskCache->notifyFileSizeChanged(fileID, _fileSize);
+  }
+  return true;
+}
+
+bool SequenceFile::writeCompressedFrame(int index, const uint8_t* pixels,
+                                        FrameLocation* location) {
+  auto compressedSize = compressFrame(index, pixels, location);
   if (compressedSize == 0) {
     return false;
   }
   if (_fileSize == 0 && !writeFileHead()) {
     return false;
   }
-  if (fseek(file, 0, SEEK_END)) {
+  // Seeks to the end of the last complete frame, so the bytes left by a failed write are
+  // overwritten by the next frame. If the next frame is shorter, the leftover bytes are out of
+  // the frame table, and the file is reset when it is opened again.
+  if (fseek(file, static_cast<long>(_fileSize), SEEK_SET)) {
     LOGE("SequenceFile::writeFrame() failed to seek to the end of the file");
     return false;
   }
   if (fwrite(scratchBuffer.bytes(), 1, compressedSize, file) != compressedSize) {
+    clearerr(file);
     LOGE("SequenceFile::writeFrame() failed to write the compressed frame to disk");
     return false;
   }
-  for (auto i = timeRange.start; i <= timeRange.end; i++) {
-    auto& frame = frames[i];
-    frame.offset = _fileSize + FRAME_HEAD_SIZE;
-    frame.size = compressedSize - FRAME_HEAD_SIZE;
-    cachedFrames++;
-  }
-  _fileSize += compressedSize;
-  if (cachedFrames == _numFrames) {
-    scratchBuffer.reset();
-    encoder = nullptr;
-  }
-  if (diskCache) {
-    diskCache->notifyFileSizeChanged(fileID, _fileSize);
+  location->size = compressedSize - frameHeadSize();
+  // The keyframe changes only after the frame is written, otherwise the next delta frames could
+  // refer to a keyframe which is not in the file.
+  if (location->compression == CompressionType::Delta) {
+    framesSinceKeyframe++;
+  } else if (compressionMode == PAGCompressionMode::Delta &&
+             fileVersion != LEGACY_FILE_VERSION) {
+    auto byteSize = _info.byteSize();
+    if (keyframePixels.isEmpty()) {
+      keyframePixels.alloc(byteSize);
+    }
+    if (!keyframePixels.isEmpty()) {
+      memcpy(keyframePixels.bytes(), pixels, byteSize);
+      keyframeIndex = index;
+      framesSinceKeyframe = 0;
+    }
   }
   return true;
 }
 
-size_t SequenceFile::compressFrame(int index, const void* pixels, size_t byteSize) {
+uint32_t SequenceFile::frameHeadSize() const {
+  return fileVersion == LEGACY_FILE_VERSION ? LEGACY_FRAME_HEAD_SIZE : FRAME_HEAD_SIZE;
+}
+
+size_t SequenceFile::compressFrame(int index, const uint8_t* pixels, FrameLocation* location) {
   if (!checkScratchBuffer()) {
     return 0;
   }
-  if (encoder == nullptr) {
-    encoder = LZ4Encoder::Make();
+  auto useDelta =
+      compressionMode == PAGCompressionMode::Delta && fileVersion != LEGACY_FILE_VERSION;
+  if (useDelta) {
+    auto deltaSize = compressDeltaFrame(index, pixels, location);
+    if (deltaSize > 0) {
+      return deltaSize;
+    }
+  }
+  auto byteSize = _info.byteSize();
+  auto headSize = frameHeadSize();
+  auto bytes = scratchBuffer.bytes() + headSize;
+  auto size = scratchBuffer.size() - headSize;
+  size_t encodedLength = 0;
+  location->compression = CompressionType::None;
+  location->keyframe = static_cast<uint32_t>(index);
+  // Legacy files can only store frames compressed with the compression type in the file head.
+  if (compressionMode != PAGCompressionMode::None || fileVersion == LEGACY_FILE_VERSION) {
+    if (encoder == nullptr) {
+      encoder = LZ4Encoder::Make();
+    }
+    encodedLength = encoder->encode(bytes, size, pixels, byteSize);
+    location->compression = compressionType;
+  }
+  if (fileVersion != LEGACY_FILE_VERSION && (encodedLength == 0 || encodedLength >= byteSize)) {
+    memcpy(bytes, pixels, byteSize);
+    encodedLength = byteSize;
+    location->compression = CompressionType::None;
   }
-  auto bytes = scratchBuffer.bytes() + FRAME_HEAD_SIZE;
-  auto size = scratchBuffer.size() - FRAME_HEAD_SIZE;
-  auto encodedLength =
-      encoder->encode(bytes, size, reinterpret_cast<const uint8_t*>(pixels), byteSize);
   if (encodedLength == 0) {
     LOGE("SequenceFile::compressFrame() failed to encode frame %d!", index);
     return 0;
@@ -325,7 +670,53 @@ size_t SequenceFile::compressFrame(int index, const void* pixels, size_t byteSiz
   tgfx::DataView dataView(scratchBuffer.bytes(), scratchBuffer.size());
   dataView.setUint32(0, index);
   dataView.setUint64(4, encodedLength);
-  return encodedLength + FRAME_HEAD_SIZE;
+  if (fileVersion != LEGACY_FILE_VERSION) {
+    dataView.setUint8(12, static_cast<uint8_t>(location->compression));
+  }
+  return encodedLength + headSize;
+}
+
+size_t SequenceFile::compressDeltaFrame(int index, const uint8_t* pixels,
+                                        FrameLocation* location) {
+  if (keyframeIndex < 0 || framesSinceKeyframe >= KEYFRAME_INTERVAL) {
+    return 0;
+  }
+  auto dirtyTiles = FindDirtyTiles(_info, pixels, keyframePixels.bytes());
+  // Frames with more than half of the tiles changed are stored as new keyframes.
+  if (dirtyTiles.size() * 2 > GetTileCount(_info)) {
+    return 0;
+  }
+  auto tilesByteSize = GetTilesByteSize(_info, dirtyTiles);
+  auto tileTableSize = DELTA_HEAD_SIZE + dirtyTiles.size() * 4;
+  auto bytes = scratchBuffer.bytes() + FRAME_HEAD_SIZE + tileTableSize;
+  auto size = scratchBuffer.size() - FRAME_HEAD_SIZE - tileTableSize;
+  size_t encodedLength = 0;
+  if (tilesByteSize > 0) {
+    tgfx::Buffer tileBuffer(tilesByteSize);
+    if (tileBuffer.isEmpty()) {
+      return 0;
+    }
+    GatherTiles(_info, dirtyTiles, pixels, tileBuffer.bytes());
+    if (encoder == nullptr) {
+      encoder = LZ4Encoder::Make();
+    }
+    encodedLength = encoder->encode(bytes, size, tileBuffer.bytes(), tilesByteSize);
+    if (encodedLength == 0) {
+      return 0;
+    }
+  }
+  tgfx::DataView dataView(scratchBuffer.bytes(), scratchBuffer.size());
+  dataView.setUint32(0, index);
+  dataView.setUint64(4, tileTableSize + encodedLength);
+  dataView.setUint8(12, static_cast<uint8_t>(CompressionType::Delta));
+  dataView.setUint32(FRAME_HEAD_SIZE, static_cast<uint32_t>(keyframeIndex));
+  dataView.setUint32(FRAME_HEAD_SIZE + 4, static_cast<uint32_t>(dirtyTiles.size()));
+  for (size_t i = 0; i < dirtyTiles.size(); i++) {
+    dataView.setUint32(FRAME_HEAD_SIZE + DELTA_HEAD_SIZE + i * 4, dirtyTiles[i]);
+  }
+  location->compression = CompressionType::Delta;
+  location->keyframe = static_cast<uint32_t>(keyframeIndex);
+  return FRAME_HEAD_SIZE + tileTableSize + encodedLength;
 }
 
 bool SequenceFile::checkScratchBuffer() {
@@ -340,7 +731,9 @@ bool SequenceFile::checkScratchBuffer() {
       }
     }
   } else {
-    scratchBufferSize = LZ4Encoder::GetMaxOutputSize(_info.byteSize()) + FRAME_HEAD_SIZE;
+    auto byteSize = _info.byteSize();
+    scratchBufferSize = std::max(LZ4Encoder::GetMaxOutputSize(byteSize), byteSize) +
+                        FRAME_HEAD_SIZE + DELTA_HEAD_SIZE + GetTileCount(_info) * 4;
   }
   scratchBuffer.alloc(scratchBufferSize);
   if (scratchBuffer.isEmpty()) {
@@ -350,6 +743,18 @@ bool SequenceFile::checkScratchBuffer() {
   return true;
 }
 
+void SequenceFile::mapFileIfComplete() {
+  if (cachedFrames != _numFrames || fileMapped) {
+    return;
+  }
+  mappedFile = MappedFile::MakeFrom(file, _fileSize);
+  if (mappedFile == nullptr) {
+    // Falls back to reading frames through stdio.
+    return;
+  }
+  fileMapped.store(true, std::memory_order_release);
+}
+
 bool SequenceFile::compatible(const tgfx::ImageInfo& info, int frameCount, float frameRate,
                               const std::vector<TimeRange>& staticTimeRanges) {
   if (_info != info || _numFrames != frameCount || _frameRate != frameRate ||
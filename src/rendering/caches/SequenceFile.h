@@ -18,9 +18,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <string>
 #include <vector>
+#include "base/utils/MappedFile.h"
 #include "pag/types.h"
 #include "rendering/utils/BitmapBuffer.h"
 #include "rendering/utils/LZ4Decoder.h"
@@ -31,14 +33,27 @@
 namespace pag {
 class DiskCache;
 
-struct FrameLocation {
-  size_t offset = 0;
-  size_t size = 0;
-};
-
 enum class CompressionType {
+  None = 0,
   LZ4 = 1,
   LZ4_APPLE = 2,
+  /**
+   * The frame only stores the tiles that differ from its keyframe, and the tile pixels are
+   * compressed by the compression type in the file head.
+   */
+  Delta = 3,
+};
+
+struct DecodedKeyframe {
+  uint32_t index = 0;
+  tgfx::Buffer pixels = {};
+};
+
+struct FrameLocation {
+  size_t offset = 0;
+  size_t size = 0;
+  CompressionType compression = CompressionType::None;
+  uint32_t keyframe = 0;
 };
 
 /**
@@ -102,7 +117,9 @@ class SequenceFile {
 
   /**
    * Reads an image frame from the sequence into the specified pixel address. Returns false if the
-   * specified index is empty or the bitmap info is different from ours.
+   * specified index is empty or the bitmap info is different from ours. Once all frames are cached,
+   * the file is memory-mapped and frames are decompressed directly from the mapped region, which
+   * allows multiple threads to read frames concurrently without locking.
    */
   bool readFrame(int index, std::shared_ptr<BitmapBuffer> bitmap);
 
@@ -118,7 +135,9 @@ class SequenceFile {
   uint32_t fileID = 0;
   FILE* file = nullptr;
   size_t _fileSize = 0;
+  uint8_t fileVersion = 0;
   CompressionType compressionType = CompressionType::LZ4;
+  PAGCompressionMode compressionMode = PAGCompressionMode::LZ4;
   tgfx::ImageInfo _info = {};
   int _numFrames = 0;
   float _frameRate = 30.0f;
@@ -128,19 +147,39 @@ class SequenceFile {
   tgfx::Buffer scratchBuffer = {};
   std::unique_ptr<LZ4Decoder> decoder = nullptr;
   std::unique_ptr<LZ4Encoder> encoder = nullptr;
+  tgfx::Buffer keyframePixels = {};
+  int keyframeIndex = -1;
+  int framesSinceKeyframe = 0;
+  std::unique_ptr<MappedFile> mappedFile = nullptr;
+  std::atomic_bool fileMapped = {false};
+  std::mutex keyframeLocker = {};
+  std::shared_ptr<DecodedKeyframe> decodedKeyframe = nullptr;
 
   static std::shared_ptr<SequenceFile> Open(const std::string& filePath,
                                             const tgfx::ImageInfo& info, int frameCount,
                                             float frameRate,
-                                            const std::vector<TimeRange>& staticTimeRanges);
+                                            const std::vector<TimeRange>& staticTimeRanges,
+                                            PAGCompressionMode compressionMode);
 
   SequenceFile(const std::string& filePath, const tgfx::ImageInfo& info, int frameCount,
-               float frameRate, std::vector<TimeRange> staticTimeRanges);
+               float frameRate, std::vector<TimeRange> staticTimeRanges,
+               PAGCompressionMode compressionMode);
 
   bool readFramesFromFile();
   bool writeFileHead();
-  size_t compressFrame(int index, const void* pixels, size_t byteSize);
+  uint32_t frameHeadSize() const;
+  bool writeCompressedFrame(int index, const uint8_t* pixels, FrameLocation* location);
+  size_t compressFrame(int index, const uint8_t* pixels, FrameLocation* location);
+  size_t compressDeltaFrame(int index, const uint8_t* pixels, FrameLocation* location);
   bool checkScratchBuffer();
+  void mapFileIfComplete();
+  const uint8_t* readFrameBytes(const FrameLocation& frame);
+  bool decodeFrame(int index, const LZ4Decoder* frameDecoder,
+                   std::shared_ptr<BitmapBuffer> bitmap);
+  bool decodeKeyframe(uint32_t index, const LZ4Decoder* frameDecoder,
+                      std::shared_ptr<BitmapBuffer> bitmap);
+  bool decodeDeltaFrame(const LZ4Decoder* frameDecoder, const FrameLocation& frame,
+                        const uint8_t* bytes, std::shared_ptr<BitmapBuffer> bitmap);
   bool compatible(const tgfx::ImageInfo& info, int frameCount, float frameRate,
                   const std::vector<TimeRange>& staticTimeRanges);
 
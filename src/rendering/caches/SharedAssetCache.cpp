@@ -0,0 +1,145 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SharedAssetCache.h"
+#include "pag/pag.h"
+
+namespace pag {
+class SharedAsset {
+ public:
+  SharedAsset(uint64_t key, std::shared_ptr<tgfx::Image> image, size_t memoryUsage)
+      : key(key), image(std::move(image)), memoryUsage(memoryUsage) {
+  }
+
+  uint64_t key = 0;
+  std::shared_ptr<tgfx::Image> image = nullptr;
+  size_t memoryUsage = 0;
+  int refCount = 0;
+  std::list<std::shared_ptr<SharedAsset>>::iterator position = {};
+};
+
+static uint64_t MakeAssetKey(ID assetID, bool mipmapped) {
+  return (static_cast<uint64_t>(assetID) << 1) | static_cast<uint64_t>(mipmapped);
+}
+
+static size_t EstimateMemoryUsage(const tgfx::Image* image, bool mipmapped) {
+  auto size = static_cast<size_t>(image->width()) * static_cast<size_t>(image->height()) * 4;
+  // The mipmap levels take up one third of the base level in total.
+  return mipmapped ? size * 4 / 3 : size;
+}
+
+SharedAssetCache* SharedAssetCache::GetInstance() {
+  static auto& sharedCache = *new SharedAssetCache();
+  return &sharedCache;
+}
+
+size_t SharedAssetCache::maxMemorySize() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return maxSize;
+}
+
+void SharedAssetCache::setMaxMemorySize(size_t size) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  maxSize = size;
+  purge(maxSize);
+}
+
+size_t SharedAssetCache::memoryUsage() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return usedSize;
+}
+
+std::shared_ptr<tgfx::Image> SharedAssetCache::retain(ID assetID, bool mipmapped) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return retainLocked(MakeAssetKey(assetID, mipmapped));
+}
+
+std::shared_ptr<tgfx::Image> SharedAssetCache::add(ID assetID, bool mipmapped,
+                                                   std::shared_ptr<tgfx::Image> image) {
+  if (image == nullptr) {
+    return nullptr;
+  }
+  auto key = MakeAssetKey(assetID, mipmapped);
+  std::lock_guard<std::mutex> autoLock(locker);
+  if (auto cachedImage = retainLocked(key)) {
+    return cachedImage;
+  }
+  auto memoryUsage = EstimateMemoryUsage(image.get(), mipmapped);
+  auto asset = std::make_shared<SharedAsset>(key, image, memoryUsage);
+  asset->refCount = 1;
+  assetMap[key] = asset;
+  usedSize += memoryUsage;
+  return image;
+}
+
+void SharedAssetCache::release(ID assetID, bool mipmapped) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  auto result = assetMap.find(MakeAssetKey(assetID, mipmapped));
+  if (result == assetMap.end()) {
+    return;
+  }
+  auto& asset = result->second;
+  if (--asset->refCount > 0) {
+    return;
+  }
+  unusedAssets.push_front(asset);
+  asset->position = unusedAssets.begin();
+  unusedSize += asset->memoryUsage;
+  purge(maxSize);
+}
+
+void SharedAssetCache::removeUnusedAssets() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  purge(0);
+}
+
+std::shared_ptr<tgfx::Image> SharedAssetCache::retainLocked(uint64_t key) {
+  auto result = assetMap.find(key);
+  if (result == assetMap.end()) {
+    return nullptr;
+  }
+  auto& asset = result->second;
+  if (asset->refCount++ == 0) {
+    unusedSize -= asset->memoryUsage;
+    unusedAssets.erase(asset->position);
+  }
+  return asset->image;
+}
+
+void SharedAssetCache::purge(size_t limit) {
+  while (unusedSize > limit && !unusedAssets.empty()) {
+    auto& asset = unusedAssets.back();
+    unusedSize -= asset->memoryUsage;
+    usedSize -= asset->memoryUsage;
+    assetMap.erase(asset->key);
+    unusedAssets.pop_back();
+  }
+}
+
+size_t PAGAssetCache::MaxMemorySize() {
+  return SharedAssetCache::GetInstance()->maxMemorySize();
+}
+
+void PAGAssetCache::SetMaxMemorySize(size_t size) {
+  SharedAssetCache::GetInstance()->setMaxMemorySize(size);
+}
+
+size_t PAGAssetCache::MemoryUsage() {
+  return SharedAssetCache::GetInstance()->memoryUsage();
+}
+}  // namespace pag
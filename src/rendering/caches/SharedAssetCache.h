@@ -0,0 +1,95 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "pag/types.h"
+#include "tgfx/core/Image.h"
+
+namespace pag {
+class SharedAsset;
+
+/**
+ * SharedAssetCache holds the asset images shared by all the players that enable the shared asset
+ * cache, so that the players showing the same file or the same PAGImage decode and upload each
+ * image only once. Images are keyed by the asset ID and whether they are mipmapped, and are
+ * reference counted by the players using them. Images no longer referenced stay in memory until
+ * the total size exceeds the memory limit, and then they are evicted in least recently used order.
+ */
+class SharedAssetCache {
+ public:
+  static SharedAssetCache* GetInstance();
+
+  /**
+   * Returns the memory limit in bytes of the images no longer referenced by any player. The
+   * default value is 64 MB.
+   */
+  size_t maxMemorySize();
+
+  /**
+   * Sets the memory limit in bytes, the unreferenced images exceeding the limit are evicted
+   * immediately.
+   */
+  void setMaxMemorySize(size_t size);
+
+  /**
+   * Returns the estimated total size in bytes of the decoded pixels of all cached images.
+   */
+  size_t memoryUsage();
+
+  /**
+   * Returns the cached image of the specified asset and adds a reference to it. Returns nullptr if
+   * the image is not cached.
+   */
+  std::shared_ptr<tgfx::Image> retain(ID assetID, bool mipmapped);
+
+  /**
+   * Caches the image for the specified asset and adds a reference to it. If another image has been
+   * cached for the asset in the meantime, that one is retained and returned instead.
+   */
+  std::shared_ptr<tgfx::Image> add(ID assetID, bool mipmapped, std::shared_ptr<tgfx::Image> image);
+
+  /**
+   * Removes a reference previously added by retain() or add().
+   */
+  void release(ID assetID, bool mipmapped);
+
+  /**
+   * Removes all images no longer referenced by any player immediately.
+   */
+  void removeUnusedAssets();
+
+ private:
+  std::mutex locker = {};
+  size_t maxSize = 67108864;  // 64 MB
+  size_t usedSize = 0;
+  size_t unusedSize = 0;
+  std::unordered_map<uint64_t, std::shared_ptr<SharedAsset>> assetMap = {};
+  /**
+   * The images no longer referenced ordered from the most recently used to the least recently
+   * used. Referenced images can not be evicted, so they are kept out of this list.
+   */
+  std::list<std::shared_ptr<SharedAsset>> unusedAssets = {};
+
+  std::shared_ptr<tgfx::Image> retainLocked(uint64_t key);
+  void purge(size_t limit);
+};
+}  // namespace pag
@@ -19,31 +19,9 @@
 #include "TextAtlas.h"
 #include "RenderCache.h"
 #include "tgfx/core/Canvas.h"
-#include "tgfx/core/Mask.h"
 #include "tgfx/core/Surface.h"
 
 namespace pag {
-class Atlas {
- public:
-  static std::unique_ptr<Atlas> Make(tgfx::Context* context, const std::vector<GlyphHandle>& glyphs,
-                                     int maxPageSize, bool alphaOnly = true);
-
-  bool getLocator(const tgfx::BytesKey& bytesKey, AtlasLocator* locator) const;
-
-  size_t memoryUsage() const;
-
- private:
-  Atlas(std::vector<std::shared_ptr<tgfx::Image>> images,
-        tgfx::BytesKeyMap<AtlasLocator> glyphLocators)
-      : images(std::move(images)), glyphLocators(std::move(glyphLocators)) {
-  }
-
-  std::vector<std::shared_ptr<tgfx::Image>> images;
-  tgfx::BytesKeyMap<AtlasLocator> glyphLocators;
-
-  friend class TextAtlas;
-};
-
 static constexpr int DefaultPadding = 3;
 
 class RectanglePack {
@@ -103,18 +81,6 @@ class RectanglePack {
   int y = 0;
 };
 
-size_t Atlas::memoryUsage() const {
-  if (images.empty()) {
-    return 0;
-  }
-  size_t usage = 0;
-  for (auto& image : images) {
-    usage += image->width() * image->height();
-  }
-  auto bytesPerPixels = images[0]->isAlphaOnly() ? 1 : 4;
-  return usage * bytesPerPixels;
-}
-
 static tgfx::PaintStyle ToTGFX(TextStyle style) {
   switch (style) {
     case TextStyle::StrokeAndFill:
@@ -143,168 +109,176 @@ static AtlasTextRun CreateTextRun(const GlyphHandle& glyph) {
 }
 
 static void ComputeStyleKey(tgfx::BytesKey* styleKey, const GlyphHandle& glyph) {
+  auto& font = glyph->getFont();
   styleKey->write(static_cast<uint32_t>(glyph->getStyle()));
-  styleKey->write(glyph->getStrokeWidth());
-  auto typeface = glyph->getFont().getTypeface();
+  styleKey->write(glyph->getStyle() == TextStyle::Stroke ? glyph->getStrokeWidth() : 0.f);
+  styleKey->write(font.getSize());
+  uint32_t fauxFlags = (font.isFauxBold() ? 1 : 0) | (font.isFauxItalic() ? 2 : 0);
+  styleKey->write(fauxFlags);
+  auto typeface = font.getTypeface();
   styleKey->write(typeface ? typeface->uniqueID() : 0);
 }
 
-struct Page {
-  std::vector<AtlasTextRun> textRuns;
-  int width = 0;
-  int height = 0;
-  tgfx::BytesKeyMap<AtlasLocator> locators;
-};
+class AtlasPage {
+ public:
+  explicit AtlasPage(int size) : size(size) {
+  }
 
-static std::vector<Page> CreatePages(const std::vector<GlyphHandle>& glyphs, int maxPageSize) {
-  std::vector<Page> pages = {};
-  std::vector<tgfx::BytesKey> styleKeys = {};
+  int size = 0;
+  std::shared_ptr<tgfx::Surface> surface = nullptr;
+  std::shared_ptr<tgfx::Image> image = nullptr;
+  RectanglePack pack;
+  // The glyphs added since the last flush, which are the only ones drawn into the page.
   std::vector<AtlasTextRun> textRuns = {};
-  int padding = DefaultPadding;
-  RectanglePack pack(padding);
-  Page page;
-  for (auto& glyph : glyphs) {
-    if (glyph->getName() == "\n" || glyph->getName() == " ") {
-      continue;
-    }
-    tgfx::BytesKey styleKey = {};
-    ComputeStyleKey(&styleKey, glyph);
-    auto iter = std::find(styleKeys.begin(), styleKeys.end(), styleKey);
-    AtlasTextRun* textRun;
-    if (iter == styleKeys.end()) {
-      styleKeys.push_back(styleKey);
-      textRuns.push_back(CreateTextRun(glyph));
-      textRun = &textRuns.back();
-    } else {
-      auto index = iter - styleKeys.begin();
-      textRun = &textRuns[index];
-    }
-    float strokeWidth = 0;
-    if (glyph->getStyle() == TextStyle::Stroke) {
-      strokeWidth = glyph->getStrokeWidth();
-    }
-    auto bounds = glyph->getBounds();
-    bounds.outset(strokeWidth, strokeWidth);
-    bounds.roundOut();
-    int width = static_cast<int>(bounds.width());
-    int height = static_cast<int>(bounds.height());
-    auto packWidth = pack.width();
-    auto packHeight = pack.height();
-    auto point = pack.addRect(width, height);
-    if (pack.width() > maxPageSize || pack.height() > maxPageSize) {
-      page.textRuns = std::move(textRuns);
-      page.width = packWidth;
-      page.height = packHeight;
-      pages.push_back(std::move(page));
-      styleKeys.clear();
-      textRuns = {};
-      page = {};
-      pack.reset();
-      point = pack.addRect(width, height);
+  tgfx::BytesKeyMap<size_t> textRunIndices = {};
+  std::vector<tgfx::BytesKey> glyphKeys = {};
+  int idleFrames = 0;
+};
+
+static bool DrawTextRuns(tgfx::Context* context, AtlasPage* page, bool alphaOnly) {
+  if (page->surface == nullptr) {
+    auto surface = tgfx::Surface::Make(context, page->size, page->size, alphaOnly);
+    if (surface == nullptr) {
+      LOGE("Atlas: create surface failed.");
+      return false;
     }
-    for (auto& glyphID : glyph->getGlyphIDs()) {
-      textRun->glyphIDs.push_back(glyphID);
-      textRun->positions.push_back({-bounds.x() + point.x, -bounds.y() + point.y});
+    // The image shares the texture of the surface, so the glyphs drawn into the page afterward
+    // update the same texture instead of creating a new one.
+    page->image = tgfx::Image::MakeFrom(context, surface->getBackendTexture());
+    if (page->image == nullptr) {
+      return false;
     }
-    AtlasLocator locator;
-    locator.imageIndex = pages.size();
-    locator.location = tgfx::Rect::MakeXYWH(point.x, point.y, static_cast<float>(width),
-                                            static_cast<float>(height));
-    locator.glyphBounds = bounds;
-    tgfx::BytesKey bytesKey;
-    glyph->computeAtlasKey(&bytesKey, glyph->getStyle());
-    page.locators[bytesKey] = locator;
+    page->surface = surface;
+  }
+  auto canvas = page->surface->getCanvas();
+  for (auto& textRun : page->textRuns) {
+    auto glyphs = textRun.glyphIDs.data();
+    auto positions = textRun.positions.data();
+    canvas->drawGlyphs(glyphs, positions, textRun.glyphIDs.size(), textRun.textFont, textRun.paint);
   }
-  page.textRuns = std::move(textRuns);
-  page.width = pack.width();
-  page.height = pack.height();
-  pages.push_back(std::move(page));
-  return pages;
+  page->textRuns = {};
+  page->textRunIndices = {};
+  return true;
 }
 
-std::shared_ptr<tgfx::Image> DrawMask(tgfx::Context* context, const Page& page) {
-  auto mask = tgfx::Mask::Make(page.width, page.height);
-  if (mask == nullptr) {
-    LOGE("Atlas: create mask failed.");
-    return nullptr;
+std::shared_ptr<AtlasPage> GlyphAtlas::addGlyph(const GlyphHandle& glyph, int pageSize,
+                                                AtlasLocator* locator) {
+  tgfx::BytesKey styleKey = {};
+  ComputeStyleKey(&styleKey, glyph);
+  auto glyphKey = styleKey;
+  glyph->computeAtlasKey(&glyphKey, glyph->getStyle());
+  auto result = glyphLocators.find(glyphKey);
+  if (result != glyphLocators.end()) {
+    *locator = result->second.second;
+    return result->second.first.lock();
+  }
+  float strokeWidth = 0;
+  if (glyph->getStyle() == TextStyle::Stroke) {
+    strokeWidth = glyph->getStrokeWidth();
   }
-  for (auto& textRun : page.textRuns) {
-    auto blob = tgfx::TextBlob::MakeFrom(textRun.glyphIDs.data(), textRun.positions.data(),
-                                         textRun.glyphIDs.size(), textRun.textFont);
-    if (textRun.paint.getStyle() == tgfx::PaintStyle::Fill) {
-      mask->fillText(blob.get());
+  auto bounds = glyph->getBounds();
+  bounds.outset(strokeWidth, strokeWidth);
+  bounds.roundOut();
+  int width = static_cast<int>(bounds.width());
+  int height = static_cast<int>(bounds.height());
+  // Only the last page accepts new glyphs, the pages before it are full and never drawn again.
+  auto page = pages.empty() ? nullptr : pages.back();
+  auto point = Point::Zero();
+  if (page != nullptr) {
+    auto pack = page->pack;
+    point = pack.addRect(width, height);
+    if (pack.width() > page->size || pack.height() > page->size) {
+      page = nullptr;
     } else {
-      mask->fillText(blob.get(), textRun.paint.getStroke());
+      page->pack = pack;
     }
   }
-  auto maskImage = tgfx::Image::MakeFrom(mask->makeBuffer());
-  return maskImage->makeTextureImage(context);
-}
-
-std::shared_ptr<tgfx::Image> DrawColor(tgfx::Context* context, const Page& page) {
-  auto surface = tgfx::Surface::Make(context, page.width, page.height);
-  if (surface == nullptr) {
-    return nullptr;
+  if (page == nullptr) {
+    page = std::make_shared<AtlasPage>(pageSize);
+    point = page->pack.addRect(width, height);
+    if (page->pack.width() > pageSize || page->pack.height() > pageSize) {
+      return nullptr;
+    }
+    pages.push_back(page);
   }
-  auto canvas = surface->getCanvas();
-  auto totalMatrix = canvas->getMatrix();
-  for (auto& textRun : page.textRuns) {
-    canvas->setMatrix(totalMatrix);
-    auto glyphs = textRun.glyphIDs.data();
-    auto positions = textRun.positions.data();
-    canvas->drawGlyphs(glyphs, positions, textRun.glyphIDs.size(), textRun.textFont, textRun.paint);
+  AtlasTextRun* textRun;
+  auto runIndex = page->textRunIndices.find(styleKey);
+  if (runIndex == page->textRunIndices.end()) {
+    page->textRunIndices[styleKey] = page->textRuns.size();
+    page->textRuns.push_back(CreateTextRun(glyph));
+    textRun = &page->textRuns.back();
+  } else {
+    textRun = &page->textRuns[runIndex->second];
+  }
+  for (auto& glyphID : glyph->getGlyphIDs()) {
+    textRun->glyphIDs.push_back(glyphID);
+    textRun->positions.push_back({-bounds.x() + point.x, -bounds.y() + point.y});
   }
-  canvas->setMatrix(totalMatrix);
-  return surface->makeImageSnapshot();
+  locator->imageIndex = 0;
+  locator->location = tgfx::Rect::MakeXYWH(point.x, point.y, static_cast<float>(width),
+                                           static_cast<float>(height));
+  locator->glyphBounds = bounds;
+  page->glyphKeys.push_back(glyphKey);
+  glyphLocators[glyphKey] = {page, *locator};
+  return page;
 }
 
-static std::vector<std::shared_ptr<tgfx::Image>> DrawPages(tgfx::Context* context,
-                                                           std::vector<Page>* pages,
-                                                           bool alphaOnly) {
-  std::vector<std::shared_ptr<tgfx::Image>> images;
-  for (auto& page : *pages) {
-    auto image = alphaOnly ? DrawMask(context, page) : DrawColor(context, page);
-    if (image) {
-      images.push_back(image);
+void GlyphAtlas::flush(tgfx::Context* context) {
+  for (auto& page : pages) {
+    if (page->textRuns.empty()) {
+      continue;
+    }
+    if (!DrawTextRuns(context, page.get(), alphaOnly)) {
+      page->image = nullptr;
     }
   }
-  return images;
 }
 
-std::unique_ptr<Atlas> Atlas::Make(tgfx::Context* context, const std::vector<GlyphHandle>& glyphs,
-                                   int maxPageSize, bool alphaOnly) {
-  if (glyphs.empty()) {
-    return nullptr;
-  }
-  auto pages = CreatePages(glyphs, maxPageSize);
-  if (pages.empty()) {
-    return nullptr;
-  }
-  tgfx::BytesKeyMap<AtlasLocator> glyphLocators;
-  for (const auto& page : pages) {
-    glyphLocators.insert(page.locators.begin(), page.locators.end());
+size_t GlyphAtlas::purgeExpiredPages(int expiredFrames) {
+  size_t releaseMemory = 0;
+  auto bytesPerPixel = alphaOnly ? 1 : 4;
+  for (auto iter = pages.begin(); iter != pages.end();) {
+    auto& page = *iter;
+    // The GlyphAtlas holds the only reference if no TextAtlas is using the page.
+    if (page.use_count() > 1) {
+      page->idleFrames = 0;
+      iter++;
+      continue;
+    }
+    if (page->idleFrames++ < expiredFrames) {
+      iter++;
+      continue;
+    }
+    if (page->image) {
+      releaseMemory += page->image->width() * page->image->height() * bytesPerPixel;
+    }
+    for (auto& glyphKey : page->glyphKeys) {
+      glyphLocators.erase(glyphKey);
+    }
+    iter = pages.erase(iter);
   }
-  auto images = DrawPages(context, &pages, alphaOnly);
-  return std::unique_ptr<Atlas>(new Atlas(std::move(images), std::move(glyphLocators)));
+  return releaseMemory;
 }
 
-bool Atlas::getLocator(const tgfx::BytesKey& bytesKey, AtlasLocator* locator) const {
-  auto iter = glyphLocators.find(bytesKey);
-  if (iter == glyphLocators.end()) {
-    return false;
-  }
-  if (locator) {
-    *locator = iter->second;
+size_t GlyphAtlas::memoryUsage() const {
+  size_t usage = 0;
+  for (auto& page : pages) {
+    if (page->image) {
+      usage += page->image->width() * page->image->height();
+    }
   }
-  return true;
+  return usage * (alphaOnly ? 1 : 4);
 }
 
 static constexpr float MaxAtlasFontSize = 256.f;
+// The pages are allocated at their full size up front, so they are updated in place when new
+// glyphs are appended.
+static constexpr int MaxAtlasPageSize = 1024;
 
-std::unique_ptr<TextAtlas> TextAtlas::Make(const TextBlock* textBlock, RenderCache* renderCache,
+std::unique_ptr<TextAtlas> TextAtlas::Make(const TextBlock* textBlock, tgfx::Context* context,
+                                           GlyphAtlas* maskAtlas, GlyphAtlas* colorAtlas,
                                            float scale) {
-  auto context = renderCache->getContext();
-  auto maxPageSize = context->caps()->maxTextureSize;
+  auto pageSize = std::min(context->caps()->maxTextureSize, MaxAtlasPageSize);
   auto maxScale = scale * textBlock->maxScale();
   auto maskGlyphs = textBlock->maskAtlasGlyphs(maxScale);
   if (maskGlyphs.empty() || maskGlyphs[0]->getFont().getSize() > MaxAtlasFontSize) {
@@ -314,47 +288,59 @@ std::unique_ptr<TextAtlas> TextAtlas::Make(const TextBlock* textBlock, RenderCac
   if (!colorGlyphs.empty() && colorGlyphs[0]->getFont().getSize() > MaxAtlasFontSize) {
     return nullptr;
   }
-  auto maskAtlas = Atlas::Make(context, maskGlyphs, maxPageSize).release();
-  if (maskAtlas == nullptr) {
+  auto textAtlas = std::unique_ptr<TextAtlas>(new TextAtlas(textBlock->id(), scale, maxScale));
+  if (!textAtlas->addGlyphs(maskGlyphs, maskAtlas, pageSize) ||
+      !textAtlas->addGlyphs(colorGlyphs, colorAtlas, pageSize)) {
     return nullptr;
   }
-  auto colorAtlas = Atlas::Make(context, colorGlyphs, maxPageSize, false).release();
-  return std::unique_ptr<TextAtlas>(
-      new TextAtlas(textBlock->id(), maskAtlas, colorAtlas, scale, maxScale));
+  maskAtlas->flush(context);
+  colorAtlas->flush(context);
+  for (auto& page : textAtlas->pages) {
+    if (page->image == nullptr) {
+      return nullptr;
+    }
+  }
+  return textAtlas;
 }
 
-TextAtlas::~TextAtlas() {
-  delete maskAtlas;
-  delete colorAtlas;
+bool TextAtlas::addGlyphs(const std::vector<GlyphHandle>& glyphs, GlyphAtlas* glyphAtlas,
+                          int pageSize) {
+  for (auto& glyph : glyphs) {
+    if (glyph->getName() == "\n" || glyph->getName() == " ") {
+      continue;
+    }
+    AtlasLocator locator;
+    auto page = glyphAtlas->addGlyph(glyph, pageSize, &locator);
+    if (page == nullptr) {
+      return false;
+    }
+    auto iter = std::find(pages.begin(), pages.end(), page);
+    locator.imageIndex = iter - pages.begin();
+    if (iter == pages.end()) {
+      pages.push_back(page);
+    }
+    tgfx::BytesKey bytesKey;
+    glyph->computeAtlasKey(&bytesKey, glyph->getStyle());
+    glyphLocators[bytesKey] = locator;
+  }
+  return true;
 }
 
 bool TextAtlas::getLocator(const tgfx::BytesKey& bytesKey, AtlasLocator* locator) const {
-  if (colorAtlas && colorAtlas->getLocator(bytesKey, locator)) {
-    locator->imageIndex += maskAtlas->images.size();
-    return true;
+  auto iter = glyphLocators.find(bytesKey);
+  if (iter == glyphLocators.end()) {
+    return false;
+  }
+  if (locator) {
+    *locator = iter->second;
   }
-  return maskAtlas->getLocator(bytesKey, locator);
+  return true;
 }
 
 std::shared_ptr<tgfx::Image> TextAtlas::getAtlasImage(size_t imageIndex) const {
-  if (imageIndex < maskAtlas->images.size()) {
-    return maskAtlas->images[imageIndex];
-  }
-  imageIndex = imageIndex - maskAtlas->images.size();
-  if (colorAtlas && imageIndex < colorAtlas->images.size()) {
-    return colorAtlas->images[imageIndex];
+  if (imageIndex < pages.size()) {
+    return pages[imageIndex]->image;
   }
   return nullptr;
 }
-
-size_t TextAtlas::memoryUsage() const {
-  size_t usage = 0;
-  if (maskAtlas) {
-    usage += maskAtlas->memoryUsage();
-  }
-  if (colorAtlas) {
-    usage += colorAtlas->memoryUsage();
-  }
-  return usage;
-}
 }  // namespace pag
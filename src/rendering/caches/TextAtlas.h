@@ -24,8 +24,7 @@
 #include "tgfx/core/Image.h"
 
 namespace pag {
-class RenderCache;
-class Atlas;
+class AtlasPage;
 
 struct AtlasLocator {
   size_t imageIndex = 0;
@@ -33,13 +32,59 @@ struct AtlasLocator {
   tgfx::Rect glyphBounds = tgfx::Rect::MakeEmpty();
 };
 
+/**
+ * GlyphAtlas packs the glyphs of all text layers into pages shared across layers and frames.
+ * Glyphs are keyed by their typeface, font size and paint style, so the text layers using the same
+ * font draw from the same pages. Each page is a fixed-size surface, new glyphs are appended to the
+ * last page and drawn into its existing texture, and pages are evicted as a whole once no
+ * TextAtlas references them.
+ */
+class GlyphAtlas {
+ public:
+  explicit GlyphAtlas(bool alphaOnly = true) : alphaOnly(alphaOnly) {
+  }
+
+  /**
+   * Returns the page containing the specified glyph, appending the glyph to the last page if it is
+   * not in the atlas yet. New pages are created with the specified size. Returns nullptr if the
+   * glyph is larger than a page. The imageIndex of the returned locator is always 0.
+   */
+  std::shared_ptr<AtlasPage> addGlyph(const GlyphHandle& glyph, int pageSize,
+                                      AtlasLocator* locator);
+
+  /**
+   * Draws the glyphs appended since the last flush into their pages.
+   */
+  void flush(tgfx::Context* context);
+
+  /**
+   * Frees the pages that have not been referenced by any TextAtlas for more than the specified
+   * number of calls. Returns the size of the freed memory.
+   */
+  size_t purgeExpiredPages(int expiredFrames);
+
+  size_t pageCount() const {
+    return pages.size();
+  }
+
+  size_t memoryUsage() const;
+
+ private:
+  bool alphaOnly = true;
+  std::vector<std::shared_ptr<AtlasPage>> pages;
+  tgfx::BytesKeyMap<std::pair<std::weak_ptr<AtlasPage>, AtlasLocator>> glyphLocators;
+};
+
+/**
+ * TextAtlas is the view of a TextBlock into the shared GlyphAtlases, it maps the glyphs of the
+ * TextBlock to the pages they are packed in.
+ */
 class TextAtlas {
  public:
-  static std::unique_ptr<TextAtlas> Make(const TextBlock* textBlock, RenderCache* renderCache,
+  static std::unique_ptr<TextAtlas> Make(const TextBlock* textBlock, tgfx::Context* context,
+                                         GlyphAtlas* maskAtlas, GlyphAtlas* colorAtlas,
                                          float scale);
 
-  ~TextAtlas();
-
   ID textGlyphsID() const {
     return _textGlyphsID;
   }
@@ -56,17 +101,16 @@ class TextAtlas {
     return _totalScale;
   }
 
-  size_t memoryUsage() const;
-
  private:
-  TextAtlas(ID textGlyphsID, Atlas* maskAtlas, Atlas* colorAtlas, float scale, float totalScale)
-      : _textGlyphsID(textGlyphsID), maskAtlas(maskAtlas), colorAtlas(colorAtlas), scale(scale),
-        _totalScale(totalScale) {
+  TextAtlas(ID textGlyphsID, float scale, float totalScale)
+      : _textGlyphsID(textGlyphsID), scale(scale), _totalScale(totalScale) {
   }
 
+  bool addGlyphs(const std::vector<GlyphHandle>& glyphs, GlyphAtlas* glyphAtlas, int pageSize);
+
   ID _textGlyphsID = 0;
-  Atlas* maskAtlas = nullptr;
-  Atlas* colorAtlas = nullptr;
+  std::vector<std::shared_ptr<AtlasPage>> pages;
+  tgfx::BytesKeyMap<AtlasLocator> glyphLocators;
   float scale = 1.0f;
   float _totalScale = 1.f;
 };
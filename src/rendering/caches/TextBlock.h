@@ -47,7 +47,7 @@ class TextBlock {
     return _maxScale;
   }
 
-  std::vector<std::vector<GlyphHandle>> lines() const {
+  const std::vector<std::vector<GlyphHandle>>& lines() const {
     return _lines;
   }
 
@@ -118,14 +118,25 @@ ID TextContentCache::getCacheID() const {
 
 static std::vector<std::vector<GlyphHandle>> CopyLines(
     const std::shared_ptr<TextBlock>& textBlock) {
+  // All glyphs of a frame are copied into one contiguous arena, and the handles share the
+  // ownership of the arena, which saves a heap allocation for each glyph.
+  auto& lines = textBlock->lines();
+  size_t glyphCount = 0;
+  for (const auto& line : lines) {
+    glyphCount += line.size();
+  }
+  auto arena = std::make_shared<std::vector<Glyph>>();
+  arena->reserve(glyphCount);
   std::vector<std::vector<GlyphHandle>> glyphLines;
-  for (const auto& line : textBlock->lines()) {
+  glyphLines.reserve(lines.size());
+  for (const auto& line : lines) {
     std::vector<GlyphHandle> glyphLine;
     glyphLine.reserve(line.size());
     for (const auto& glyph : line) {
-      glyphLine.emplace_back(std::make_shared<Glyph>(*glyph));
+      arena->push_back(*glyph);
+      glyphLine.emplace_back(arena, &arena->back());
     }
-    glyphLines.emplace_back(glyphLine);
+    glyphLines.emplace_back(std::move(glyphLine));
   }
   return glyphLines;
 }
@@ -37,8 +37,14 @@ void BitmapDrawable::setBitmap(std::shared_ptr<BitmapBuffer> buffer) {
   if (bitmap == buffer) {
     return;
   }
-  bitmap = buffer;
-  freeSurface();
+  auto oldHardwareBuffer = bitmap != nullptr ? bitmap->getHardwareBuffer() : nullptr;
+  auto newHardwareBuffer = buffer != nullptr ? buffer->getHardwareBuffer() : nullptr;
+  bitmap = std::move(buffer);
+  // The offscreen surface and its contents are kept across the raster bitmaps, which are only the
+  // destinations of the readback. Only the surfaces wrapping hardware buffers are recreated.
+  if (oldHardwareBuffer != newHardwareBuffer) {
+    freeSurface();
+  }
 }
 
 void BitmapDrawable::present(tgfx::Context* context) {
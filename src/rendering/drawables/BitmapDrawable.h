@@ -38,6 +38,10 @@ class BitmapDrawable : public Drawable {
     return device;
   }
 
+  bool preservesContents() const override {
+    return true;
+  }
+
   void present(tgfx::Context* context) override;
 
   void setBitmap(std::shared_ptr<BitmapBuffer> buffer);
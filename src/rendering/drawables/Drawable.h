@@ -33,6 +33,15 @@ class Drawable {
 
   virtual std::shared_ptr<tgfx::Device> getDevice() = 0;
 
+  /**
+   * Returns true if the surface keeps its pixels from the last frame, which allows redrawing only
+   * the dirty regions of the next frame. Window surfaces usually return false since their back
+   * buffers are undefined after presenting.
+   */
+  virtual bool preservesContents() const {
+    return false;
+  }
+
   virtual std::shared_ptr<tgfx::Surface> getSurface(tgfx::Context* context, bool queryOnly);
 
   virtual std::shared_ptr<tgfx::Surface> getFrontSurface(tgfx::Context* context, bool queryOnly);
@@ -38,6 +38,10 @@ class OffscreenDrawable : public Drawable {
     return device;
   }
 
+  bool preservesContents() const override {
+    return true;
+  }
+
  protected:
   std::shared_ptr<tgfx::Surface> onCreateSurface(tgfx::Context* context) override;
 
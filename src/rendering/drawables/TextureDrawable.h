@@ -40,6 +40,10 @@ class TextureDrawable : public Drawable {
     return device;
   }
 
+  bool preservesContents() const override {
+    return true;
+  }
+
  protected:
   std::shared_ptr<tgfx::Surface> onCreateSurface(tgfx::Context* context) override;
 
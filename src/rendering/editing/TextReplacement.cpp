@@ -32,7 +32,7 @@ TextReplacement::~TextReplacement() {
   delete sourceText;
 }
 
-Content* TextReplacement::getContent(Frame contentFrame) {
+std::shared_ptr<Content> TextReplacement::getContent(Frame contentFrame) {
   if (textContentCache == nullptr) {
     auto textLayer = static_cast<TextLayer*>(pagLayer->layer);
     textContentCache = new TextContentCache(textLayer, pagLayer->uniqueID(), sourceText);
@@ -26,7 +26,7 @@ class TextReplacement {
   explicit TextReplacement(PAGTextLayer* textLayer);
   ~TextReplacement();
 
-  Content* getContent(Frame contentFrame);
+  std::shared_ptr<Content> getContent(Frame contentFrame);
 
   TextDocument* getTextDocument();
 
@@ -92,7 +92,7 @@ std::shared_ptr<Graphic> GetDisplacementMapGraphic(const DisplacementMapEffect*
   auto contentFrame = frame - mapLayer->startTime;
   auto layerCache = LayerCache::Get(mapLayer);
   auto content = layerCache->getContent(contentFrame);
-  return static_cast<GraphicContent*>(content)->graphic;
+  return std::static_pointer_cast<GraphicContent>(content)->graphic;
 }
 
 std::shared_ptr<tgfx::Image> DisplacementMapFilter::Apply(
@@ -59,7 +59,8 @@ void FilterModifier::prepare(RenderCache* renderCache) const {
     }
     auto mapEffect = static_cast<DisplacementMapEffect*>(effect);
     auto mapLayer = static_cast<PreComposeLayer*>(mapEffect->displacementMapLayer);
-    auto content = static_cast<GraphicContent*>(LayerCache::Get(mapLayer)->getContent(layerFrame));
+    auto content =
+        std::static_pointer_cast<GraphicContent>(LayerCache::Get(mapLayer)->getContent(layerFrame));
     content->graphic->prepare(renderCache);
   }
 }
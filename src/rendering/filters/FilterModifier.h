@@ -59,6 +59,12 @@ class FilterModifier : public Modifier {
 
   void applyToGraphic(Canvas* canvas, std::shared_ptr<Graphic> graphic) const override;
 
+  bool measureDirtyBounds(const Modifier*, tgfx::Rect*) const override {
+    // Some filters sample the contents far away from the output pixels, so the dirty regions of
+    // the contents can not be mapped through them.
+    return false;
+  }
+
   std::shared_ptr<Modifier> mergeWith(const Modifier*) const override {
     return nullptr;
   }
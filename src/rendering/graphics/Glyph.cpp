@@ -49,52 +49,59 @@ std::vector<GlyphHandle> Glyph::BuildFromText(const std::string& text, const tgf
 
 Glyph::Glyph(std::vector<tgfx::GlyphID> glyphIDs, std::string name, tgfx::Font font,
              bool isVertical, const TextPaint& textPaint)
-    : _glyphIDs(std::move(glyphIDs)), _name(std::move(name)), _font(std::move(font)),
-      _isVertical(isVertical) {
-  auto glyphID = _glyphIDs.front();
-  horizontalInfo->advance = _font.getAdvance(glyphID);
-  horizontalInfo->originPosition.set(horizontalInfo->advance / 2, 0);
-  horizontalInfo->bounds = _font.getBounds(glyphID);
-  auto metrics = _font.getMetrics();
-  if (horizontalInfo->bounds.isEmpty() && horizontalInfo->advance > 0) {
-    horizontalInfo->bounds.setLTRB(0, metrics.ascent, horizontalInfo->advance, metrics.descent);
+    : _isVertical(isVertical) {
+  auto glyphData = std::make_shared<Data>();
+  glyphData->glyphIDs = std::move(glyphIDs);
+  glyphData->name = std::move(name);
+  glyphData->font = std::move(font);
+  auto& glyphFont = glyphData->font;
+  auto& horizontalInfo = glyphData->horizontalInfo;
+  auto glyphID = glyphData->glyphIDs.front();
+  horizontalInfo.advance = glyphFont.getAdvance(glyphID);
+  horizontalInfo.originPosition.set(horizontalInfo.advance / 2, 0);
+  horizontalInfo.bounds = glyphFont.getBounds(glyphID);
+  auto metrics = glyphFont.getMetrics();
+  if (horizontalInfo.bounds.isEmpty() && horizontalInfo.advance > 0) {
+    horizontalInfo.bounds.setLTRB(0, metrics.ascent, horizontalInfo.advance, metrics.descent);
   }
-  horizontalInfo->ascent = metrics.ascent;
-  horizontalInfo->descent = metrics.descent;
-  if (_name == " ") {
+  horizontalInfo.ascent = metrics.ascent;
+  horizontalInfo.descent = metrics.descent;
+  if (glyphData->name == " ") {
     // 空格字符测量的 bounds 比较异常偏上，本身也不可见，这里直接按字幕 A 的上下边界调整一下。
-    auto AGlyphID = _font.getGlyphID("A");
+    auto AGlyphID = glyphFont.getGlyphID("A");
     if (AGlyphID > 0) {
-      auto ABounds = _font.getBounds(AGlyphID);
-      horizontalInfo->bounds.top = ABounds.top;
-      horizontalInfo->bounds.bottom = ABounds.bottom;
+      auto ABounds = glyphFont.getBounds(AGlyphID);
+      horizontalInfo.bounds.top = ABounds.top;
+      horizontalInfo.bounds.bottom = ABounds.bottom;
     }
   }
   if (isVertical) {
-    verticalInfo = std::make_shared<Info>(*horizontalInfo);
-    if (_name.size() == 1) {
+    auto& verticalInfo = glyphData->verticalInfo;
+    verticalInfo = horizontalInfo;
+    if (glyphData->name.size() == 1) {
       // 字母，数字，标点等字符旋转 90° 绘制，原先的水平 baseline 转为垂直 baseline，
       // 并水平向左偏移半个大写字母高度。
-      verticalInfo->extraMatrix.setRotate(90);
+      verticalInfo.extraMatrix.setRotate(90);
       auto offsetX = (metrics.capHeight + metrics.xHeight) * 0.25f;
-      verticalInfo->extraMatrix.postTranslate(-offsetX, 0);
-      verticalInfo->ascent += offsetX;
-      verticalInfo->descent += offsetX;
+      verticalInfo.extraMatrix.postTranslate(-offsetX, 0);
+      verticalInfo.ascent += offsetX;
+      verticalInfo.descent += offsetX;
     } else {
-      auto offset = _font.getVerticalOffset(glyphID);
-      verticalInfo->extraMatrix.postTranslate(offset.x, offset.y);
-      auto width = verticalInfo->advance;
-      verticalInfo->advance = _font.getAdvance(glyphID, true);
-      if (verticalInfo->advance == 0) {
-        verticalInfo->advance = width;
+      auto offset = glyphFont.getVerticalOffset(glyphID);
+      verticalInfo.extraMatrix.postTranslate(offset.x, offset.y);
+      auto width = verticalInfo.advance;
+      verticalInfo.advance = glyphFont.getAdvance(glyphID, true);
+      if (verticalInfo.advance == 0) {
+        verticalInfo.advance = width;
       }
-      verticalInfo->ascent = -width * 0.5f;
-      verticalInfo->descent = width * 0.5f;
+      verticalInfo.ascent = -width * 0.5f;
+      verticalInfo.descent = width * 0.5f;
     }
-    verticalInfo->originPosition.set(0, verticalInfo->advance / 2);
-    verticalInfo->extraMatrix.mapRect(&verticalInfo->bounds);
-    info = verticalInfo.get();
+    verticalInfo.originPosition.set(0, verticalInfo.advance / 2);
+    verticalInfo.extraMatrix.mapRect(&verticalInfo.bounds);
   }
+  data = std::move(glyphData);
+  info = isVertical ? &data->verticalInfo : &data->horizontalInfo;
   textStyle = textPaint.style;
   strokeOverFill = textPaint.strokeOverFill;
   fillColor = textPaint.fillColor;
@@ -144,21 +151,21 @@ std::shared_ptr<Glyph> Glyph::makeHorizontalGlyph() const {
   auto glyph = std::make_shared<Glyph>(*this);
   if (_isVertical) {
     glyph->_isVertical = false;
-    glyph->info = glyph->horizontalInfo.get();
-    glyph->verticalInfo = nullptr;
+    glyph->info = &data->horizontalInfo;
   }
   glyph->matrix = tgfx::Matrix::I();
   return glyph;
 }
 
 std::shared_ptr<Glyph> Glyph::makeScaledGlyph(float s) const {
-  auto scaledFont = _font.makeWithSize(_font.getSize() * s);
+  auto scaledFont = data->font.makeWithSize(data->font.getSize() * s);
   TextPaint textPaint;
   textPaint.style = textStyle;
   textPaint.strokeOverFill = strokeOverFill;
   textPaint.fillColor = fillColor;
   textPaint.strokeColor = strokeColor;
   textPaint.strokeWidth = strokeWidth * s;
-  return std::shared_ptr<Glyph>(new Glyph(_glyphIDs, _name, scaledFont, _isVertical, textPaint));
+  return std::shared_ptr<Glyph>(
+      new Glyph(data->glyphIDs, data->name, scaledFont, _isVertical, textPaint));
 }
 }  // namespace pag
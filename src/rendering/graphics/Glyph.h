@@ -60,15 +60,15 @@ class Glyph {
   /**
    * Returns the Font object associated with this Glyph.
    */
-  tgfx::Font getFont() const {
-    return _font;
+  const tgfx::Font& getFont() const {
+    return data->font;
   }
 
   /**
    * Returns the id of this glyph in associated typeface.
    */
   const std::vector<tgfx::GlyphID>& getGlyphIDs() const {
-    return _glyphIDs;
+    return data->glyphIDs;
   }
 
   /**
@@ -86,8 +86,8 @@ class Glyph {
   /**
    * Returns name of this glyph in utf8.
    */
-  std::string getName() const {
-    return _name;
+  const std::string& getName() const {
+    return data->name;
   }
 
   /**
@@ -123,7 +123,7 @@ class Glyph {
    * Returns the original bounding box relative to (0, 0) of this glyph.
    */
   const tgfx::Rect getOriginBounds() const {
-    return horizontalInfo->bounds;
+    return data->horizontalInfo.bounds;
   }
 
   /**
@@ -249,10 +249,21 @@ class Glyph {
     tgfx::Point originPosition = tgfx::Point::Make(0, 0);
   };
 
+  /**
+   * The read-only shaping results, which are shared by all copies of a glyph, so that copying a
+   * glyph for animating only copies the writable attributes.
+   */
+  struct Data {
+    std::vector<tgfx::GlyphID> glyphIDs = {};
+    std::string name;
+    tgfx::Font font;
+    Info horizontalInfo = {};
+    Info verticalInfo = {};
+  };
+
   // read only attributes:
-  std::vector<tgfx::GlyphID> _glyphIDs = {};
-  std::string _name;
-  tgfx::Font _font;
+  std::shared_ptr<const Data> data = nullptr;
+  const Info* info = nullptr;
   bool _isVertical = false;
   bool strokeOverFill = true;
   // writable attributes:
@@ -264,10 +275,6 @@ class Glyph {
   Color strokeColor = Black;
   float strokeWidth = 0;
 
-  std::shared_ptr<Info> horizontalInfo = std::make_shared<Info>();
-  std::shared_ptr<Info> verticalInfo;
-  const Info* info = horizontalInfo.get();
-
   Glyph(std::vector<tgfx::GlyphID> glyphIDs, std::string name, tgfx::Font font, bool isVertical,
         const TextPaint& textPaint);
 };
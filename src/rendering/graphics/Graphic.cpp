@@ -21,12 +21,23 @@
 #include "tgfx/core/Canvas.h"
 
 namespace pag {
+enum class ComposeType { Matrix, Layer, Modifier };
+
 class ComposeGraphic : public Graphic {
  public:
   GraphicType type() const override {
     return GraphicType::Compose;
   }
 
+  virtual ComposeType composeType() const = 0;
+
+  /**
+   * Compares this graphic with the old graphic of the same compose type, and joins the bounds of
+   * the regions where they differ into the dirty rect. Returns false if they can not be compared.
+   */
+  virtual bool measureDirtyBounds(const ComposeGraphic* oldGraphic,
+                                  tgfx::Rect* dirtyRect) const = 0;
+
   virtual std::shared_ptr<Graphic> mergeWith(const tgfx::Matrix&) const {
     return nullptr;
   }
@@ -43,6 +54,12 @@ class MatrixGraphic : public ComposeGraphic {
       : graphic(std::move(graphic)), matrix(matrix) {
   }
 
+  ComposeType composeType() const override {
+    return ComposeType::Matrix;
+  }
+
+  bool measureDirtyBounds(const ComposeGraphic* oldGraphic, tgfx::Rect* dirtyRect) const override;
+
   void measureBounds(tgfx::Rect* bounds) const override;
   bool hitTest(RenderCache* cache, float x, float y) override;
   bool getPath(tgfx::Path* path) const override;
@@ -55,6 +72,35 @@ class MatrixGraphic : public ComposeGraphic {
   tgfx::Matrix matrix = {};
 };
 
+static void JoinBounds(const Graphic* graphic, tgfx::Rect* dirtyRect) {
+  if (graphic == nullptr) {
+    return;
+  }
+  auto bounds = tgfx::Rect::MakeEmpty();
+  graphic->measureBounds(&bounds);
+  dirtyRect->join(bounds);
+}
+
+void Graphic::MeasureDirtyBounds(const Graphic* oldGraphic, const Graphic* newGraphic,
+                                 tgfx::Rect* dirtyRect) {
+  if (oldGraphic == newGraphic) {
+    return;
+  }
+  if (oldGraphic != nullptr && newGraphic != nullptr &&
+      oldGraphic->type() == GraphicType::Compose && newGraphic->type() == GraphicType::Compose) {
+    auto oldCompose = static_cast<const ComposeGraphic*>(oldGraphic);
+    auto newCompose = static_cast<const ComposeGraphic*>(newGraphic);
+    auto bounds = tgfx::Rect::MakeEmpty();
+    if (oldCompose->composeType() == newCompose->composeType() &&
+        newCompose->measureDirtyBounds(oldCompose, &bounds)) {
+      dirtyRect->join(bounds);
+      return;
+    }
+  }
+  JoinBounds(oldGraphic, dirtyRect);
+  JoinBounds(newGraphic, dirtyRect);
+}
+
 std::shared_ptr<Graphic> Graphic::MakeCompose(std::shared_ptr<Graphic> graphic,
                                               const tgfx::Matrix& matrix) {
   if (graphic == nullptr || !matrix.invertible()) {
@@ -106,6 +152,21 @@ void MatrixGraphic::draw(Canvas* canvas) const {
   canvas->restore();
 }
 
+bool MatrixGraphic::measureDirtyBounds(const ComposeGraphic* oldGraphic,
+                                       tgfx::Rect* dirtyRect) const {
+  auto target = static_cast<const MatrixGraphic*>(oldGraphic);
+  if (matrix != target->matrix) {
+    return false;
+  }
+  auto bounds = tgfx::Rect::MakeEmpty();
+  MeasureDirtyBounds(target->graphic.get(), graphic.get(), &bounds);
+  if (!bounds.isEmpty()) {
+    matrix.mapRect(&bounds);
+    dirtyRect->join(bounds);
+  }
+  return true;
+}
+
 std::shared_ptr<Graphic> MatrixGraphic::mergeWith(const tgfx::Matrix& m) const {
   auto totalMatrix = matrix;
   totalMatrix.postConcat(m);
@@ -123,6 +184,12 @@ class LayerGraphic : public ComposeGraphic {
       : contents(std::move(contents)) {
   }
 
+  ComposeType composeType() const override {
+    return ComposeType::Layer;
+  }
+
+  bool measureDirtyBounds(const ComposeGraphic* oldGraphic, tgfx::Rect* dirtyRect) const override;
+
   void measureBounds(tgfx::Rect* bounds) const override;
   bool hitTest(RenderCache* cache, float x, float y) override;
   bool getPath(tgfx::Path* path) const override;
@@ -193,6 +260,20 @@ void LayerGraphic::draw(Canvas* canvas) const {
   }
 }
 
+bool LayerGraphic::measureDirtyBounds(const ComposeGraphic* oldGraphic,
+                                      tgfx::Rect* dirtyRect) const {
+  auto target = static_cast<const LayerGraphic*>(oldGraphic);
+  if (contents.size() != target->contents.size()) {
+    return false;
+  }
+  // The contents are drawn in the same order, so redrawing all of them within the dirty regions
+  // keeps their stacking correct.
+  for (size_t i = 0; i < contents.size(); i++) {
+    MeasureDirtyBounds(target->contents[i].get(), contents[i].get(), dirtyRect);
+  }
+  return true;
+}
+
 std::shared_ptr<Graphic> LayerGraphic::mergeWith(const tgfx::Matrix& m) const {
   std::vector<std::shared_ptr<Graphic>> newContents = {};
   for (auto& graphic : contents) {
@@ -216,6 +297,12 @@ class ModifierGraphic : public ComposeGraphic {
       : graphic(std::move(graphic)), modifier(std::move(modifier)) {
   }
 
+  ComposeType composeType() const override {
+    return ComposeType::Modifier;
+  }
+
+  bool measureDirtyBounds(const ComposeGraphic* oldGraphic, tgfx::Rect* dirtyRect) const override;
+
   void measureBounds(tgfx::Rect* bounds) const override;
   bool hitTest(RenderCache* cache, float x, float y) override;
   bool getPath(tgfx::Path* path) const override;
@@ -280,6 +367,26 @@ void ModifierGraphic::draw(Canvas* canvas) const {
   canvas->restore();
 }
 
+bool ModifierGraphic::measureDirtyBounds(const ComposeGraphic* oldGraphic,
+                                         tgfx::Rect* dirtyRect) const {
+  auto target = static_cast<const ModifierGraphic*>(oldGraphic);
+  if (modifier->type() != target->modifier->type() ||
+      !modifier->measureDirtyBounds(target->modifier.get(), dirtyRect)) {
+    return false;
+  }
+  auto bounds = tgfx::Rect::MakeEmpty();
+  MeasureDirtyBounds(target->graphic.get(), graphic.get(), &bounds);
+  if (!bounds.isEmpty()) {
+    // The dirty contents are visible where either the old or the new modifier lets them through.
+    auto oldBounds = bounds;
+    target->modifier->applyToBounds(&oldBounds);
+    modifier->applyToBounds(&bounds);
+    dirtyRect->join(oldBounds);
+    dirtyRect->join(bounds);
+  }
+  return true;
+}
+
 std::shared_ptr<Graphic> ModifierGraphic::mergeWith(const Modifier* target) const {
   if (target == nullptr || modifier->type() != target->type()) {
     return nullptr;
@@ -61,6 +61,14 @@ class Graphic {
   static std::shared_ptr<Graphic> MakeCompose(std::shared_ptr<Graphic> graphic,
                                               std::shared_ptr<Modifier> modifier);
 
+  /**
+   * Compares the new Graphic with the old Graphic, and joins the bounds of the regions where they
+   * differ into the dirty rect. The contents shared by both Graphics are skipped without measuring.
+   * Either Graphic can be nullptr.
+   */
+  static void MeasureDirtyBounds(const Graphic* oldGraphic, const Graphic* newGraphic,
+                                 tgfx::Rect* dirtyRect);
+
   virtual ~Graphic() = default;
 
   /**
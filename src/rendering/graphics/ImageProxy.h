@@ -46,6 +46,15 @@ class ImageProxy {
    */
   virtual bool isTemporary() const = 0;
 
+  /**
+   * Returns true if the image made by the proxy can only be drawn on the GPU context it was made
+   * with, such as the images made from backend textures. These images are never shared between
+   * players.
+   */
+  virtual bool isContextBound() const {
+    return false;
+  }
+
   /**
    * Prepares the image for the next getImage() call.
    */
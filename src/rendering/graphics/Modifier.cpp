@@ -53,6 +53,11 @@ class BlendModifier : public Modifier {
 
   void applyToGraphic(Canvas* canvas, std::shared_ptr<Graphic> graphic) const override;
 
+  bool measureDirtyBounds(const Modifier* oldModifier, tgfx::Rect*) const override {
+    auto target = static_cast<const BlendModifier*>(oldModifier);
+    return alpha == target->alpha && blendMode == target->blendMode;
+  }
+
   std::shared_ptr<Modifier> mergeWith(const Modifier* modifier) const override;
 
  private:
@@ -87,6 +92,10 @@ class ClipModifier : public Modifier {
 
   void applyToGraphic(Canvas* canvas, std::shared_ptr<Graphic> graphic) const override;
 
+  bool measureDirtyBounds(const Modifier* oldModifier, tgfx::Rect*) const override {
+    return clip == static_cast<const ClipModifier*>(oldModifier)->clip;
+  }
+
   std::shared_ptr<Modifier> mergeWith(const Modifier* modifier) const override;
 
  private:
@@ -120,6 +129,8 @@ class MaskModifier : public Modifier {
 
   void applyToGraphic(Canvas* canvas, std::shared_ptr<Graphic> graphic) const override;
 
+  bool measureDirtyBounds(const Modifier* oldModifier, tgfx::Rect* dirtyRect) const override;
+
   std::shared_ptr<Modifier> mergeWith(const Modifier*) const override {
     return nullptr;
   }
@@ -245,6 +256,16 @@ void MaskModifier::applyToBounds(tgfx::Rect* bounds) const {
   }
 }
 
+bool MaskModifier::measureDirtyBounds(const Modifier* oldModifier, tgfx::Rect* dirtyRect) const {
+  auto target = static_cast<const MaskModifier*>(oldModifier);
+  if (inverted != target->inverted || useLuma != target->useLuma) {
+    return false;
+  }
+  // The contents are only affected differently where the masks differ.
+  Graphic::MeasureDirtyBounds(target->mask.get(), mask.get(), dirtyRect);
+  return true;
+}
+
 void MaskModifier::applyToGraphic(Canvas* canvas, std::shared_ptr<Graphic> graphic) const {
   if (mask == nullptr) {
     return;
@@ -74,6 +74,13 @@ class Modifier {
    */
   virtual void applyToGraphic(Canvas* canvas, std::shared_ptr<Graphic> graphic) const = 0;
 
+  /**
+   * Compares this modifier with the specified old modifier of the same type, and joins the bounds
+   * of the regions they affect differently into the dirty rect. Returns false if the two modifiers
+   * can not be compared, in which case all the contents they apply to are considered dirty.
+   */
+  virtual bool measureDirtyBounds(const Modifier* oldModifier, tgfx::Rect* dirtyRect) const = 0;
+
   /**
    * Returns a new modifier which is the combination of this modifier and specified modifier if this
    * modifier can be merged with specified modifier.
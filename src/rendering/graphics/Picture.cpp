@@ -270,6 +270,10 @@ class BackendTextureProxy : public ImageProxy {
     return false;
   }
 
+  bool isContextBound() const override {
+    return true;
+  }
+
   void prepareImage(RenderCache*) const override {
   }
 
@@ -19,6 +19,7 @@
 #include "base/utils/TimeUtil.h"
 #include "pag/file.h"
 #include "pag/pag.h"
+#include "rendering/caches/FrameCache.h"
 #include "rendering/utils/LockGuard.h"
 #include "rendering/utils/ScopedLock.h"
 
@@ -38,6 +39,20 @@ std::shared_ptr<PAGFile> PAGFile::Load(const std::string& filePath, const std::s
   return MakeFrom(file);
 }
 
+std::shared_ptr<PAGFile> PAGFile::LoadMapped(const std::string& filePath,
+                                             const std::string& password) {
+  auto file = File::LoadMapped(filePath, password);
+  return MakeFrom(file);
+}
+
+size_t PAGFile::MaxFrameCacheCount() {
+  return FrameCacheStats::MaxFrameCount();
+}
+
+void PAGFile::SetMaxFrameCacheCount(size_t count) {
+  FrameCacheStats::SetMaxFrameCount(count);
+}
+
 std::shared_ptr<PAGFile> PAGFile::MakeFrom(std::shared_ptr<File> file) {
   if (file == nullptr) {
     return nullptr;
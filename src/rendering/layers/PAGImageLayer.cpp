@@ -57,7 +57,6 @@ PAGImageLayer::PAGImageLayer(int width, int height, int64_t duration) : PAGLayer
 }
 
 PAGImageLayer::~PAGImageLayer() {
-  delete replacement;
   if (emptyImageLayer) {
     delete emptyImageLayer->imageBytes;
     delete emptyImageLayer;
@@ -200,10 +199,9 @@ void PAGImageLayer::setImageInternal(std::shared_ptr<PAGImage> image) {
   if (replacement != nullptr) {
     oldPAGImage = replacement->getImage();
   }
-  delete replacement;
   if (image != nullptr) {
-    replacement = new ImageReplacement(image, getDefaultScaleMode(),
-                                       static_cast<ImageLayer*>(layer)->imageBytes);
+    replacement = std::make_shared<ImageReplacement>(image, getDefaultScaleMode(),
+                                                     static_cast<ImageLayer*>(layer)->imageBytes);
   } else {
     replacement = nullptr;
   }
@@ -215,8 +213,11 @@ void PAGImageLayer::setImageInternal(std::shared_ptr<PAGImage> image) {
   invalidateCacheScale();
 }
 
-Content* PAGImageLayer::getContent() {
-  return hasPAGImage() ? replacement : layerCache->getContent(contentFrame);
+std::shared_ptr<Content> PAGImageLayer::getContent() {
+  if (hasPAGImage()) {
+    return replacement;
+  }
+  return layerCache->getContent(contentFrame);
 }
 
 bool PAGImageLayer::contentModified() const {
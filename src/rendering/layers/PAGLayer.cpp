@@ -458,7 +458,7 @@ bool PAGLayer::isPAGFile() const {
   return false;
 }
 
-Content* PAGLayer::getContent() {
+std::shared_ptr<Content> PAGLayer::getContent() {
   return layerCache->getContent(contentFrame);
 }
 
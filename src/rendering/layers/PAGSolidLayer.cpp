@@ -51,11 +51,10 @@ PAGSolidLayer::PAGSolidLayer(std::shared_ptr<pag::File> file, SolidLayer* layer)
 }
 
 PAGSolidLayer::~PAGSolidLayer() {
-  delete replacement;
   delete emptySolidLayer;
 }
 
-Content* PAGSolidLayer::getContent() {
+std::shared_ptr<Content> PAGSolidLayer::getContent() {
   if (replacement != nullptr) {
     return replacement;
   }
@@ -77,16 +76,13 @@ void PAGSolidLayer::setSolidColor(const pag::Color& value) {
     return;
   }
   _solidColor = value;
-  if (replacement != nullptr) {
-    delete replacement;
-    replacement = nullptr;
-  }
+  replacement = nullptr;
   auto solidLayer = static_cast<SolidLayer*>(layer);
   if (solidLayer->solidColor != _solidColor) {
     tgfx::Path path = {};
     path.addRect(0, 0, solidLayer->width, solidLayer->height);
     auto solid = Shape::MakeFrom(uniqueID(), path, ToTGFX(_solidColor));
-    replacement = new GraphicContent(solid);
+    replacement = std::make_shared<GraphicContent>(solid);
   }
   notifyModified(true);
   invalidateCacheScale();
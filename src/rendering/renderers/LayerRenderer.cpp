@@ -47,7 +47,13 @@ void LayerRenderer::DrawLayer(Recorder* recorder, Layer* layer, Frame layerFrame
   if (!layerCache->contentVisible(contentFrame)) {
     return;
   }
-  auto content = layerContent ? layerContent : layerCache->getContent(contentFrame);
+  // Holds the cached content while it is in use, in case it is evicted by another thread.
+  std::shared_ptr<Content> cacheContent = nullptr;
+  auto content = layerContent;
+  if (content == nullptr) {
+    cacheContent = layerCache->getContent(contentFrame);
+    content = cacheContent.get();
+  }
   auto layerTransform = layerCache->getTransform(contentFrame);
   auto alpha = layerTransform->alpha;
   if (extraTransform) {
@@ -116,7 +122,13 @@ void LayerRenderer::MeasureLayerBounds(tgfx::Rect* bounds, Layer* layer, Frame l
   if (!layerCache->contentVisible(contentFrame)) {
     return;
   }
-  auto content = layerContent ? layerContent : layerCache->getContent(contentFrame);
+  // Holds the cached content while it is in use, in case it is evicted by another thread.
+  std::shared_ptr<Content> cacheContent = nullptr;
+  auto content = layerContent;
+  if (content == nullptr) {
+    cacheContent = layerCache->getContent(contentFrame);
+    content = cacheContent.get();
+  }
   auto masks = layerCache->getMasks(contentFrame);
   content->measureBounds(bounds);
   if (masks) {
@@ -110,7 +110,7 @@ tgfx::Point TextAnimatorRenderer::GetPositionFromAnimators(
 TextAnimatorRenderer::TextAnimatorRenderer(const TextAnimator* animator,
                                            ParagraphJustification justification, size_t textCount,
                                            Frame frame)
-    : justification(justification) {
+    : justification(justification), textCount(textCount) {
   // 读取动画属性信息
   auto typographyProperties = animator->typographyProperties;
   if (typographyProperties != nullptr) {
@@ -178,15 +178,17 @@ void TextAnimatorRenderer::readTackingInfo(const TextAnimator* animator, Frame f
 
 // 应用动画
 void TextAnimatorRenderer::apply(std::vector<std::vector<GlyphHandle>>& glyphList) {
-  int index = 0;
+  // 一次性批量计算所有字符的范围因子，字间距和变换共用
+  auto factors = TextSelectorRenderer::CalculateFactorsFromSelectors(selectorRenderers, textCount);
+  size_t index = 0;
   for (auto& line : glyphList) {
-    int lineIndex = index;
-    int nextLineIndex = lineIndex + static_cast<int>(line.size());
-    auto trackingAnimatorLen = calculateTrackingLen(lineIndex, nextLineIndex);
+    auto lineIndex = index;
+    auto nextLineIndex = lineIndex + line.size();
+    auto trackingAnimatorLen = calculateTrackingLen(factors, lineIndex, nextLineIndex);
     auto offset = CalculateOffsetByJustification(justification, trackingAnimatorLen);
     for (auto& glyph : line) {
       auto matrix = glyph->getMatrix();
-      auto factor = calculateFactorByIndex(index, nullptr);
+      auto factor = factors[index];
       // 字间距
       if (index > lineIndex) {  // 行首不加字间距的before部分
         offset += trackingBefore * factor;
@@ -218,10 +220,11 @@ void TextAnimatorRenderer::apply(std::vector<std::vector<GlyphHandle>>& glyphLis
 }
 
 // 计算一行的字间距长度
-float TextAnimatorRenderer::calculateTrackingLen(size_t textStart, size_t textEnd) {
+float TextAnimatorRenderer::calculateTrackingLen(const std::vector<float>& factors,
+                                                 size_t textStart, size_t textEnd) {
   float animatorTrackingLen = 0.0f;
   for (size_t i = textStart; i < textEnd; i++) {
-    auto factor = calculateFactorByIndex(i, nullptr);
+    auto factor = factors[i];
     if (i > textStart) {  // 不计行首字母前面的间距
       animatorTrackingLen += trackingBefore * factor;
     }
@@ -43,7 +43,7 @@ class TextAnimatorRenderer {
   // 应用文本动画
   void apply(std::vector<std::vector<GlyphHandle>>& glyphList);
   // 计算一行的字间距总长度
-  float calculateTrackingLen(size_t textStart, size_t textEnd);
+  float calculateTrackingLen(const std::vector<float>& factors, size_t textStart, size_t textEnd);
   // 根据字符序号计算该字符的范围因子
   float calculateFactorByIndex(size_t index, bool* pBiasFlag);
   // 读取字间距信息
@@ -63,6 +63,7 @@ class TextAnimatorRenderer {
   float trackingAfter = 0.0f;   // 字间距-之后
 
   ParagraphJustification justification = ParagraphJustification::LeftJustify;
+  size_t textCount = 0;
 
   std::vector<TextSelectorRenderer*> selectorRenderers;
 };
@@ -38,6 +38,20 @@ float TextSelectorRenderer::CalculateFactorFromSelectors(
   return totalFactor;
 }
 
+std::vector<float> TextSelectorRenderer::CalculateFactorsFromSelectors(
+    const std::vector<TextSelectorRenderer*>& selectorRenderers, size_t textCount) {
+  std::vector<float> totalFactors(textCount, 1.0f);
+  std::vector<float> factors(textCount, 0.0f);
+  bool isFirstSelector = true;
+  for (auto selectorRenderer : selectorRenderers) {
+    selectorRenderer->calculateFactors(factors.data(), textCount);
+    selectorRenderer->overlayFactors(totalFactors.data(), factors.data(), textCount,
+                                     isFirstSelector);
+    isFirstSelector = false;
+  }
+  return totalFactors;
+}
+
 static float OverlayFactorByMode(float oldFactor, float factor, TextSelectorMode mode) {
   float newFactor;
   switch (mode) {
@@ -85,6 +99,57 @@ float TextSelectorRenderer::overlayFactor(float oldFactor, float factor, bool is
   return newFactor;
 }
 
+// 批量叠加选择器，每种模式单独一个循环，方便编译器做向量化
+void TextSelectorRenderer::overlayFactors(float* totalFactors, const float* factors, size_t count,
+                                          bool isFirstSelector) {
+  if (isFirstSelector && mode != TextSelectorMode::Subtract) {
+    std::copy(factors, factors + count, totalFactors);
+  } else {
+    switch (mode) {
+      case TextSelectorMode::Subtract:
+        for (size_t i = 0; i < count; i++) {
+          auto factor = factors[i];
+          totalFactors[i] *= factor >= 0.0f ? 1.0f - factor : -1.0f - factor;
+        }
+        break;
+      case TextSelectorMode::Intersect:
+        for (size_t i = 0; i < count; i++) {
+          totalFactors[i] *= factors[i];
+        }
+        break;
+      case TextSelectorMode::Min:
+        for (size_t i = 0; i < count; i++) {
+          totalFactors[i] = std::min(totalFactors[i], factors[i]);
+        }
+        break;
+      case TextSelectorMode::Max:
+        for (size_t i = 0; i < count; i++) {
+          totalFactors[i] = std::max(totalFactors[i], factors[i]);
+        }
+        break;
+      case TextSelectorMode::Difference:
+        for (size_t i = 0; i < count; i++) {
+          totalFactors[i] = std::fabs(totalFactors[i] - factors[i]);
+        }
+        break;
+      default:  // TextSelectorMode::Add:
+        for (size_t i = 0; i < count; i++) {
+          totalFactors[i] += factors[i];
+        }
+        break;
+    }
+  }
+  for (size_t i = 0; i < count; i++) {
+    totalFactors[i] = std::min(std::max(totalFactors[i], -1.0f), 1.0f);
+  }
+}
+
+void TextSelectorRenderer::calculateFactors(float* factors, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    factors[i] = calculateFactorByIndex(i, nullptr);
+  }
+}
+
 //
 // 因无法获取AE的随机策略，所以随机的具体值也和AE不一样，但因需要获取准确的FirtBaseline，
 // 而Position动画会影响插件里FirtBaseline的获取，所以我们需要得到第一个字符的准确位置，
@@ -168,24 +233,42 @@ float WigglySelectorRenderer::calculateFactorByIndex(size_t index, bool* pBiasFl
     return 0.0f;
   }
 
-  // 这里的公式离复原AE效果还有一定的距离。后续可优化。
-  // 经验值也需要优化.
-  auto temporalSeed = wigglesPerSecond / 2.0 * (frame + temporalPhase / 30.f) / 24.0f;
+  auto temporalSeed = calculateTemporalSeed();
+  auto factor = calculateFactorBySeed(calculateSeed(index, temporalSeed));
+  if (pBiasFlag != nullptr) {
+    *pBiasFlag = true;  // 摆动选择器计算有误差
+  }
+  return factor;
+}
+
+void WigglySelectorRenderer::calculateFactors(float* factors, size_t count) {
+  // 时间种子对所有字符都相同，只需计算一次
+  auto temporalSeed = calculateTemporalSeed();
+  for (size_t i = 0; i < count; i++) {
+    factors[i] = calculateFactorBySeed(calculateSeed(i, temporalSeed));
+  }
+}
+
+// 这里的公式离复原AE效果还有一定的距离。后续可优化。
+// 经验值也需要优化.
+double WigglySelectorRenderer::calculateTemporalSeed() const {
+  return wigglesPerSecond / 2.0 * (frame + temporalPhase / 30.f) / 24.0f;
+}
+
+double WigglySelectorRenderer::calculateSeed(size_t index, double temporalSeed) const {
   auto spatialSeed = (13.73f * (1.0f - correlation) * index + spatialPhase / 80.0f) / 21.13f;
-  auto seed = (spatialSeed + temporalSeed + randomSeed / 3.13f) * 2 * M_PI;
+  return (spatialSeed + temporalSeed + randomSeed / 3.13f) * 2 * M_PI;
+}
+
+float WigglySelectorRenderer::calculateFactorBySeed(double seed) const {
   auto factor = cos(seed) * cos(seed / 7 + M_PI / 5);
   if (factor < -1.0f) {
     factor = -1.0f;
   } else if (factor > 1.0f) {
     factor = 1.0f;
   }
-
   // 考虑"最大量"/"最小量"的影响
-  factor = (factor + 1.0f) / 2 * (maxAmount - minAmount) + minAmount;
-  if (pBiasFlag != nullptr) {
-    *pBiasFlag = true;  // 摆动选择器计算有误差
-  }
-  return factor;
+  return static_cast<float>((factor + 1.0f) / 2 * (maxAmount - minAmount) + minAmount);
 }
 
 // 读取范围选择器
@@ -276,27 +359,28 @@ static float CalculateRangeFactorRampDown(float textStart, float textEnd, float
 }
 
 // 范盛金公式求解一元三次方程 a * x^3 + b * x^2 + c * x + d = 0 (a != 0)，获取实数根
-// 返回值列表为空，表示方程没有实数解
-static std::vector<double> CalRealSolutionsOfCubicEquation(double a, double b, double c, double d) {
+// 实数根写入 solutions，返回实数根的个数，返回 0 表示方程没有实数解
+static int CalRealSolutionsOfCubicEquation(double a, double b, double c, double d,
+                                           double solutions[3]) {
   if (a == 0) {
-    return {};
+    return 0;
   }
 
   auto A = b * b - 3 * a * c;
   auto B = b * c - 9 * a * d;
   auto C = c * c - 3 * b * d;
   auto delta = B * B - 4 * A * C;
-  std::vector<double> solutions;
+  int count = 0;
   if (A == 0 && B == 0) {
-    solutions.emplace_back(-b / (3 * a));
+    solutions[count++] = -b / (3 * a);
   } else if (delta == 0 && A != 0) {
     auto k = B / A;
-    solutions.emplace_back(-b / a + k);
-    solutions.emplace_back(-0.5 * k);
+    solutions[count++] = -b / a + k;
+    solutions[count++] = -0.5 * k;
   } else if (delta > 0) {
     auto y1 = A * b + 1.5 * a * (-B + sqrt(delta));
     auto y2 = A * b + 1.5 * a * (-B - sqrt(delta));
-    solutions.emplace_back((-b - cbrt(y1) - cbrt(y2)) / (3 * a));
+    solutions[count++] = (-b - cbrt(y1) - cbrt(y2)) / (3 * a);
   } else if (delta < 0 && A > 0) {
     auto t = (A * b - 1.5 * a * B) / (A * sqrt(A));
     if (-1 < t && t < 1) {
@@ -304,42 +388,36 @@ static std::vector<double> CalRealSolutionsOfCubicEquation(double a, double b, d
       auto sqrtA = sqrt(A);
       auto cosA = cos(theta / 3);
       auto sinA = sin(theta / 3);
-      solutions.emplace_back((-b - 2 * sqrtA * cosA) / (3 * a));
-      solutions.emplace_back((-b + sqrtA * (cosA + sqrt(3) * sinA)) / (3 * a));
-      solutions.emplace_back((-b + sqrtA * (cosA - sqrt(3) * sinA)) / (3 * a));
+      solutions[count++] = (-b - 2 * sqrtA * cosA) / (3 * a);
+      solutions[count++] = (-b + sqrtA * (cosA + sqrt(3) * sinA)) / (3 * a);
+      solutions[count++] = (-b + sqrtA * (cosA - sqrt(3) * sinA)) / (3 * a);
     }
   }
-  return solutions;
+  return count;
 }
 
-static float CalculateRangeFactorTriangle(float textStart, float textEnd, float rangeStart,
-                                          float rangeEnd, float easeHigh, float easeLow) {
-  //
-  // 三角形
-  //                /\
-  //               /  \
-  //              /    \
-  //             /      \
-  //            /        \
-  // __________/          \__________
-  //
-  auto textCenter = (textStart + textEnd) * 0.5f;
-  auto rangeCenter = (rangeStart + rangeEnd) * 0.5f;
-  double x = textCenter;
-
-  if (x < rangeStart || x > rangeEnd) {
-    return 0;
-  }
+// 三角形一侧的贝塞尔曲线，同一侧的所有字符共用
+struct TriangleCurve {
+  double x1 = 0;
+  double y2 = 0;
+  double y3 = 0;
+  // 一元三次方程的系数
+  double a = 0;
+  double b = 0;
+  double c = 0;
+};
 
+static TriangleCurve MakeTriangleCurve(double x1, float rangeCenter, float easeHigh,
+                                       float easeLow) {
   // 四阶贝塞尔曲线的四个控制点
-  double x1 = x <= rangeCenter ? rangeStart : rangeEnd, y1 = 0;
   double step = rangeCenter - x1;
   double x2 = easeLow >= 0 ? x1 + easeLow * step : x1;
-  double y2 = easeLow >= 0 ? 0 : -easeLow;
   double x3 = easeHigh >= 0 ? rangeCenter - easeHigh * step : rangeCenter;
-  double y3 = easeHigh >= 0 ? 1 : 1 + easeHigh;
-  double x4 = rangeCenter, y4 = 1;
-
+  double x4 = rangeCenter;
+  TriangleCurve curve = {};
+  curve.x1 = x1;
+  curve.y2 = easeLow >= 0 ? 0 : -easeLow;
+  curve.y3 = easeHigh >= 0 ? 1 : 1 + easeHigh;
   // 这里使用方程法而不使用 BezierEasing 方法拟合，是由于使用拟合法需要额外存储分段数据，
   // easeHigh 和easeLow 不变情况下，速度上计算没有多大差异，
   // 使用 easeHigh 和 easeLow 关键帧动画时候会有额外的生成分段数据开销和缓存开销，
@@ -348,22 +426,51 @@ static float CalculateRangeFactorTriangle(float textStart, float textEnd, float
   // 推出一元三次方程式 a * t^3 + b * t^2 + c * t + d = 0,
   // 其中 a = -x1 + 3 * x2 - 3 * x3 + x4, b = 3 * x1 - 6 * x2 + 3 * x3,
   // c = -3 * x1 + 3 * x2, d = x1 - x, 求解 t
-  auto a = -x1 + 3 * x2 - 3 * x3 + x4;
-  auto b = 3 * (x1 - 2 * x2 + x3);
-  auto c = 3 * (-x1 + x2);
-  auto d = x1 - x;
+  curve.a = -x1 + 3 * x2 - 3 * x3 + x4;
+  curve.b = 3 * (x1 - 2 * x2 + x3);
+  curve.c = 3 * (-x1 + x2);
+  return curve;
+}
 
+static float EvaluateTriangleCurve(const TriangleCurve& curve, double x) {
+  double y1 = 0;
+  double y4 = 1;
+  auto d = curve.x1 - x;
+  double solutions[3] = {};
+  auto count = CalRealSolutionsOfCubicEquation(curve.a, curve.b, curve.c, d, solutions);
   double t = 0;
-  for (auto solution : CalRealSolutionsOfCubicEquation(a, b, c, d)) {
+  for (int i = 0; i < count; i++) {
+    auto solution = solutions[i];
     // 由于浮点计算有精确度问题，当 x = 0.5, t 会存在略大于1，因此需要做近似计算
     if ((solution >= 0 && solution <= 1) || DoubleNearlyEqual(solution, 1, 1e-6)) {
       t = solution;
       break;
     }
   }
+  return static_cast<float>(pow(1 - t, 3) * y1 + 3 * pow(1 - t, 2) * t * curve.y2 +
+                            3 * (1 - t) * pow(t, 2) * curve.y3 + pow(t, 3) * y4);
+}
+
+static float CalculateRangeFactorTriangle(float textStart, float textEnd, float rangeStart,
+                                          float rangeEnd, float easeHigh, float easeLow) {
+  //
+  // 三角形
+  //                /\
+  //               /  \
+  //              /    \
+  //             /      \
+  //            /        \
+  // __________/          \__________
+  //
+  auto textCenter = (textStart + textEnd) * 0.5f;
+  auto rangeCenter = (rangeStart + rangeEnd) * 0.5f;
+  double x = textCenter;
 
-  return static_cast<float>(pow(1 - t, 3) * y1 + 3 * pow(1 - t, 2) * t * y2 +
-                            3 * (1 - t) * pow(t, 2) * y3 + pow(t, 3) * y4);
+  if (x < rangeStart || x > rangeEnd) {
+    return 0;
+  }
+  auto x1 = x <= rangeCenter ? rangeStart : rangeEnd;
+  return EvaluateTriangleCurve(MakeTriangleCurve(x1, rangeCenter, easeHigh, easeLow), x);
 }
 
 static float CalculateRangeFactorRound(float textStart, float textEnd, float rangeStart,
@@ -438,6 +545,67 @@ void RangeSelectorRenderer::calculateBiasFlag(bool* pBiasFlag) {
   }
 }
 
+// 批量计算所有字符的范围因子，形状的分支和三角形曲线的系数都提到循环外面
+void RangeSelectorRenderer::calculateFactors(float* factors, size_t count) {
+  if (textCount == 0) {
+    std::fill(factors, factors + count, 0.0f);
+    return;
+  }
+  auto forEachText = [&](auto calculateFactor) {
+    for (size_t i = 0; i < count; i++) {
+      auto index = randomizeOrder ? static_cast<size_t>(randomIndexs[i]) : i;
+      auto textStart = static_cast<float>(index) / textCount;
+      auto textEnd = static_cast<float>(index + 1) / textCount;
+      factors[i] = calculateFactor(textStart, textEnd);
+    }
+  };
+  auto start = rangeStart;
+  auto end = rangeEnd;
+  switch (shape) {
+    case TextRangeSelectorShape::RampUp:  // 上斜坡
+      forEachText([=](float textStart, float textEnd) {
+        return CalculateRangeFactorRampUp(textStart, textEnd, start, end);
+      });
+      break;
+    case TextRangeSelectorShape::RampDown:  // 下斜坡
+      forEachText([=](float textStart, float textEnd) {
+        return CalculateRangeFactorRampDown(textStart, textEnd, start, end);
+      });
+      break;
+    case TextRangeSelectorShape::Triangle: {  // 三角形
+      auto rangeCenter = (start + end) * 0.5f;
+      auto leftCurve = MakeTriangleCurve(start, rangeCenter, easeHigh, easeLow);
+      auto rightCurve = MakeTriangleCurve(end, rangeCenter, easeHigh, easeLow);
+      forEachText([&](float textStart, float textEnd) {
+        double x = (textStart + textEnd) * 0.5f;
+        if (x < start || x > end) {
+          return 0.0f;
+        }
+        return EvaluateTriangleCurve(x <= rangeCenter ? leftCurve : rightCurve, x);
+      });
+      break;
+    }
+    case TextRangeSelectorShape::Round:  // 圆形
+      forEachText([=](float textStart, float textEnd) {
+        return CalculateRangeFactorRound(textStart, textEnd, start, end);
+      });
+      break;
+    case TextRangeSelectorShape::Smooth:  // 平滑
+      forEachText([=](float textStart, float textEnd) {
+        return CalculateRangeFactorSmooth(textStart, textEnd, start, end);
+      });
+      break;
+    default:  // TextRangeSelectorShape::Square  // 正方形
+      forEachText([=](float textStart, float textEnd) {
+        return CalculateFactorSquare(textStart, textEnd, start, end);
+      });
+      break;
+  }
+  for (size_t i = 0; i < count; i++) {
+    factors[i] = std::min(std::max(factors[i], 0.0f), 1.0f) * amount;
+  }
+}
+
 // 计算某个字符的范围因子
 float RangeSelectorRenderer::calculateFactorByIndex(size_t index, bool* pBiasFlag) {
   if (textCount == 0) {
@@ -28,6 +28,10 @@ class TextSelectorRenderer {
       const std::vector<TextSelectorRenderer*>& selectorRenderers, size_t index,
       bool* pBiasFlag = nullptr);
 
+  // 一次计算所有字符叠加后的范围因子，比逐个字符调用 CalculateFactorFromSelectors() 快得多
+  static std::vector<float> CalculateFactorsFromSelectors(
+      const std::vector<TextSelectorRenderer*>& selectorRenderers, size_t textCount);
+
   TextSelectorRenderer(size_t textCount, Frame frame) : textCount(textCount), frame(frame) {
   }
   virtual ~TextSelectorRenderer() = default;
@@ -35,6 +39,10 @@ class TextSelectorRenderer {
   // 叠加选择器
   float overlayFactor(float oldFactor, float factor, bool isFirstSelector);
 
+  // 批量叠加选择器
+  void overlayFactors(float* totalFactors, const float* factors, size_t count,
+                      bool isFirstSelector);
+
  protected:
   size_t textCount = 0;
   Frame frame = 0;
@@ -45,6 +53,8 @@ class TextSelectorRenderer {
   void calculateRandomIndexs(uint16_t seed);
   // 计算某个字符的范围因子
   virtual float calculateFactorByIndex(size_t index, bool* pBiasFlag) = 0;
+  // 批量计算前 count 个字符的范围因子
+  virtual void calculateFactors(float* factors, size_t count);
 };
 
 class WigglySelectorRenderer : public TextSelectorRenderer {
@@ -55,6 +65,10 @@ class WigglySelectorRenderer : public TextSelectorRenderer {
  private:
   // 计算某个字符的范围因子
   float calculateFactorByIndex(size_t index, bool* pBiasFlag) override;
+  void calculateFactors(float* factors, size_t count) override;
+  double calculateTemporalSeed() const;
+  double calculateSeed(size_t index, double temporalSeed) const;
+  float calculateFactorBySeed(double seed) const;
 
   // 摆动选择器参数：模式(在父类里)、最大量、最小量、摆动/秒、关联、时间相位、空间相位
   float maxAmount = 1.0f;  // 最大量
@@ -74,6 +88,7 @@ class RangeSelectorRenderer : public TextSelectorRenderer {
  private:
   // 计算某个字符的范围因子
   float calculateFactorByIndex(size_t index, bool* pBiasFlag) override;
+  void calculateFactors(float* factors, size_t count) override;
   void calculateBiasFlag(bool* pBiasFlag);
 
   float rangeStart = 0.0f;
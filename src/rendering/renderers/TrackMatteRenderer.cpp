@@ -32,8 +32,12 @@ static std::shared_ptr<Graphic> RenderColorGlyphs(TextLayer* layer, Frame layerF
   }
   auto layerCache = LayerCache::Get(layer);
   auto contentFrame = layerFrame - layer->startTime;
-  auto content =
-      textContent ? textContent : static_cast<TextContent*>(layerCache->getContent(contentFrame));
+  std::shared_ptr<Content> cacheContent = nullptr;
+  auto content = textContent;
+  if (content == nullptr) {
+    cacheContent = layerCache->getContent(contentFrame);
+    content = static_cast<TextContent*>(cacheContent.get());
+  }
   if (content->colorGlyphs == nullptr) {
     return nullptr;
   }
@@ -87,9 +91,9 @@ std::unique_ptr<TrackMatte> TrackMatteRenderer::Make(PAGLayer* trackMatteOwner)
     return nullptr;
   }
   if (trackMatteLayer->layerType() == LayerType::Text) {
-    auto textContent = static_cast<TextContent*>(trackMatteLayer->getContent());
+    auto textContent = std::static_pointer_cast<TextContent>(trackMatteLayer->getContent());
     trackMatte->colorGlyphs = RenderColorGlyphs(static_cast<TextLayer*>(trackMatteLayer->layer),
-                                                layerFrame, textContent, &extraTransform);
+                                                layerFrame, textContent.get(), &extraTransform);
   }
   return trackMatte;
 }
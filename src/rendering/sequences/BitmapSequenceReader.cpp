@@ -20,8 +20,14 @@
 #include "tgfx/core/Buffer.h"
 #include "tgfx/core/ImageCodec.h"
 #include "tgfx/core/Pixmap.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
+// The maximum memory used by the checkpoints of each reader.
+static constexpr size_t MAX_CHECKPOINT_MEMORY = 32 * 1024 * 1024;
+// The minimum number of pixels in a frame to decode its bitmap rects in parallel.
+static constexpr int64_t MIN_PARALLEL_DECODING_PIXELS = 256 * 256;
+
 BitmapSequenceReader::BitmapSequenceReader(std::shared_ptr<File> file, BitmapSequence* sequence)
     : file(std::move(file)), sequence(sequence) {
   // Force allocating a raster PixelBuffer if staticContent is false, otherwise the asynchronous
@@ -47,6 +53,35 @@ BitmapSequenceReader::~BitmapSequenceReader() {
 std::shared_ptr<tgfx::ImageBuffer> BitmapSequenceReader::onMakeBuffer(Frame targetFrame) {
   // a locker is required here because decodeFrame() could be called from multiple threads.
   std::lock_guard<std::mutex> autoLock(locker);
+  return decodeFrame(targetFrame);
+}
+
+std::shared_ptr<tgfx::ImageBuffer> BitmapSequenceReader::onMakeStandaloneBuffer(Frame targetFrame,
+                                                                               size_t* byteSize) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  if (decodeFrame(targetFrame) == nullptr) {
+    return nullptr;
+  }
+  // The decoded pixels are the base of decoding the next frames, so they are copied out.
+  tgfx::Buffer buffer(info.byteSize());
+  if (buffer.isEmpty()) {
+    return nullptr;
+  }
+  if (hardWareBuffer) {
+    auto hardwarePixels = tgfx::HardwareBufferLock(hardWareBuffer);
+    if (hardwarePixels == nullptr) {
+      return nullptr;
+    }
+    buffer.writeRange(0, buffer.size(), hardwarePixels);
+    tgfx::HardwareBufferUnlock(hardWareBuffer);
+  } else {
+    buffer.writeRange(0, buffer.size(), pixels->data());
+  }
+  *byteSize = buffer.size();
+  return tgfx::ImageBuffer::MakeFrom(info, buffer.release());
+}
+
+std::shared_ptr<tgfx::ImageBuffer> BitmapSequenceReader::decodeFrame(Frame targetFrame) {
   if (lastDecodeFrame == targetFrame) {
     return imageBuffer;
   }
@@ -66,30 +101,16 @@ std::shared_ptr<tgfx::ImageBuffer> BitmapSequenceReader::onMakeBuffer(Frame targ
     pixmap.reset(info, const_cast<void*>(pixels->data()));
   }
   auto startFrame = findStartFrame(targetFrame);
+  startFrame = restoreCheckpoint(startFrame, targetFrame, pixmap);
   auto& bitmapFrames = static_cast<BitmapSequence*>(sequence)->frames;
   for (Frame frame = startFrame; frame <= targetFrame; frame++) {
     auto bitmapFrame = bitmapFrames[frame];
-    auto firstRead = true;
-    for (auto bitmapRect : bitmapFrame->bitmaps) {
-      auto imageBytes = tgfx::Data::MakeWithoutCopy(bitmapRect->fileBytes->data(),
-                                                    bitmapRect->fileBytes->length());
-      auto codec = tgfx::ImageCodec::MakeFrom(imageBytes);
-      // The returned image could be nullptr if the frame is an empty frame.
-      if (codec != nullptr) {
-        if (firstRead && bitmapFrame->isKeyframe &&
-            !(codec->width() == pixmap.width() && codec->height() == pixmap.height())) {
-          // clear the whole screen if the size of the key frame is smaller than the screen.
-          pixmap.clear();
-        }
-        auto offset = pixmap.rowBytes() * bitmapRect->y + bitmapRect->x * 4;
-        auto result = codec->readPixels(
-            pixmap.info(), reinterpret_cast<uint8_t*>(pixmap.writablePixels()) + offset);
-        if (!result) {
-          tgfx::HardwareBufferUnlock(hardWareBuffer);
-          return nullptr;
-        }
-        firstRead = false;
-      }
+    if (!decodeBitmapFrame(bitmapFrame, pixmap)) {
+      tgfx::HardwareBufferUnlock(hardWareBuffer);
+      return nullptr;
+    }
+    if (checkpointInterval > 0 && frame % checkpointInterval == 0 && !bitmapFrame->isKeyframe) {
+      saveCheckpoint(frame, pixmap);
     }
   }
   if (hardWareBuffer) {
@@ -102,6 +123,80 @@ std::shared_ptr<tgfx::ImageBuffer> BitmapSequenceReader::onMakeBuffer(Frame targ
   return imageBuffer;
 }
 
+static bool Intersects(const BitmapRect* a, const tgfx::ImageCodec* codecA, const BitmapRect* b,
+                       const tgfx::ImageCodec* codecB) {
+  return a->x < b->x + codecB->width() && b->x < a->x + codecA->width() &&
+         a->y < b->y + codecB->height() && b->y < a->y + codecA->height();
+}
+
+bool BitmapSequenceReader::decodeBitmapFrame(BitmapFrame* bitmapFrame, tgfx::Pixmap& pixmap) {
+  std::vector<BitmapRect*> bitmapRects = {};
+  std::vector<std::shared_ptr<tgfx::ImageCodec>> codecs = {};
+  int64_t totalPixels = 0;
+  for (auto bitmapRect : bitmapFrame->bitmaps) {
+    auto imageBytes = tgfx::Data::MakeWithoutCopy(bitmapRect->fileBytes->data(),
+                                                  bitmapRect->fileBytes->length());
+    auto codec = tgfx::ImageCodec::MakeFrom(imageBytes);
+    // The returned image could be nullptr if the frame is an empty frame.
+    if (codec != nullptr) {
+      totalPixels += static_cast<int64_t>(codec->width()) * codec->height();
+      bitmapRects.push_back(bitmapRect);
+      codecs.push_back(std::move(codec));
+    }
+  }
+  if (codecs.empty()) {
+    return true;
+  }
+  auto& firstCodec = codecs.front();
+  if (bitmapFrame->isKeyframe &&
+      !(firstCodec->width() == pixmap.width() && firstCodec->height() == pixmap.height())) {
+    // clear the whole screen if the size of the key frame is smaller than the screen.
+    pixmap.clear();
+  }
+  auto count = codecs.size();
+  auto decodeRect = [&](size_t index) {
+    auto bitmapRect = bitmapRects[index];
+    auto offset = pixmap.rowBytes() * bitmapRect->y + bitmapRect->x * 4;
+    return codecs[index]->readPixels(
+        pixmap.info(), reinterpret_cast<uint8_t*>(pixmap.writablePixels()) + offset);
+  };
+  // The rects are decoded in order if any of them overlap, since the later ones cover the earlier.
+  auto parallel = count > 1 && totalPixels >= MIN_PARALLEL_DECODING_PIXELS;
+  for (size_t i = 0; parallel && i < count; i++) {
+    for (size_t j = i + 1; j < count; j++) {
+      if (Intersects(bitmapRects[i], codecs[i].get(), bitmapRects[j], codecs[j].get())) {
+        parallel = false;
+        break;
+      }
+    }
+  }
+  if (!parallel) {
+    for (size_t i = 0; i < count; i++) {
+      if (!decodeRect(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  // The non-overlapping rects write to disjoint regions of the pixmap, which can be done in
+  // parallel. The first rect is decoded on the current thread. This may already run on a task
+  // thread, for example when SequenceImageQueue prepares frames asynchronously, but waiting here
+  // can not starve the pool: Task::wait() runs a task that has not started yet on the waiting
+  // thread, so it only blocks on tasks that are already running, and these decoding tasks never
+  // wait for anything themselves.
+  std::vector<int> results(count, 0);
+  std::vector<std::shared_ptr<tgfx::Task>> tasks = {};
+  for (size_t i = 1; i < count; i++) {
+    auto task = tgfx::Task::Run([&, i]() { results[i] = decodeRect(i) ? 1 : 0; });
+    tasks.push_back(std::move(task));
+  }
+  results[0] = decodeRect(0) ? 1 : 0;
+  for (auto& task : tasks) {
+    task->wait();
+  }
+  return std::all_of(results.begin(), results.end(), [](int result) { return result != 0; });
+}
+
 void BitmapSequenceReader::onReportPerformance(Performance* performance, int64_t decodingTime) {
   performance->imageDecodingTime += decodingTime;
 }
@@ -117,4 +212,89 @@ Frame BitmapSequenceReader::findStartFrame(Frame targetFrame) {
   }
   return startFrame;
 }
+
+void BitmapSequenceReader::setCheckpointInterval(int interval) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  interval = std::max(interval, 0);
+  if (checkpointInterval == interval) {
+    return;
+  }
+  checkpointInterval = interval;
+  clearCheckpoints();
+}
+
+Frame BitmapSequenceReader::restoreCheckpoint(Frame startFrame, Frame targetFrame,
+                                              const tgfx::Pixmap& pixmap) {
+  auto result = checkpoints.upper_bound(targetFrame);
+  if (result == checkpoints.begin()) {
+    return startFrame;
+  }
+  result--;
+  // The checkpoint holds the pixels after decoding its frame, so it only helps if decoding from
+  // the start frame would go through it.
+  if (result->first < startFrame) {
+    return startFrame;
+  }
+  auto& checkpoint = result->second;
+  auto byteSize = pixmap.info().byteSize();
+  auto dstPixels = reinterpret_cast<uint8_t*>(pixmap.writablePixels());
+  if (checkpoint.compressed) {
+    if (decoder == nullptr) {
+      decoder = LZ4Decoder::Make();
+    }
+    auto srcPixels = checkpoint.data->bytes();
+    auto size = checkpoint.data->size();
+    if (decoder->decode(dstPixels, byteSize, srcPixels, size) != byteSize) {
+      return startFrame;
+    }
+  } else {
+    if (checkpoint.data->size() != byteSize) {
+      return startFrame;
+    }
+    memcpy(dstPixels, checkpoint.data->data(), byteSize);
+  }
+  return result->first + 1;
+}
+
+void BitmapSequenceReader::saveCheckpoint(Frame frame, const tgfx::Pixmap& pixmap) {
+  if (checkpoints.count(frame) > 0) {
+    return;
+  }
+  auto byteSize = pixmap.info().byteSize();
+  auto srcPixels = reinterpret_cast<const uint8_t*>(pixmap.pixels());
+  if (encoder == nullptr) {
+    encoder = LZ4Encoder::Make();
+  }
+  auto maxSize = LZ4Encoder::GetMaxOutputSize(byteSize);
+  tgfx::Buffer buffer(maxSize);
+  size_t encodedSize = 0;
+  if (!buffer.isEmpty()) {
+    encodedSize = encoder->encode(buffer.bytes(), maxSize, srcPixels, byteSize);
+  }
+  std::shared_ptr<tgfx::Data> data = nullptr;
+  auto compressed = encodedSize > 0 && encodedSize < byteSize;
+  if (compressed) {
+    data = tgfx::Data::MakeWithCopy(buffer.bytes(), encodedSize);
+  } else {
+    data = tgfx::Data::MakeWithCopy(srcPixels, byteSize);
+  }
+  if (data == nullptr || data->size() > MAX_CHECKPOINT_MEMORY) {
+    return;
+  }
+  // Evicts the checkpoints farthest from the new one until the new one fits into the budget.
+  while (checkpointMemory + data->size() > MAX_CHECKPOINT_MEMORY) {
+    auto first = checkpoints.begin();
+    auto last = std::prev(checkpoints.end());
+    auto farthest = frame - first->first > last->first - frame ? first : last;
+    checkpointMemory -= farthest->second.data->size();
+    checkpoints.erase(farthest);
+  }
+  checkpointMemory += data->size();
+  checkpoints.emplace(frame, BitmapCheckpoint(std::move(data), compressed));
+}
+
+void BitmapSequenceReader::clearCheckpoints() {
+  checkpoints = {};
+  checkpointMemory = 0;
+}
 }  // namespace pag
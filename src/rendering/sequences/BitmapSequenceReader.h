@@ -18,12 +18,26 @@
 
 #pragma once
 
+#include <map>
 #include "SequenceReader.h"
 #include "pag/file.h"
 #include "rendering/Performance.h"
+#include "rendering/utils/LZ4Decoder.h"
+#include "rendering/utils/LZ4Encoder.h"
 #include "tgfx/core/Bitmap.h"
+#include "tgfx/core/Data.h"
 
 namespace pag {
+class BitmapCheckpoint {
+ public:
+  BitmapCheckpoint(std::shared_ptr<tgfx::Data> data, bool compressed)
+      : data(std::move(data)), compressed(compressed) {
+  }
+
+  std::shared_ptr<tgfx::Data> data = nullptr;
+  bool compressed = false;
+};
+
 class BitmapSequenceReader : public SequenceReader {
  public:
   BitmapSequenceReader(std::shared_ptr<File> file, BitmapSequence* sequence);
@@ -38,12 +52,22 @@ class BitmapSequenceReader : public SequenceReader {
 
   ~BitmapSequenceReader() override;
 
+  void setCheckpointInterval(int interval) override;
+
  protected:
   std::shared_ptr<tgfx::ImageBuffer> onMakeBuffer(Frame targetFrame) override;
 
+  std::shared_ptr<tgfx::ImageBuffer> onMakeStandaloneBuffer(Frame targetFrame,
+                                                            size_t* byteSize) override;
+
   void onReportPerformance(Performance* performance, int64_t decodingTime) override;
 
+  std::shared_ptr<tgfx::ImageBuffer> decodeFrame(Frame targetFrame);
   Frame findStartFrame(Frame targetFrame);
+  bool decodeBitmapFrame(BitmapFrame* bitmapFrame, tgfx::Pixmap& pixmap);
+  Frame restoreCheckpoint(Frame startFrame, Frame targetFrame, const tgfx::Pixmap& pixmap);
+  void saveCheckpoint(Frame frame, const tgfx::Pixmap& pixmap);
+  void clearCheckpoints();
 
   std::mutex locker = {};
   // Keep a reference to the File in case the Sequence object is released while we are using it.
@@ -54,5 +78,10 @@ class BitmapSequenceReader : public SequenceReader {
   tgfx::ImageInfo info = {};
   std::shared_ptr<tgfx::Data> pixels = nullptr;
   HardwareBufferRef hardWareBuffer = nullptr;
+  int checkpointInterval = 0;
+  std::map<Frame, BitmapCheckpoint> checkpoints = {};
+  size_t checkpointMemory = 0;
+  std::unique_ptr<LZ4Encoder> encoder = nullptr;
+  std::unique_ptr<LZ4Decoder> decoder = nullptr;
 };
 }  // namespace pag
@@ -17,6 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "SequenceImageQueue.h"
+#include <algorithm>
 
 namespace pag {
 std::unique_ptr<SequenceImageQueue> SequenceImageQueue::MakeFrom(
@@ -40,14 +41,141 @@ SequenceImageQueue::SequenceImageQueue(std::shared_ptr<SequenceInfo> sequence,
       totalFrames(sequence->duration()), useDiskCache(useDiskCache) {
 }
 
-void SequenceImageQueue::prepareNextImage() {
-  auto nextFrame = currentFrame + 1;
+SequenceImageQueue::~SequenceImageQueue() {
+  std::shared_ptr<tgfx::Task> task = nullptr;
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    released = true;
+    task = prefetchTask;
+  }
+  if (task != nullptr) {
+    task->wait();
+  }
+}
+
+int SequenceImageQueue::prefetchDepth() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return _prefetchDepth;
+}
+
+void SequenceImageQueue::setPrefetchDepth(int depth) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  _prefetchDepth = std::max(depth, 1);
+  prefetchUnavailable = false;
+  while (static_cast<int>(prefetchedFrames.size()) > _prefetchDepth) {
+    nextPrefetchFrame = prefetchedFrames.back().frame;
+    prefetchedFrames.pop_back();
+    prefetchVersion++;
+  }
+}
+
+void SequenceImageQueue::setCheckpointInterval(int interval) {
+  reader->setCheckpointInterval(interval);
+}
+
+size_t SequenceImageQueue::memoryUsage() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  size_t usage = 0;
+  for (auto& item : prefetchedFrames) {
+    usage += item.byteSize;
+  }
+  return usage;
+}
+
+Frame SequenceImageQueue::getNextFrame(Frame frame) const {
+  auto nextFrame = frame + 1;
   if (nextFrame >= totalFrames) {
     nextFrame = firstFrame;
   }
+  return nextFrame;
+}
+
+bool SequenceImageQueue::prefetchEnabled() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return _prefetchDepth > 1 && !prefetchUnavailable;
+}
+
+void SequenceImageQueue::prepareNextImage() {
+  auto nextFrame = getNextFrame(currentFrame);
+  if (prefetchEnabled()) {
+    preparedImage = nullptr;
+    preparedFrame = nextFrame;
+    prefetch(nextFrame);
+    return;
+  }
   prepare(nextFrame);
 }
 
+void SequenceImageQueue::prefetch(Frame startFrame) {
+  if (startFrame < 0 || startFrame >= totalFrames) {
+    return;
+  }
+  std::lock_guard<std::mutex> autoLock(locker);
+  auto expectedFrame =
+      prefetchedFrames.empty() ? nextPrefetchFrame : prefetchedFrames.front().frame;
+  if (expectedFrame != startFrame) {
+    resetPrefetchedFrames(startFrame);
+  }
+  if (prefetchTaskRunning || static_cast<int>(prefetchedFrames.size()) >= _prefetchDepth) {
+    return;
+  }
+  prefetchTaskRunning = true;
+  // Frames are decoded one by one in a single task, since most readers decode faster in order.
+  prefetchTask = tgfx::Task::Run([this]() { processPrefetchFrames(); });
+}
+
+void SequenceImageQueue::processPrefetchFrames() {
+  while (true) {
+    Frame frame = 0;
+    uint32_t version = 0;
+    {
+      std::lock_guard<std::mutex> autoLock(locker);
+      if (released || static_cast<int>(prefetchedFrames.size()) >= _prefetchDepth) {
+        prefetchTaskRunning = false;
+        return;
+      }
+      frame = nextPrefetchFrame;
+      version = prefetchVersion;
+    }
+    // The buffers returned by readBuffer() share the reader's output, which the next decoding
+    // overwrites, so every prefetched frame needs its own buffer.
+    size_t byteSize = 0;
+    auto buffer = reader->readStandaloneBuffer(frame, &byteSize);
+    std::lock_guard<std::mutex> autoLock(locker);
+    if (version != prefetchVersion) {
+      continue;
+    }
+    if (buffer == nullptr) {
+      // Falls back to preparing one frame at a time.
+      prefetchUnavailable = true;
+      prefetchTaskRunning = false;
+      return;
+    }
+    prefetchedFrames.emplace_back(frame, std::move(buffer), byteSize);
+    nextPrefetchFrame = getNextFrame(frame);
+  }
+}
+
+std::shared_ptr<tgfx::ImageBuffer> SequenceImageQueue::takePrefetchedBuffer(Frame targetFrame) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  while (!prefetchedFrames.empty() && prefetchedFrames.front().frame != targetFrame) {
+    prefetchedFrames.pop_front();
+  }
+  if (prefetchedFrames.empty()) {
+    resetPrefetchedFrames(getNextFrame(targetFrame));
+    return nullptr;
+  }
+  auto buffer = prefetchedFrames.front().buffer;
+  prefetchedFrames.pop_front();
+  return buffer;
+}
+
+void SequenceImageQueue::resetPrefetchedFrames(Frame startFrame) {
+  prefetchedFrames.clear();
+  nextPrefetchFrame = startFrame;
+  prefetchVersion++;
+}
+
 void SequenceImageQueue::prepare(Frame targetFrame) {
   if (preparedImage != nullptr || targetFrame < 0 || targetFrame >= totalFrames) {
     return;
@@ -61,7 +189,19 @@ std::shared_ptr<tgfx::Image> SequenceImageQueue::getImage(Frame targetFrame) {
   if (targetFrame == currentFrame) {
     return currentImage;
   }
-  if (targetFrame == preparedFrame) {
+  if (prefetchEnabled()) {
+    auto buffer = takePrefetchedBuffer(targetFrame);
+    if (buffer != nullptr) {
+      auto image = sequence->makeBufferImage(std::move(buffer), useDiskCache);
+      if (image != nullptr) {
+        currentImage = image;
+        currentFrame = targetFrame;
+        preparedFrame = targetFrame;
+        return currentImage;
+      }
+    }
+  }
+  if (targetFrame == preparedFrame && preparedImage != nullptr) {
     currentImage = preparedImage;
     preparedImage = nullptr;
     currentFrame = preparedFrame;
@@ -18,17 +18,58 @@
 
 #pragma once
 
+#include <deque>
+#include <mutex>
 #include "SequenceInfo.h"
 #include "SequenceReader.h"
 #include "pag/file.h"
 #include "pag/pag.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
+class PrefetchedFrame {
+ public:
+  PrefetchedFrame(Frame frame, std::shared_ptr<tgfx::ImageBuffer> buffer, size_t byteSize)
+      : frame(frame), buffer(std::move(buffer)), byteSize(byteSize) {
+  }
+
+  Frame frame = 0;
+  std::shared_ptr<tgfx::ImageBuffer> buffer = nullptr;
+  size_t byteSize = 0;
+};
+
 class SequenceImageQueue {
  public:
   static std::unique_ptr<SequenceImageQueue> MakeFrom(std::shared_ptr<SequenceInfo> sequence,
                                                       PAGLayer* pagLayer, bool useDiskCache);
 
+  ~SequenceImageQueue();
+
+  /**
+   * Returns the number of frames decoded ahead of playback. The default value is 1.
+   */
+  int prefetchDepth();
+
+  /**
+   * Sets the number of frames decoded ahead of playback. If the depth is greater than 1, a
+   * background task keeps decoding the upcoming frames in order until the prefetch window is full,
+   * which absorbs the decoding time variance between frames, such as video keyframes. Each
+   * prefetched frame is decoded into its own buffer, so prefetching is skipped if the reader can
+   * only decode into a shared output, such as a hardware video decoder.
+   */
+  void setPrefetchDepth(int depth);
+
+  /**
+   * Sets the interval of frames at which the sequence keeps a snapshot of the decoded frame to
+   * speed up seeking. The value 0 disables the snapshots.
+   */
+  void setCheckpointInterval(int interval);
+
+  /**
+   * Returns the estimated memory usage of the frames decoded ahead of playback.
+   */
+  size_t memoryUsage();
+
   /**
    * Prepares the image of the next frame.
    */
@@ -59,10 +100,27 @@ class SequenceImageQueue {
   std::shared_ptr<tgfx::Image> currentImage = nullptr;
   std::shared_ptr<tgfx::Image> preparedImage = nullptr;
   bool useDiskCache = false;
+  std::mutex locker = {};
+  int _prefetchDepth = 1;
+  // Increases whenever the prefetch window is reset, so that outdated frames can be dropped.
+  uint32_t prefetchVersion = 0;
+  Frame nextPrefetchFrame = -1;
+  std::deque<PrefetchedFrame> prefetchedFrames = {};
+  std::shared_ptr<tgfx::Task> prefetchTask = nullptr;
+  bool prefetchTaskRunning = false;
+  bool prefetchUnavailable = false;
+  bool released = false;
 
   SequenceImageQueue(std::shared_ptr<SequenceInfo> sequence, std::shared_ptr<SequenceReader> reader,
                      Frame firstFrame, bool useDiskCache);
 
+  Frame getNextFrame(Frame frame) const;
+  bool prefetchEnabled();
+  void prefetch(Frame startFrame);
+  void processPrefetchFrames();
+  std::shared_ptr<tgfx::ImageBuffer> takePrefetchedBuffer(Frame targetFrame);
+  void resetPrefetchedFrames(Frame startFrame);
+
   friend class RenderCache;
 };
 }  // namespace pag
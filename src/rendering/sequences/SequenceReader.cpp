@@ -30,6 +30,14 @@ std::shared_ptr<tgfx::ImageBuffer> SequenceReader::readBuffer(Frame targetFrame)
   return buffer;
 }
 
+std::shared_ptr<tgfx::ImageBuffer> SequenceReader::readStandaloneBuffer(Frame targetFrame,
+                                                                       size_t* byteSize) {
+  tgfx::Clock clock = {};
+  auto buffer = onMakeStandaloneBuffer(targetFrame, byteSize);
+  decodingTime += clock.measure();
+  return buffer;
+}
+
 void SequenceReader::reportPerformance(Performance* performance) {
   if (decodingTime > 0) {
     onReportPerformance(performance, decodingTime);
@@ -44,6 +44,21 @@ class SequenceReader {
    */
   std::shared_ptr<tgfx::ImageBuffer> readBuffer(Frame targetFrame);
 
+  /**
+   * Decodes the specified target frame into an image buffer with its own storage, which is not
+   * overwritten by the following decoding, and sets byteSize to its memory size. Returns nullptr if
+   * the reader can not make such buffers, e.g. it decodes frames into a single hardware surface.
+   */
+  std::shared_ptr<tgfx::ImageBuffer> readStandaloneBuffer(Frame targetFrame, size_t* byteSize);
+
+  /**
+   * Sets the interval of frames at which the reader keeps a snapshot of the decoded frame, so that
+   * seeking backward decodes at most that many frames. Only readers that decode frames
+   * incrementally support it, and the default value 0 disables the snapshots.
+   */
+  virtual void setCheckpointInterval(int) {
+  }
+
   void reportPerformance(Performance* performance);
 
  protected:
@@ -52,6 +67,14 @@ class SequenceReader {
    */
   virtual std::shared_ptr<tgfx::ImageBuffer> onMakeBuffer(Frame targetFrame) = 0;
 
+  /**
+   * Return the decoded ImageBuffer of the specified frame in its own storage. The default
+   * implementation returns nullptr.
+   */
+  virtual std::shared_ptr<tgfx::ImageBuffer> onMakeStandaloneBuffer(Frame, size_t*) {
+    return nullptr;
+  }
+
   /**
    * Reports the decoding performance data.
    */
@@ -53,9 +53,36 @@ std::shared_ptr<tgfx::ImageBuffer> VideoReader::onMakeBuffer(Frame targetFrame)
   }
   lastBuffer = nullptr;
   currentRenderedTime = INT64_MIN;
-  if (!checkVideoDecoder()) {
+  if (!decodeSample(sampleTime)) {
     return nullptr;
   }
+  if (!outputEndOfStream) {
+    lastBuffer = videoDecoder->onRenderFrame();
+    if (lastBuffer) {
+      currentRenderedTime = currentDecodedTime;
+    }
+  }
+  return lastBuffer;
+}
+
+std::shared_ptr<tgfx::ImageBuffer> VideoReader::onMakeStandaloneBuffer(Frame targetFrame,
+                                                                      size_t* byteSize) {
+  std::lock_guard<std::mutex> autoLock(locker);
+  auto targetTime = FrameToTime(targetFrame, frameRate);
+  auto sampleTime = demuxer->getSampleTimeAt(targetTime);
+  // The decoder output shared by lastBuffer is going to be overwritten.
+  lastBuffer = nullptr;
+  currentRenderedTime = INT64_MIN;
+  if (!decodeSample(sampleTime) || outputEndOfStream) {
+    return nullptr;
+  }
+  return videoDecoder->onRenderStandaloneFrame(byteSize);
+}
+
+bool VideoReader::decodeSample(int64_t sampleTime) {
+  if (!checkVideoDecoder()) {
+    return false;
+  }
   auto success = decodeFrame(sampleTime);
   if (!success) {
     // retry once.
@@ -72,15 +99,8 @@ std::shared_ptr<tgfx::ImageBuffer> VideoReader::onMakeBuffer(Frame targetFrame)
   }
   if (!success) {
     LOGE("VideoDecoder: Error on decoding frame.\n");
-    return nullptr;
   }
-  if (!outputEndOfStream) {
-    lastBuffer = videoDecoder->onRenderFrame();
-    if (lastBuffer) {
-      currentRenderedTime = currentDecodedTime;
-    }
-  }
-  return lastBuffer;
+  return success;
 }
 
 void VideoReader::onReportPerformance(Performance* performance, int64_t decodingTime) {
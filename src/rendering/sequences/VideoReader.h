@@ -41,6 +41,9 @@ class VideoReader : public SequenceReader {
  protected:
   std::shared_ptr<tgfx::ImageBuffer> onMakeBuffer(Frame targetFrame) override;
 
+  std::shared_ptr<tgfx::ImageBuffer> onMakeStandaloneBuffer(Frame targetFrame,
+                                                            size_t* byteSize) override;
+
   void onReportPerformance(Performance* performance, int64_t decodingTime) override;
 
  private:
@@ -69,6 +72,8 @@ class VideoReader : public SequenceReader {
 
   bool decodeFrame(int64_t sampleTime);
 
+  bool decodeSample(int64_t sampleTime);
+
   std::unique_ptr<VideoDecoder> makeVideoDecoder();
 };
 }  // namespace pag
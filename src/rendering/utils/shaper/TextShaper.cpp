@@ -17,6 +17,10 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "TextShaper.h"
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #ifdef PAG_USE_HARFBUZZ
 #include "TextShaperHarfbuzz.h"
 #else
@@ -25,11 +29,96 @@
 #endif
 
 namespace pag {
+static constexpr size_t MAX_SHAPING_CACHE_COUNT = 512;
+// Long paragraphs are rarely shaped again with exactly the same text, so they are not cached.
+static constexpr size_t MAX_CACHED_TEXT_LENGTH = 4096;
+
+/**
+ * ShapingCache keeps the recently shaped results keyed by the typeface ID and the text, so that
+ * the texts rebuilt frequently, such as the ones being edited, are not shaped again and again.
+ */
+class ShapingCache {
+ public:
+  static ShapingCache* Get() {
+    static auto& cache = *new ShapingCache();
+    return &cache;
+  }
+
+  static std::string MakeKey(const std::string& text, const tgfx::Typeface* typeface) {
+    uint32_t typefaceID = typeface != nullptr ? typeface->uniqueID() : 0;
+    std::string key(sizeof(typefaceID), '\0');
+    memcpy(&key[0], &typefaceID, sizeof(typefaceID));
+    key.append(text);
+    return key;
+  }
+
+  bool find(const std::string& key, std::vector<ShapedGlyph>* glyphs) {
+    std::lock_guard<std::mutex> autoLock(locker);
+    auto result = entries.find(key);
+    if (result == entries.end()) {
+      return false;
+    }
+    lru.splice(lru.begin(), lru, result->second.position);
+    *glyphs = result->second.glyphs;
+    return true;
+  }
+
+  void add(const std::string& key, const std::vector<ShapedGlyph>& glyphs) {
+    std::lock_guard<std::mutex> autoLock(locker);
+    auto result = entries.find(key);
+    if (result != entries.end()) {
+      // Another thread has shaped the same text in the meantime.
+      lru.splice(lru.begin(), lru, result->second.position);
+      return;
+    }
+    lru.push_front(key);
+    entries[key] = {glyphs, lru.begin()};
+    while (lru.size() > MAX_SHAPING_CACHE_COUNT) {
+      entries.erase(lru.back());
+      lru.pop_back();
+    }
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> autoLock(locker);
+    entries.clear();
+    lru.clear();
+  }
+
+ private:
+  struct Entry {
+    std::vector<ShapedGlyph> glyphs = {};
+    std::list<std::string>::iterator position = {};
+  };
+
+  std::mutex locker = {};
+  std::list<std::string> lru = {};
+  std::unordered_map<std::string, Entry> entries = {};
+};
+
 std::vector<ShapedGlyph> TextShaper::Shape(const std::string& text,
                                            std::shared_ptr<tgfx::Typeface> typeface) {
   if (text.empty()) {
     return {};
   }
+  if (text.size() > MAX_CACHED_TEXT_LENGTH) {
+    return ShapeInternal(text, std::move(typeface));
+  }
+  auto cache = ShapingCache::Get();
+  auto key = ShapingCache::MakeKey(text, typeface.get());
+  std::vector<ShapedGlyph> glyphs = {};
+  if (cache->find(key, &glyphs)) {
+    return glyphs;
+  }
+  glyphs = ShapeInternal(text, std::move(typeface));
+  if (!glyphs.empty()) {
+    cache->add(key, glyphs);
+  }
+  return glyphs;
+}
+
+std::vector<ShapedGlyph> TextShaper::ShapeInternal(const std::string& text,
+                                                   std::shared_ptr<tgfx::Typeface> typeface) {
 #ifdef PAG_USE_HARFBUZZ
   return TextShaperHarfbuzz::Shape(text, std::move(typeface));
 #else
@@ -44,6 +133,7 @@ std::vector<ShapedGlyph> TextShaper::Shape(const std::string& text,
 }
 
 void TextShaper::PurgeCaches() {
+  ShapingCache::Get()->clear();
 #ifdef PAG_USE_HARFBUZZ
   TextShaperHarfbuzz::PurgeCaches();
 #endif
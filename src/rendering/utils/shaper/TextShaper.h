@@ -28,14 +28,20 @@ namespace pag {
 class TextShaper {
  public:
   /**
-   * Shapes the given text using the specified typeface.
+   * Shapes the given text using the specified typeface. The results of the recently shaped texts
+   * are cached and shared by all threads.
    */
   static std::vector<ShapedGlyph> Shape(const std::string& text,
                                         std::shared_ptr<tgfx::Typeface> typeface);
 
   /**
-   * Purges the caches used by the text shaper.
+   * Purges the caches used by the text shaper. It must be called if the fallback fonts change,
+   * since the cached results may contain glyphs from the previous fallback fonts.
    */
   static void PurgeCaches();
+
+ private:
+  static std::vector<ShapedGlyph> ShapeInternal(const std::string& text,
+                                                std::shared_ptr<tgfx::Typeface> typeface);
 };
 }  // namespace pag
@@ -20,7 +20,7 @@
 
 #include "TextShaperHarfbuzz.h"
 #include <list>
-#include <map>
+#include <unordered_map>
 #include "base/utils/Log.h"
 #include "hb.h"
 #include "rendering/FontManager.h"
@@ -89,9 +89,14 @@ std::shared_ptr<hb_face_t> CreateHBFace(std::shared_ptr<tgfx::Typeface> typeface
   return hbFace;
 }
 
+struct HBFontEntry {
+  std::shared_ptr<hb_font_t> font = nullptr;
+  std::list<uint32_t>::iterator position = {};
+};
+
 class HBLockedFontCache {
  public:
-  HBLockedFontCache(std::list<uint32_t>* lru, std::map<uint32_t, std::shared_ptr<hb_font_t>>* cache,
+  HBLockedFontCache(std::list<uint32_t>* lru, std::unordered_map<uint32_t, HBFontEntry>* cache,
                     std::mutex* mutex)
       : lru(lru), cache(cache), mutex(mutex) {
     mutex->lock();
@@ -105,27 +110,30 @@ class HBLockedFontCache {
   }
 
   std::shared_ptr<hb_font_t> find(uint32_t fontId) {
-    auto iter = std::find(lru->begin(), lru->end(), fontId);
-    if (iter == lru->end()) {
+    auto iter = cache->find(fontId);
+    if (iter == cache->end()) {
       return nullptr;
     }
-    lru->erase(iter);
-    lru->push_front(fontId);
-    return (*cache)[fontId];
+    lru->splice(lru->begin(), *lru, iter->second.position);
+    return iter->second.font;
   }
   std::shared_ptr<hb_font_t> insert(uint32_t fontId, std::shared_ptr<hb_font_t> hbFont) {
     if (hb_font_get_empty() == hbFont.get()) {
       return nullptr;
     }
     static const int MaxCacheSize = 100;
-    cache->insert(std::make_pair(fontId, std::move(hbFont)));
+    auto iter = cache->find(fontId);
+    if (iter != cache->end()) {
+      lru->splice(lru->begin(), *lru, iter->second.position);
+      return iter->second.font;
+    }
     lru->push_front(fontId);
+    (*cache)[fontId] = {std::move(hbFont), lru->begin()};
     while (lru->size() > MaxCacheSize) {
-      auto id = lru->back();
+      cache->erase(lru->back());
       lru->pop_back();
-      cache->erase(id);
     }
-    return (*cache)[fontId];
+    return (*cache)[fontId].font;
   }
   void reset() {
     lru->clear();
@@ -134,14 +142,14 @@ class HBLockedFontCache {
 
  private:
   std::list<uint32_t>* lru;
-  std::map<uint32_t, std::shared_ptr<hb_font_t>>* cache;
+  std::unordered_map<uint32_t, HBFontEntry>* cache;
   std::mutex* mutex;
 };
 
 static HBLockedFontCache GetHBFontCache() {
   static auto* HBFontCacheMutex = new std::mutex();
   static auto* HBFontLRU = new std::list<uint32_t>();
-  static auto* HBFontCache = new std::map<uint32_t, std::shared_ptr<hb_font_t>>();
+  static auto* HBFontCache = new std::unordered_map<uint32_t, HBFontEntry>();
   return {HBFontLRU, HBFontCache, HBFontCacheMutex};
 }
 
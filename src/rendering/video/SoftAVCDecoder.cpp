@@ -17,7 +17,9 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "SoftAVCDecoder.h"
+#include <algorithm>
 #include <cstdlib>
+#include <thread>
 #include "tgfx/core/Buffer.h"
 
 #ifdef PAG_USE_LIBAVC
@@ -66,11 +68,30 @@ static void ivd_aligned_free(void*, void* block) {
 
 #endif
 
-bool SoftAVCDecoder::onConfigure(const std::vector<HeaderData>& headers, std::string mimeType, int,
-                                 int) {
+// libavc uses at most 3 threads to decode a video sequence.
+static constexpr int MAX_NUM_CORES = 3;
+// Smaller videos decode faster in one thread than paying for the thread synchronization.
+static constexpr int MULTI_CORE_MIN_PIXELS = 960 * 540;
+
+static int GetNumCores(int threadCount, int width, int height) {
+  if (threadCount <= 0) {
+    if (width * height < MULTI_CORE_MIN_PIXELS) {
+      return 1;
+    }
+    threadCount = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  return std::max(1, std::min(threadCount, MAX_NUM_CORES));
+}
+
+SoftAVCDecoder::SoftAVCDecoder(int threadCount) : threadCount(threadCount) {
+}
+
+bool SoftAVCDecoder::onConfigure(const std::vector<HeaderData>& headers, std::string mimeType,
+                                 int width, int height) {
   if (mimeType != "video/avc") {
     return false;
   }
+  numCores = GetNumCores(threadCount, width, height);
   if (!initDecoder()) {
     return false;
   }
@@ -279,7 +300,7 @@ bool SoftAVCDecoder::setNumCores() {
   ih264d_ctl_set_num_cores_op_t s_set_cores_op;
   s_set_cores_ip.e_cmd = IVD_CMD_VIDEO_CTL;
   s_set_cores_ip.e_sub_cmd = (IVD_CONTROL_API_COMMAND_TYPE_T)IH264D_CMD_CTL_SET_NUM_CORES;
-  s_set_cores_ip.u4_num_cores = 1;
+  s_set_cores_ip.u4_num_cores = static_cast<UWORD32>(numCores);
   s_set_cores_ip.u4_size = sizeof(ih264d_ctl_set_num_cores_ip_t);
   s_set_cores_op.u4_size = sizeof(ih264d_ctl_set_num_cores_op_t);
   auto status = ih264d_api_function(codecContext, &s_set_cores_ip, &s_set_cores_op);
@@ -43,6 +43,12 @@ namespace pag {
  */
 class SoftAVCDecoder : public SoftwareDecoder {
  public:
+  /**
+   * Creates a decoder which decodes frames in the specified number of threads. If threadCount is
+   * not greater than 0, the number is chosen automatically by the video size.
+   */
+  explicit SoftAVCDecoder(int threadCount = 0);
+
   ~SoftAVCDecoder() override;
 
   bool onConfigure(const std::vector<HeaderData>& headers, std::string mime, int width,
@@ -65,6 +71,8 @@ class SoftAVCDecoder : public SoftwareDecoder {
   ivd_video_decode_ip_t decodeInput = {};
   ivd_video_decode_op_t decodeOutput = {};
   bool flushed = true;
+  int threadCount = 0;
+  int numCores = 1;
 
   bool initDecoder();
   bool openDecoder();
@@ -154,6 +154,40 @@ std::shared_ptr<tgfx::ImageBuffer> SoftwareDecoderWrapper::onRenderFrame() {
   return tgfx::ImageBuffer::MakeI420(std::move(yuvData), videoFormat.colorSpace);
 }
 
+std::shared_ptr<tgfx::ImageBuffer> SoftwareDecoderWrapper::onRenderStandaloneFrame(
+    size_t* byteSize) {
+  auto frame = softwareDecoder->onRenderFrame();
+  if (frame == nullptr) {
+    return nullptr;
+  }
+  // The decoder overwrites its output planes when decoding the next frame, so they are copied out.
+  auto uvHeight = (videoFormat.height + 1) / 2;
+  size_t planeSizes[I420_PLANE_COUNT] = {};
+  size_t totalSize = 0;
+  for (int i = 0; i < I420_PLANE_COUNT; i++) {
+    auto height = i == 0 ? videoFormat.height : uvHeight;
+    planeSizes[i] = static_cast<size_t>(frame->lineSize[i]) * height;
+    totalSize += planeSizes[i];
+  }
+  tgfx::Buffer buffer(totalSize);
+  if (buffer.isEmpty()) {
+    return nullptr;
+  }
+  size_t offset = 0;
+  for (int i = 0; i < I420_PLANE_COUNT; i++) {
+    buffer.writeRange(offset, planeSizes[i], frame->data[i]);
+    offset += planeSizes[i];
+  }
+  auto data = buffer.release();
+  auto bytes = const_cast<uint8_t*>(data->bytes());
+  uint8_t* planes[I420_PLANE_COUNT] = {bytes, bytes + planeSizes[0],
+                                       bytes + planeSizes[0] + planeSizes[1]};
+  auto yuvData = SoftwareData<tgfx::Data>::Make(videoFormat.width, videoFormat.height, planes,
+                                                frame->lineSize, I420_PLANE_COUNT, data);
+  *byteSize = totalSize;
+  return tgfx::ImageBuffer::MakeI420(std::move(yuvData), videoFormat.colorSpace);
+}
+
 int64_t SoftwareDecoderWrapper::presentationTime() {
   return currentDecodedTime;
 }
@@ -43,6 +43,8 @@ class SoftwareDecoderWrapper : public VideoDecoder {
 
   std::shared_ptr<tgfx::ImageBuffer> onRenderFrame() override;
 
+  std::shared_ptr<tgfx::ImageBuffer> onRenderStandaloneFrame(size_t* byteSize) override;
+
   int64_t presentationTime() override;
 
  private:
@@ -61,6 +61,15 @@ class VideoDecoder {
    */
   virtual std::shared_ptr<tgfx::ImageBuffer> onRenderFrame() = 0;
 
+  /**
+   * Returns decoded video frame copied into its own storage, which stays valid after the next
+   * frame is decoded, and sets byteSize to its memory size. Returns nullptr if the decoder can not
+   * copy its output, e.g. hardware decoders rendering into a single surface.
+   */
+  virtual std::shared_ptr<tgfx::ImageBuffer> onRenderStandaloneFrame(size_t*) {
+    return nullptr;
+  }
+
   /**
    * Returns current presentation time.
    */
@@ -32,6 +32,7 @@ static std::mutex factoryLocker = {};
 static SoftwareDecoderFactory* softwareDecoderFactory = {nullptr};
 static std::atomic_int maxHardwareDecoderCount = {65535};
 static std::atomic_int globalHardwareDecoderCount = {0};
+static std::atomic_int softwareDecoderThreadCount = {0};
 
 void PAGVideoDecoder::RegisterSoftwareDecoderFactory(SoftwareDecoderFactory* decoderFactory) {
   std::lock_guard<std::mutex> autoLock(factoryLocker);
@@ -42,6 +43,10 @@ void PAGVideoDecoder::SetMaxHardwareDecoderCount(int count) {
   maxHardwareDecoderCount = count;
 }
 
+void PAGVideoDecoder::SetSoftwareDecoderThreadCount(int count) {
+  softwareDecoderThreadCount = count;
+}
+
 static SoftwareDecoderFactory* GetSoftwareDecoderFactory() {
   if (softwareDecoderFactory) {
     return softwareDecoderFactory;
@@ -82,7 +87,8 @@ class SoftwareAVCDecoderFactory : public VideoDecoderFactory {
   std::unique_ptr<VideoDecoder> onCreateDecoder(const VideoFormat& format) const override {
     std::unique_ptr<VideoDecoder> videoDecoder = nullptr;
 #ifdef PAG_USE_LIBAVC
-    videoDecoder = SoftwareDecoderWrapper::Wrap(std::make_shared<SoftAVCDecoder>(), format);
+    videoDecoder = SoftwareDecoderWrapper::Wrap(
+        std::make_shared<SoftAVCDecoder>(softwareDecoderThreadCount), format);
     if (videoDecoder != nullptr) {
       LOGI("All other video decoders are not available, fallback to SoftAVCDecoder!");
     }
@@ -16,16 +16,41 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <sys/resource.h>
+#include <csignal>
 #include <filesystem>
+#include <random>
+#include <thread>
 #include "pag/pag.h"
 #include "platform/Platform.h"
+#include "rendering/CompositionReader.h"
 #include "rendering/caches/DiskCache.h"
 #include "rendering/utils/BitmapBuffer.h"
 #include "rendering/utils/Directory.h"
+#include "tgfx/core/DataView.h"
 #include "utils/TestUtils.h"
 
 namespace pag {
 
+/**
+ * Restores the global compression mode of the disk cache when the test exits, even if an
+ * assertion fails halfway.
+ */
+class CompressionModeScope {
+ public:
+  explicit CompressionModeScope(PAGCompressionMode mode)
+      : oldMode(PAGDiskCache::CompressionMode()) {
+    PAGDiskCache::SetCompressionMode(mode);
+  }
+
+  ~CompressionModeScope() {
+    PAGDiskCache::SetCompressionMode(oldMode);
+  }
+
+ private:
+  PAGCompressionMode oldMode = PAGCompressionMode::LZ4;
+};
+
 //PAG_TEST(PAGDiskCacheTest, GenerateTestCaches) {
 //  auto cacheDir = Platform::Current()->getCacheDir();
 //  std::filesystem::remove_all(cacheDir);
@@ -101,10 +126,11 @@ PAG_TEST(PAGDiskCacheTest, SequenceFile) {
   EXPECT_EQ(sequenceFile->cachedFrames, 11);
   auto diskCache = sequenceFile->diskCache;
   EXPECT_FALSE(std::filesystem::exists(cacheDir + "/files/4.bin"));
-  EXPECT_TRUE(diskCache->openedFiles.size() == 1);
+  EXPECT_TRUE(diskCache->getOpenedFileIDs().size() == 1);
   EXPECT_TRUE(diskCache->cachedFileInfos.size() == 2);
-  EXPECT_EQ(diskCache->cachedFiles.size(), 2u);
-  EXPECT_EQ(diskCache->fileIDCount, 4u);
+  // Opened files are kept out of the LRU list until they are closed.
+  EXPECT_EQ(diskCache->cachedFiles.size(), 1u);
+  EXPECT_EQ(diskCache->fileIDCount.load(), 4u);
   const auto InitialDiskSize = 568915u;
   EXPECT_EQ(diskCache->totalDiskSize, InitialDiskSize);
 
@@ -139,6 +165,7 @@ PAG_TEST(PAGDiskCacheTest, SequenceFile) {
   EXPECT_EQ(diskCache->totalDiskSize, InitialDiskSize + sequenceFile->fileSize() - initialFileSize);
   EXPECT_TRUE(sequenceFile->isComplete());
   EXPECT_TRUE(sequenceFile->encoder == nullptr);
+  EXPECT_TRUE(sequenceFile->fileMapped);
   success = sequenceFile->readFrame(15, buffer);
   EXPECT_TRUE(success);
   EXPECT_TRUE(Baseline::Compare(pixmap, "PAGDiskCacheTest/SequenceFile_15"));
@@ -158,6 +185,7 @@ PAG_TEST(PAGDiskCacheTest, SequenceFile) {
   EXPECT_EQ(halfSequenceFile->numFrames(), 30u);
   EXPECT_EQ(halfSequenceFile->frameRate(), pagFile->frameRate());
   EXPECT_TRUE(halfSequenceFile->isComplete());
+  EXPECT_TRUE(halfSequenceFile->fileMapped);
   success = halfSequenceFile->readFrame(20, buffer);
   EXPECT_TRUE(success);
   EXPECT_TRUE(Baseline::Compare(pixmap, "PAGDiskCacheTest/SequenceFile_20"));
@@ -415,6 +443,466 @@ PAG_TEST(PAGDiskCacheTest, PAGDecoder_StaticTimeRanges) {
   pag::PAGDiskCache::RemoveAll();
 }
 
+/**
+ * 用例描述: 测试 PAGDecoder 多线程并发读取序列帧。
+ */
+PAG_TEST(PAGDiskCacheTest, PAGDecoder_ReadFrames) {
+  pag::PAGDiskCache::RemoveAll();
+  auto pagFile = LoadPAGFile("resources/apitest/data_bmp.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto decoder = PAGDecoder::MakeFrom(pagFile, 30, 0.5f, 4);
+  ASSERT_TRUE(decoder != nullptr);
+  EXPECT_EQ(decoder->workerCount, 4);
+  pagFile = nullptr;
+  tgfx::Bitmap bitmap(decoder->width(), decoder->height(), false, false);
+  tgfx::Pixmap pixmap(bitmap);
+  std::atomic_int frameCount = {0};
+  auto success = decoder->readFrames(
+      0, decoder->numFrames() - 1, pixmap.rowBytes(), ColorType::RGBA_8888,
+      AlphaType::Premultiplied, [&](int, const void*) { frameCount++; });
+  EXPECT_TRUE(success);
+  EXPECT_EQ(frameCount, decoder->numFrames());
+  EXPECT_TRUE(decoder->sequenceFile->isComplete());
+  EXPECT_TRUE(decoder->reader == nullptr);
+  EXPECT_TRUE(decoder->getComposition() == nullptr);
+  success = decoder->readFrame(50, pixmap.writablePixels(), pixmap.rowBytes());
+  EXPECT_TRUE(success);
+  EXPECT_TRUE(Baseline::Compare(pixmap, "PAGDiskCacheTest/decoder_frame_50"));
+  success = decoder->readFrames(10, decoder->numFrames(), pixmap.rowBytes(), ColorType::RGBA_8888,
+                                AlphaType::Premultiplied);
+  EXPECT_FALSE(success);
+  success = decoder->readFrames(10, 20, pixmap.rowBytes(), ColorType::BGRA_8888,
+                                AlphaType::Premultiplied);
+  EXPECT_FALSE(success);
+  decoder = nullptr;
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 测试在 readFrames 的回调中再次调用 readFrames 时，内层在当前线程上直接渲染，不再等待线程池。
+ */
+PAG_TEST(PAGDiskCacheTest, PAGDecoder_ReadFramesNested) {
+  pag::PAGDiskCache::RemoveAll();
+  auto decoder = PAGDecoder::MakeFrom(LoadPAGFile("resources/apitest/data_bmp.pag"), 30, 0.5f, 4);
+  ASSERT_TRUE(decoder != nullptr);
+  auto innerDecoder = PAGDecoder::MakeFrom(LoadPAGFile("resources/apitest/polygon.pag"), 30, 1, 4);
+  ASSERT_TRUE(innerDecoder != nullptr);
+  tgfx::Bitmap bitmap(decoder->width(), decoder->height(), false, false);
+  tgfx::Pixmap pixmap(bitmap);
+  tgfx::Bitmap innerBitmap(innerDecoder->width(), innerDecoder->height(), false, false);
+  tgfx::Pixmap innerPixmap(innerBitmap);
+  std::atomic_int frameCount = {0};
+  std::atomic_bool innerSuccess = {false};
+  std::atomic_int innerFrameCount = {0};
+  std::atomic_int otherThreadCount = {0};
+  auto success = decoder->readFrames(
+      0, 7, pixmap.rowBytes(), ColorType::RGBA_8888, AlphaType::Premultiplied,
+      [&](int index, const void*) {
+        frameCount++;
+        if (index != 0) {
+          return;
+        }
+        auto threadID = std::this_thread::get_id();
+        innerSuccess = innerDecoder->readFrames(
+            0, innerDecoder->numFrames() - 1, innerPixmap.rowBytes(), ColorType::RGBA_8888,
+            AlphaType::Premultiplied, [&](int, const void*) {
+              innerFrameCount++;
+              if (std::this_thread::get_id() != threadID) {
+                otherThreadCount++;
+              }
+            });
+      });
+  EXPECT_TRUE(success);
+  EXPECT_EQ(frameCount, 8);
+  EXPECT_TRUE(innerSuccess);
+  EXPECT_EQ(innerFrameCount, innerDecoder->numFrames());
+  EXPECT_EQ(otherThreadCount, 0);
+  decoder = nullptr;
+  innerDecoder = nullptr;
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 测试 PAGDecoder::readFrames() 的回调中访问同一个 PAGDecoder 不会死锁，并记录最后读取的帧。
+ */
+PAG_TEST(PAGDiskCacheTest, PAGDecoder_ReadFramesReentrant) {
+  pag::PAGDiskCache::RemoveAll();
+  auto decoder = PAGDecoder::MakeFrom(LoadPAGFile("resources/apitest/data_bmp.pag"), 30, 0.5f, 4);
+  ASSERT_TRUE(decoder != nullptr);
+  auto numFrames = decoder->numFrames();
+  tgfx::Bitmap bitmap(decoder->width(), decoder->height(), false, false);
+  tgfx::Pixmap pixmap(bitmap);
+  std::atomic_int frameCount = {0};
+  std::atomic_int numFramesMismatches = {0};
+  std::atomic_int readSuccesses = {0};
+  auto success = decoder->readFrames(
+      0, 7, pixmap.rowBytes(), ColorType::RGBA_8888, AlphaType::Premultiplied,
+      [&](int index, const void*) {
+        frameCount++;
+        if (decoder->numFrames() != numFrames) {
+          numFramesMismatches++;
+        }
+        if (index == 0 && decoder->readFrame(index, pixmap.writablePixels(), pixmap.rowBytes())) {
+          readSuccesses++;
+        }
+      });
+  EXPECT_TRUE(success);
+  EXPECT_EQ(frameCount, 8);
+  EXPECT_EQ(numFramesMismatches, 0);
+  EXPECT_EQ(readSuccesses, 0);
+  EXPECT_EQ(decoder->lastReadIndex, 7);
+  EXPECT_FALSE(decoder->checkFrameChanged(7));
+  EXPECT_TRUE(decoder->readFrame(0, pixmap.writablePixels(), pixmap.rowBytes()));
+  decoder = nullptr;
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 测试 SequenceFile 的不同压缩模式。
+ */
+PAG_TEST(PAGDiskCacheTest, CompressionMode) {
+  pag::PAGDiskCache::RemoveAll();
+  EXPECT_EQ(PAGDiskCache::CompressionMode(), PAGCompressionMode::LZ4);
+  auto pagFile = LoadPAGFile("resources/apitest/polygon.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto pagPlayer = std::make_shared<PAGPlayer>();
+  pagPlayer->setComposition(pagFile);
+  auto pagSurface = OffscreenSurface::Make(pagFile->width(), pagFile->height());
+  pagPlayer->setSurface(pagSurface);
+  pagPlayer->flush();
+  tgfx::Bitmap bitmap(pagFile->width(), pagFile->height(), false, false);
+  tgfx::Pixmap pixmap(bitmap);
+  auto success = pagSurface->readPixels(ColorType::RGBA_8888, AlphaType::Premultiplied,
+                                        pixmap.writablePixels(), pixmap.rowBytes());
+  ASSERT_TRUE(success);
+  auto buffer = BitmapBuffer::Wrap(pixmap.info(), pixmap.writablePixels());
+
+  CompressionModeScope compressionModeScope(PAGCompressionMode::None);
+  EXPECT_EQ(PAGDiskCache::CompressionMode(), PAGCompressionMode::None);
+  auto sequenceFile = DiskCache::OpenSequence("CompressionMode.None", pixmap.info(), 2, 30);
+  ASSERT_TRUE(sequenceFile != nullptr);
+  EXPECT_TRUE(sequenceFile->writeFrame(0, buffer));
+  EXPECT_EQ(sequenceFile->frames[0].compression, CompressionType::None);
+  EXPECT_EQ(sequenceFile->frames[0].size, pixmap.byteSize());
+  PAGDiskCache::SetCompressionMode(PAGCompressionMode::LZ4);
+  auto lz4SequenceFile = DiskCache::OpenSequence("CompressionMode.LZ4", pixmap.info(), 2, 30);
+  ASSERT_TRUE(lz4SequenceFile != nullptr);
+  EXPECT_TRUE(lz4SequenceFile->writeFrame(0, buffer));
+  EXPECT_NE(lz4SequenceFile->frames[0].compression, CompressionType::None);
+  EXPECT_LT(lz4SequenceFile->frames[0].size, pixmap.byteSize());
+
+  tgfx::Bitmap readBitmap(pixmap.width(), pixmap.height(), false, false);
+  tgfx::Pixmap readPixmap(readBitmap);
+  auto readBuffer = BitmapBuffer::Wrap(readPixmap.info(), readPixmap.writablePixels());
+  EXPECT_TRUE(sequenceFile->readFrame(0, readBuffer));
+  EXPECT_TRUE(memcmp(readPixmap.pixels(), pixmap.pixels(), pixmap.byteSize()) == 0);
+  EXPECT_TRUE(lz4SequenceFile->readFrame(0, readBuffer));
+  EXPECT_TRUE(memcmp(readPixmap.pixels(), pixmap.pixels(), pixmap.byteSize()) == 0);
+  sequenceFile = nullptr;
+  lz4SequenceFile = nullptr;
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 测试 SequenceFile 基于关键帧的差异块压缩。
+ */
+PAG_TEST(PAGDiskCacheTest, DeltaCompression) {
+  pag::PAGDiskCache::RemoveAll();
+  auto pagFile = LoadPAGFile("resources/apitest/ZC2.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto pagPlayer = std::make_shared<PAGPlayer>();
+  pagPlayer->setComposition(pagFile);
+  auto pagSurface = OffscreenSurface::Make(pagFile->width(), pagFile->height());
+  pagPlayer->setSurface(pagSurface);
+  auto info =
+      tgfx::ImageInfo::Make(pagFile->width(), pagFile->height(), tgfx::ColorType::RGBA_8888);
+  CompressionModeScope compressionModeScope(PAGCompressionMode::Delta);
+  auto sequenceFile = DiskCache::OpenSequence("DeltaCompression", info, 10, 30);
+  ASSERT_TRUE(sequenceFile != nullptr);
+  std::vector<tgfx::Bitmap> bitmaps = {};
+  for (int i = 0; i < 10; i++) {
+    pagPlayer->flush();
+    bitmaps.emplace_back(info.width(), info.height(), false, false);
+    tgfx::Pixmap pixmap(bitmaps.back());
+    auto success = pagSurface->readPixels(ColorType::RGBA_8888, AlphaType::Premultiplied,
+                                          pixmap.writablePixels(), pixmap.rowBytes());
+    ASSERT_TRUE(success);
+    EXPECT_TRUE(
+        sequenceFile->writeFrame(i, BitmapBuffer::Wrap(pixmap.info(), pixmap.writablePixels())));
+    pagPlayer->nextFrame();
+  }
+  EXPECT_TRUE(sequenceFile->isComplete());
+  EXPECT_NE(sequenceFile->frames[0].compression, CompressionType::Delta);
+  tgfx::Bitmap readBitmap(info.width(), info.height(), false, false);
+  tgfx::Pixmap readPixmap(readBitmap);
+  auto readBuffer = BitmapBuffer::Wrap(readPixmap.info(), readPixmap.writablePixels());
+  for (int i = 9; i >= 0; i--) {
+    EXPECT_TRUE(sequenceFile->readFrame(i, readBuffer));
+    tgfx::Pixmap pixmap(bitmaps[i]);
+    EXPECT_TRUE(memcmp(readPixmap.pixels(), pixmap.pixels(), pixmap.byteSize()) == 0);
+  }
+  int deltaIndex = 9;
+  while (deltaIndex > 0 && sequenceFile->frames[deltaIndex].compression != CompressionType::Delta) {
+    deltaIndex--;
+  }
+  ASSERT_GT(deltaIndex, 0);
+  EXPECT_TRUE(sequenceFile->readFrame(deltaIndex, readBuffer));
+  auto decodedKeyframe = sequenceFile->decodedKeyframe;
+  ASSERT_TRUE(decodedKeyframe != nullptr);
+  EXPECT_EQ(decodedKeyframe->index, sequenceFile->frames[deltaIndex].keyframe);
+  // Reading the delta frame again reuses the decoded keyframe.
+  EXPECT_TRUE(sequenceFile->readFrame(deltaIndex, readBuffer));
+  EXPECT_EQ(sequenceFile->decodedKeyframe, decodedKeyframe);
+  tgfx::Pixmap deltaPixmap(bitmaps[deltaIndex]);
+  EXPECT_TRUE(memcmp(readPixmap.pixels(), deltaPixmap.pixels(), deltaPixmap.byteSize()) == 0);
+  sequenceFile = nullptr;
+  sequenceFile = DiskCache::OpenSequence("DeltaCompression", info, 10, 30);
+  ASSERT_TRUE(sequenceFile != nullptr);
+  EXPECT_TRUE(sequenceFile->isComplete());
+  EXPECT_TRUE(sequenceFile->readFrame(5, readBuffer));
+  tgfx::Pixmap pixmap(bitmaps[5]);
+  EXPECT_TRUE(memcmp(readPixmap.pixels(), pixmap.pixels(), pixmap.byteSize()) == 0);
+  sequenceFile = nullptr;
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 测试 SequenceFile 读取差异帧时拒绝越界或乱序的图块索引。
+ */
+PAG_TEST(PAGDiskCacheTest, DeltaCompressionCorruptedTiles) {
+  pag::PAGDiskCache::RemoveAll();
+  auto info = tgfx::ImageInfo::Make(256, 256, tgfx::ColorType::RGBA_8888);
+  auto sequenceFile = DiskCache::OpenSequence("DeltaCompressionCorruptedTiles", info, 2, 30);
+  ASSERT_TRUE(sequenceFile != nullptr);
+  auto frameDecoder = LZ4Decoder::Make();
+  ASSERT_TRUE(frameDecoder != nullptr);
+  std::vector<uint8_t> pixels(info.byteSize(), 0);
+  auto bitmap = BitmapBuffer::Wrap(info, pixels.data());
+  // A 256x256 frame has 16 tiles of 64x64.
+  std::vector<std::vector<uint32_t>> corruptedTiles = {{16}, {3, 3}, {5, 2}};
+  for (auto& tiles : corruptedTiles) {
+    tgfx::Buffer buffer(8 + tiles.size() * 4);
+    tgfx::DataView data(buffer.bytes(), buffer.size());
+    data.setUint32(0, 0);
+    data.setUint32(4, static_cast<uint32_t>(tiles.size()));
+    for (size_t i = 0; i < tiles.size(); i++) {
+      data.setUint32(8 + i * 4, tiles[i]);
+    }
+    FrameLocation frame = {};
+    frame.size = buffer.size();
+    frame.compression = CompressionType::Delta;
+    EXPECT_FALSE(sequenceFile->decodeDeltaFrame(frameDecoder.get(), frame, buffer.bytes(), bitmap));
+  }
+  sequenceFile = nullptr;
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 测试 SequenceFile 写入失败时不会更新关键帧，后续写入会覆盖写入失败的部分数据。
+ */
+PAG_TEST(PAGDiskCacheTest, DeltaCompressionWriteFailure) {
+  pag::PAGDiskCache::RemoveAll();
+  auto info = tgfx::ImageInfo::Make(256, 256, tgfx::ColorType::RGBA_8888);
+  CompressionModeScope compressionModeScope(PAGCompressionMode::Delta);
+  auto sequenceFile = DiskCache::OpenSequence("DeltaCompressionWriteFailure", info, 3, 30);
+  ASSERT_TRUE(sequenceFile != nullptr);
+  std::vector<uint8_t> blackPixels(info.byteSize(), 0);
+  EXPECT_TRUE(sequenceFile->writeFrame(0, BitmapBuffer::Wrap(info, blackPixels.data())));
+  EXPECT_EQ(sequenceFile->keyframeIndex, 0);
+  auto fileSize = sequenceFile->fileSize();
+  // Random pixels can not be compressed, so the frame is much larger than the file size limit
+  // below, and only a part of it reaches the disk.
+  std::mt19937 random(0);
+  std::vector<uint8_t> noisePixels(info.byteSize(), 0);
+  for (auto& pixel : noisePixels) {
+    pixel = static_cast<uint8_t>(random());
+  }
+  signal(SIGXFSZ, SIG_IGN);
+  struct rlimit limit = {};
+  ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &limit), 0);
+  auto fileSizeLimit = limit;
+  fileSizeLimit.rlim_cur = static_cast<rlim_t>(fileSize + 1024);
+  ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &fileSizeLimit), 0);
+  auto success = sequenceFile->writeFrame(1, BitmapBuffer::Wrap(info, noisePixels.data()));
+  setrlimit(RLIMIT_FSIZE, &limit);
+  EXPECT_FALSE(success);
+  auto filePath = DiskCache::GetInstance()->fileIDToPath(sequenceFile->fileID);
+  EXPECT_EQ(std::filesystem::file_size(filePath), fileSize + 1024);
+  EXPECT_EQ(sequenceFile->keyframeIndex, 0);
+  EXPECT_EQ(sequenceFile->framesSinceKeyframe, 0);
+  EXPECT_EQ(sequenceFile->fileSize(), fileSize);
+  EXPECT_EQ(sequenceFile->frames[1].size, 0u);
+
+  EXPECT_TRUE(sequenceFile->writeFrame(1, BitmapBuffer::Wrap(info, noisePixels.data())));
+  EXPECT_EQ(sequenceFile->keyframeIndex, 1);
+  auto whitePixels = noisePixels;
+  whitePixels[0] = 0;
+  EXPECT_TRUE(sequenceFile->writeFrame(2, BitmapBuffer::Wrap(info, whitePixels.data())));
+  EXPECT_EQ(sequenceFile->frames[2].compression, CompressionType::Delta);
+  EXPECT_EQ(sequenceFile->frames[2].keyframe, 1u);
+  EXPECT_TRUE(sequenceFile->isComplete());
+  EXPECT_EQ(std::filesystem::file_size(filePath), sequenceFile->fileSize());
+  std::vector<uint8_t> readPixels(info.byteSize(), 0);
+  EXPECT_TRUE(sequenceFile->readFrame(1, BitmapBuffer::Wrap(info, readPixels.data())));
+  EXPECT_TRUE(readPixels == noisePixels);
+  EXPECT_TRUE(sequenceFile->readFrame(2, BitmapBuffer::Wrap(info, readPixels.data())));
+  EXPECT_TRUE(readPixels == whitePixels);
+  sequenceFile = nullptr;
+
+  // The partially written bytes have been overwritten, so the file is still valid when reopened.
+  sequenceFile = DiskCache::OpenSequence("DeltaCompressionWriteFailure", info, 3, 30);
+  ASSERT_TRUE(sequenceFile != nullptr);
+  EXPECT_TRUE(sequenceFile->isComplete());
+  EXPECT_TRUE(sequenceFile->readFrame(2, BitmapBuffer::Wrap(info, readPixels.data())));
+  EXPECT_TRUE(readPixels == whitePixels);
+  sequenceFile = nullptr;
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 测试 PAGDecoder 异步写入磁盘缓存。
+ */
+PAG_TEST(PAGDiskCacheTest, WriteQueue) {
+  pag::PAGDiskCache::RemoveAll();
+  EXPECT_EQ(PAGDiskCache::MaxWriteQueueSize(), 0u);
+  auto pagFile = LoadPAGFile("resources/apitest/data_bmp.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto decoder = PAGDecoder::MakeFrom(pagFile, 30, 0.5f);
+  ASSERT_TRUE(decoder != nullptr);
+  pagFile = nullptr;
+  tgfx::Bitmap bitmap(decoder->width(), decoder->height(), false, false);
+  tgfx::Pixmap pixmap(bitmap);
+  PAGDiskCache::SetMaxWriteQueueSize(1);
+  auto droppedCount = PAGDiskCache::DroppedWriteCount();
+  auto success = decoder->readFrame(0, pixmap.writablePixels(), pixmap.rowBytes());
+  EXPECT_TRUE(success);
+  EXPECT_EQ(PAGDiskCache::DroppedWriteCount(), droppedCount + 1);
+  EXPECT_EQ(PAGDiskCache::WriteQueueDepth(), 0u);
+
+  PAGDiskCache::SetMaxWriteQueueSize(100 * 1024 * 1024);
+  for (int i = 0; i < decoder->numFrames(); i++) {
+    success = decoder->readFrame(i, pixmap.writablePixels(), pixmap.rowBytes());
+    EXPECT_TRUE(success);
+  }
+  while (PAGDiskCache::WriteQueueDepth() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_TRUE(decoder->sequenceFile->isComplete());
+  success = decoder->readFrame(50, pixmap.writablePixels(), pixmap.rowBytes());
+  EXPECT_TRUE(success);
+  EXPECT_TRUE(Baseline::Compare(pixmap, "PAGDiskCacheTest/decoder_frame_50"));
+  PAGDiskCache::SetMaxWriteQueueSize(0);
+  decoder = nullptr;
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 测试 PAGDecoder 共享的内存帧缓存。
+ */
+PAG_TEST(PAGDiskCacheTest, MemoryCache) {
+  pag::PAGDiskCache::RemoveAll();
+  EXPECT_EQ(PAGDiskCache::MaxMemorySize(), 0u);
+  auto pagFile = LoadPAGFile("resources/apitest/data_bmp.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto decoder = PAGDecoder::MakeFrom(pagFile, 30, 0.5f);
+  ASSERT_TRUE(decoder != nullptr);
+  pagFile = nullptr;
+  tgfx::Bitmap bitmap(decoder->width(), decoder->height(), false, false);
+  tgfx::Pixmap pixmap(bitmap);
+  auto frameSize = pixmap.info().byteSize();
+  auto success = decoder->readFrame(50, pixmap.writablePixels(), pixmap.rowBytes());
+  EXPECT_TRUE(success);
+  EXPECT_EQ(PAGDiskCache::MemoryUsage(), 0u);
+
+  PAGDiskCache::SetMaxMemorySize(frameSize * 2);
+  success = decoder->readFrame(50, pixmap.writablePixels(), pixmap.rowBytes());
+  EXPECT_TRUE(success);
+  EXPECT_EQ(PAGDiskCache::MemoryUsage(), frameSize);
+  auto& sequenceFile = decoder->sequenceFile;
+  auto timeRange = GetTimeRangeContains(sequenceFile->staticTimeRanges(), 50);
+  auto frameKey = (static_cast<uint64_t>(sequenceFile->fileID) << 32) | timeRange.start;
+  auto diskCache = DiskCache::GetInstance();
+  EXPECT_EQ(diskCache->memoryCache.frameMap.count(frameKey), 1u);
+  // Reads the frame from memory.
+  memset(pixmap.writablePixels(), 0, frameSize);
+  success = decoder->readFrame(50, pixmap.writablePixels(), pixmap.rowBytes());
+  EXPECT_TRUE(success);
+  EXPECT_TRUE(Baseline::Compare(pixmap, "PAGDiskCacheTest/decoder_frame_50"));
+  EXPECT_EQ(PAGDiskCache::MemoryUsage(), frameSize);
+
+  PAGDiskCache::SetMaxMemorySize(frameSize - 1);
+  EXPECT_EQ(PAGDiskCache::MemoryUsage(), 0u);
+  PAGDiskCache::SetMaxMemorySize(frameSize);
+  success = decoder->readFrame(50, pixmap.writablePixels(), pixmap.rowBytes());
+  EXPECT_TRUE(success);
+  EXPECT_EQ(PAGDiskCache::MemoryUsage(), frameSize);
+  // Frames are released once the sequence file is closed.
+  decoder = nullptr;
+  EXPECT_EQ(PAGDiskCache::MemoryUsage(), 0u);
+  PAGDiskCache::SetMaxMemorySize(0);
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 测试 PAGDiskCache 的预取功能。
+ */
+PAG_TEST(PAGDiskCacheTest, Prefetch) {
+  pag::PAGDiskCache::RemoveAll();
+  auto pagFile = LoadPAGFile("resources/apitest/data_bmp.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto decoder = PAGDecoder::MakeFrom(pagFile, 30, 0.5f);
+  ASSERT_TRUE(decoder != nullptr);
+  tgfx::Bitmap bitmap(decoder->width(), decoder->height(), false, false);
+  tgfx::Pixmap pixmap(bitmap);
+  auto success = decoder->readFrames(0, decoder->numFrames() - 1, pixmap.rowBytes(),
+                                     ColorType::RGBA_8888, AlphaType::Premultiplied);
+  EXPECT_TRUE(success);
+  decoder = nullptr;
+
+  decoder = PAGDecoder::MakeFrom(pagFile, 30, 0.5f);
+  ASSERT_TRUE(decoder != nullptr);
+  auto maxMemorySize = PAGDiskCache::MaxMemorySize();
+  // The preloaded frames are held by the memory cache, which has room for 3 frames only.
+  PAGDiskCache::SetMaxMemorySize(pixmap.byteSize() * 3);
+  success = PAGDiskCache::Prefetch(decoder, pixmap.rowBytes(), ColorType::RGBA_8888,
+                                   AlphaType::Premultiplied, 5);
+  EXPECT_TRUE(success);
+  auto diskCache = DiskCache::GetInstance();
+  while (true) {
+    {
+      std::lock_guard<std::mutex> autoLock(diskCache->prefetchLocker);
+      if (!diskCache->prefetchTaskRunning) {
+        break;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(diskCache->prefetchedFiles.size(), 1u);
+  auto sequenceFile = diskCache->prefetchedFiles.front().second;
+  EXPECT_TRUE(sequenceFile->isComplete());
+  EXPECT_TRUE(diskCache->memoryCache.hasFrame(sequenceFile->fileID, 0));
+  EXPECT_FALSE(diskCache->memoryCache.hasFrame(sequenceFile->fileID, 3));
+  EXPECT_GT(PAGDiskCache::MemoryUsage(), 0u);
+  EXPECT_LE(PAGDiskCache::MemoryUsage(), pixmap.byteSize() * 3);
+  success = decoder->readFrame(3, pixmap.writablePixels(), pixmap.rowBytes());
+  EXPECT_TRUE(success);
+  EXPECT_EQ(decoder->sequenceFile, sequenceFile);
+  EXPECT_TRUE(diskCache->prefetchedFiles.empty());
+  decoder = nullptr;
+  sequenceFile = nullptr;
+
+  decoder = PAGDecoder::MakeFrom(pagFile, 30, 0.5f);
+  ASSERT_TRUE(decoder != nullptr);
+  decoder->setCacheKeyGeneratorFun(
+      [](PAGDecoder*, std::shared_ptr<PAGComposition>) { return std::string(); });
+  success = PAGDiskCache::Prefetch(decoder, pixmap.rowBytes(), ColorType::RGBA_8888,
+                                   AlphaType::Premultiplied);
+  EXPECT_FALSE(success);
+  decoder = nullptr;
+  PAGDiskCache::SetMaxMemorySize(maxMemorySize);
+  pag::PAGDiskCache::RemoveAll();
+}
+
 PAG_TEST(PAGDiskCacheTest, FileCache) {
   pag::PAGDiskCache::RemoveAll();
   auto data = ReadFile("resources/apitest/polygon.pag");
@@ -429,4 +917,88 @@ PAG_TEST(PAGDiskCacheTest, FileCache) {
   pag::PAGDiskCache::RemoveAll();
 }
 
+/**
+ * 用例描述: 测试磁盘缓存配置以追加日志的方式写入，并能在重启后正确恢复。
+ */
+PAG_TEST(PAGDiskCacheTest, ConfigJournal) {
+  pag::PAGDiskCache::RemoveAll();
+  auto data = ReadFile("resources/apitest/polygon.pag");
+  ASSERT_TRUE(data != nullptr);
+  auto diskCache = DiskCache::GetInstance();
+  EXPECT_EQ(std::filesystem::file_size(diskCache->configPath), 0u);
+  EXPECT_TRUE(DiskCache::WriteFile("journal.a", data));
+  EXPECT_TRUE(DiskCache::WriteFile("journal.b", data));
+  EXPECT_TRUE(DiskCache::WriteFile("journal.a", data));
+  // Each change appends one record instead of rewriting the whole config.
+  EXPECT_EQ(diskCache->journalRecordCount, 3u);
+  EXPECT_EQ(std::filesystem::file_size(diskCache->configPath), 3u * 8u + 27u);
+  auto restoredCache = std::unique_ptr<DiskCache>(new DiskCache());
+  EXPECT_EQ(restoredCache->cachedFileInfos.size(), 2u);
+  EXPECT_EQ(restoredCache->cachedFiles.size(), 2u);
+  EXPECT_EQ(restoredCache->totalDiskSize, data->size() * 2);
+  EXPECT_EQ(restoredCache->getFileID("journal.a"), diskCache->getFileID("journal.a"));
+  restoredCache = nullptr;
+  // "journal.b" is the least recently used file now.
+  pag::PAGDiskCache::SetMaxDiskSize(data->size());
+  EXPECT_EQ(diskCache->cachedFileInfos.size(), 1u);
+  auto filePathA = diskCache->fileIDToPath(diskCache->getFileID("journal.a"));
+  auto filePathB = diskCache->fileIDToPath(diskCache->getFileID("journal.b"));
+  EXPECT_TRUE(std::filesystem::exists(filePathA));
+  EXPECT_FALSE(std::filesystem::exists(filePathB));
+  restoredCache = std::unique_ptr<DiskCache>(new DiskCache());
+  EXPECT_EQ(restoredCache->cachedFileInfos.size(), 1u);
+  EXPECT_EQ(restoredCache->totalDiskSize, data->size());
+  restoredCache = nullptr;
+  PAGDiskCache::SetMaxDiskSize(1073741824);  // 1GB
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 测试打开序列帧文件时只在内存中记录访问，关闭文件时再批量写入配置日志。
+ */
+PAG_TEST(PAGDiskCacheTest, ConfigJournalBatch) {
+  pag::PAGDiskCache::RemoveAll();
+  auto diskCache = DiskCache::GetInstance();
+  auto info = tgfx::ImageInfo::Make(100, 100, tgfx::ColorType::RGBA_8888);
+  auto sequenceFile = DiskCache::OpenSequence("journal.sequence", info, 10, 30);
+  ASSERT_TRUE(sequenceFile != nullptr);
+  auto sameFile = DiskCache::OpenSequence("journal.sequence", info, 10, 30);
+  EXPECT_EQ(sameFile, sequenceFile);
+  EXPECT_EQ(diskCache->pendingConfigCount, 1u);
+  EXPECT_EQ(std::filesystem::file_size(diskCache->configPath), 0u);
+  sameFile = nullptr;
+  sequenceFile = nullptr;
+  EXPECT_EQ(diskCache->pendingConfigCount, 0u);
+  EXPECT_EQ(std::filesystem::file_size(diskCache->configPath), 8u + 16u);
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: CompositionReader 轮换读取到不同的 bitmap 时复用同一个离屏 Surface
+ */
+PAG_TEST(PAGDiskCacheTest, CompositionReader_RotatingBitmaps) {
+  auto pagFile = LoadPAGFile("resources/apitest/ZC2.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto reader = CompositionReader::Make(pagFile->width(), pagFile->height());
+  ASSERT_TRUE(reader != nullptr);
+  reader->setComposition(pagFile);
+  std::vector<tgfx::Bitmap> bitmaps = {};
+  std::vector<std::shared_ptr<BitmapBuffer>> buffers = {};
+  for (int i = 0; i < 2; i++) {
+    bitmaps.emplace_back(pagFile->width(), pagFile->height(), false, false);
+    tgfx::Pixmap pixmap(bitmaps.back());
+    buffers.push_back(BitmapBuffer::Wrap(pixmap.info(), pixmap.writablePixels()));
+  }
+  EXPECT_TRUE(reader->readFrame(0.5, buffers[0]));
+  auto surface = reader->drawable->surface;
+  ASSERT_TRUE(surface != nullptr);
+  // The frame has not changed, it is read back from the persistent surface.
+  EXPECT_TRUE(reader->readFrame(0.5, buffers[1]));
+  EXPECT_EQ(reader->drawable->surface, surface);
+  tgfx::Pixmap pixmap(bitmaps[0]);
+  EXPECT_TRUE(memcmp(tgfx::Pixmap(bitmaps[1]).pixels(), pixmap.pixels(), pixmap.byteSize()) == 0);
+  EXPECT_TRUE(reader->readFrame(0.8, buffers[0]));
+  EXPECT_EQ(reader->drawable->surface, surface);
+}
+
 }  // namespace pag
@@ -16,8 +16,11 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <thread>
 #include "base/utils/TimeUtil.h"
 #include "nlohmann/json.hpp"
+#include "rendering/caches/FrameCache.h"
+#include "rendering/utils/Transform.h"
 #include "utils/TestUtils.h"
 
 #define PAG_COMPLEX_FILE_PATH TestConstants::PAG_ROOT + "resources/apitest/complex_test.pag"
@@ -368,6 +371,44 @@ PAG_TEST(PAGFileLoadTest, loadTest) {
   ASSERT_TRUE(file == nullptr);
 }
 
+/**
+ * 用例描述: PAGFile零拷贝解码测试，内嵌资源直接引用源数据
+ */
+PAG_TEST(PAGFileLoadTest, DecodeWithoutCopy) {
+  std::shared_ptr<ByteData> byteData =
+      ByteData::FromPath(ProjectPath::Absolute("resources/apitest/complex_test.pag"));
+  ASSERT_TRUE(byteData != nullptr);
+  auto start = byteData->data();
+  auto end = start + byteData->length();
+  auto file = Codec::Decode(start, static_cast<uint32_t>(byteData->length()), "", byteData);
+  ASSERT_TRUE(file != nullptr);
+  ASSERT_FALSE(file->images.empty());
+  for (auto imageBytes : file->images) {
+    ASSERT_TRUE(imageBytes->fileBytes != nullptr);
+    EXPECT_TRUE(imageBytes->fileBytes->data() >= start);
+    EXPECT_TRUE(imageBytes->fileBytes->data() + imageBytes->fileBytes->length() <= end);
+  }
+  EXPECT_GT(byteData.use_count(), 1);
+  auto copiedFile = Codec::Decode(start, static_cast<uint32_t>(byteData->length()), "");
+  ASSERT_TRUE(copiedFile != nullptr);
+  auto encodedData = Codec::Encode(file);
+  auto copiedData = Codec::Encode(copiedFile);
+  ASSERT_EQ(encodedData->length(), copiedData->length());
+  EXPECT_EQ(memcmp(encodedData->data(), copiedData->data(), encodedData->length()), 0);
+  file = nullptr;
+  EXPECT_EQ(byteData.use_count(), 1);
+
+  auto pagFile = PAGFile::LoadMapped(ProjectPath::Absolute("resources/apitest/complex_test.pag"));
+  ASSERT_TRUE(pagFile != nullptr);
+  // Loading by path copies the file by default, and does not share the mapped one.
+  auto loadedFile = PAGFile::Load(ProjectPath::Absolute("resources/apitest/complex_test.pag"));
+  ASSERT_TRUE(loadedFile != nullptr);
+  EXPECT_NE(loadedFile->getFile(), pagFile->getFile());
+  auto mappedData = Codec::Encode(pagFile->getFile());
+  ASSERT_EQ(mappedData->length(), copiedData->length());
+  EXPECT_EQ(memcmp(mappedData->data(), copiedData->data(), mappedData->length()), 0);
+}
+
 /**
  * 用例描述: PAGFile children编辑测试
  */
@@ -718,4 +759,151 @@ PAG_TEST(PAGFileTest, EditableIndices) {
   ASSERT_EQ(editableTexts[1], static_cast<int>(0));
 }
 
+class TestFrameCache : public FrameCache<Transform> {
+ public:
+  explicit TestFrameCache(Frame duration) : FrameCache<Transform>(0, duration) {
+    staticTimeRanges = {};
+  }
+
+ protected:
+  Transform* createCache(Frame) override {
+    return new Transform();
+  }
+};
+
+/**
+ * 用例描述: FrameCache淘汰超出上限的帧，命中的帧优先保留，并统计未命中和淘汰次数
+ */
+PAG_TEST(PAGFileTest, FrameCacheEviction) {
+  auto maxCount = PAGFile::MaxFrameCacheCount();
+  PAGFile::SetMaxFrameCacheCount(4);
+  auto hitCount = FrameCacheStats::HitCount();
+  auto missCount = FrameCacheStats::MissCount();
+  auto evictionCount = FrameCacheStats::EvictionCount();
+  auto memoryUsage = FrameCacheStats::MemoryUsage();
+  {
+    TestFrameCache cache(100);
+    for (Frame frame = 0; frame < 10; frame++) {
+      ASSERT_NE(cache.getCache(frame), nullptr);
+    }
+    EXPECT_EQ(cache.cachedFrames.size(), 4u);
+    EXPECT_EQ(FrameCacheStats::MissCount() - missCount, 10);
+    EXPECT_EQ(FrameCacheStats::EvictionCount() - evictionCount, 6);
+    EXPECT_EQ(FrameCacheStats::MemoryUsage() - memoryUsage,
+              static_cast<int64_t>(4 * sizeof(Transform)));
+    // Frame 6 is the oldest one, hitting it gives it a second chance, so frame 7 is evicted next.
+    auto transform = cache.getCache(6);
+    EXPECT_EQ(cache.getCache(6), transform);
+    EXPECT_EQ(FrameCacheStats::HitCount() - hitCount, 2);
+    EXPECT_EQ(FrameCacheStats::MissCount() - missCount, 10);
+    cache.getCache(10);
+    auto& frames = cache.cachedFrames;
+    EXPECT_NE(std::find(frames.begin(), frames.end(), 6), frames.end());
+    EXPECT_EQ(std::find(frames.begin(), frames.end(), 7), frames.end());
+    // The cache held by the caller stays alive after it is evicted.
+    auto held = cache.getCache(20);
+    held->alpha = 0.5f;
+    for (Frame frame = 30; frame < 40; frame++) {
+      cache.getCache(frame);
+    }
+    EXPECT_EQ(std::find(frames.begin(), frames.end(), 20), frames.end());
+    EXPECT_EQ(held.use_count(), 1);
+    EXPECT_EQ(held->alpha, 0.5f);
+  }
+  EXPECT_EQ(FrameCacheStats::MemoryUsage(), memoryUsage);
+  PAGFile::SetMaxFrameCacheCount(maxCount);
+}
+
+class CountedCache {
+ public:
+  static std::atomic_int LiveCount;
+
+  CountedCache() {
+    LiveCount++;
+  }
+
+  ~CountedCache() {
+    LiveCount--;
+  }
+};
+
+std::atomic_int CountedCache::LiveCount = {0};
+
+class CountedFrameCache : public FrameCache<CountedCache> {
+ public:
+  explicit CountedFrameCache(Frame duration) : FrameCache<CountedCache>(0, duration) {
+    staticTimeRanges = {};
+  }
+
+ protected:
+  CountedCache* createCache(Frame) override {
+    return new CountedCache();
+  }
+};
+
+/**
+ * 用例描述: 多线程并发读取 FrameCache 时，被淘汰的缓存在没有调用方持有后立即释放
+ */
+PAG_TEST(PAGFileTest, FrameCacheConcurrentRelease) {
+  auto maxCount = PAGFile::MaxFrameCacheCount();
+  PAGFile::SetMaxFrameCacheCount(2);
+  auto liveCount = CountedCache::LiveCount.load();
+  {
+    CountedFrameCache cache(64);
+    std::vector<std::thread> threads = {};
+    for (int i = 0; i < 4; i++) {
+      threads.emplace_back([&cache, i]() {
+        for (Frame frame = 0; frame < 2000; frame++) {
+          cache.getCache((frame * (i + 1)) % 64);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    // Only the frames still in the cache are alive, none of the evicted ones is kept around.
+    EXPECT_LE(cache.cachedFrames.size(), 2u);
+    EXPECT_EQ(CountedCache::LiveCount - liveCount, static_cast<int>(cache.cachedFrames.size()));
+  }
+  EXPECT_EQ(CountedCache::LiveCount, liveCount);
+  PAGFile::SetMaxFrameCacheCount(maxCount);
+}
+
+/**
+ * 用例描述: 多线程并发读取 FrameCache 且频繁淘汰时，取到的缓存在使用期间始终有效
+ */
+PAG_TEST(PAGFileTest, FrameCacheConcurrentEviction) {
+  auto maxCount = PAGFile::MaxFrameCacheCount();
+  PAGFile::SetMaxFrameCacheCount(1);
+  auto hitCount = FrameCacheStats::HitCount();
+  auto missCount = FrameCacheStats::MissCount();
+  auto memoryUsage = FrameCacheStats::MemoryUsage();
+  {
+    TestFrameCache cache(64);
+    std::vector<std::thread> threads = {};
+    std::atomic_int failures = {0};
+    for (int i = 0; i < 4; i++) {
+      threads.emplace_back([&cache, &failures, i]() {
+        for (Frame frame = 0; frame < 2000; frame++) {
+          auto transform = cache.getCache((frame * (i + 1)) % 64);
+          auto nextTransform = cache.getCache((frame * (i + 1) + 1) % 64);
+          if (transform == nullptr || nextTransform == nullptr || transform->alpha != 1.0f ||
+              nextTransform->alpha != 1.0f) {
+            failures++;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    // The hits counted by the exited threads are kept.
+    EXPECT_EQ(FrameCacheStats::HitCount() + FrameCacheStats::MissCount() - hitCount - missCount,
+              4 * 2000 * 2);
+    EXPECT_EQ(failures, 0);
+    EXPECT_LE(cache.cachedFrames.size(), 1u);
+  }
+  EXPECT_EQ(FrameCacheStats::MemoryUsage(), memoryUsage);
+  PAGFile::SetMaxFrameCacheCount(maxCount);
+}
 }  // namespace pag
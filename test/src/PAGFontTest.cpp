@@ -20,6 +20,7 @@
 #include <vector>
 #include "base/utils/TimeUtil.h"
 #include "nlohmann/json.hpp"
+#include "rendering/utils/shaper/TextShaper.h"
 #include "utils/TestUtils.h"
 
 namespace pag {
@@ -58,4 +59,32 @@ PAG_TEST(PAGFontTest, TestFont) {
   EXPECT_EQ(errorMsg, "") << "test_font frame fail";
 }
 
+/**
+ * 用例描述: 文本排版结果缓存，相同的文本和字体直接复用上次的排版结果
+ */
+PAG_TEST(PAGFontTest, ShapingCache) {
+  auto typeface =
+      tgfx::Typeface::MakeFromPath(ProjectPath::Absolute("resources/font/NotoSerifSC-Regular.otf"));
+  ASSERT_TRUE(typeface != nullptr);
+  TextShaper::PurgeCaches();
+  std::string text = "Hello, 世界！";
+  auto glyphs = TextShaper::Shape(text, typeface);
+  ASSERT_FALSE(glyphs.empty());
+  auto cachedGlyphs = TextShaper::Shape(text, typeface);
+  ASSERT_EQ(cachedGlyphs.size(), glyphs.size());
+  for (size_t i = 0; i < glyphs.size(); i++) {
+    EXPECT_EQ(cachedGlyphs[i].typeface, glyphs[i].typeface);
+    EXPECT_EQ(cachedGlyphs[i].glyphIDs, glyphs[i].glyphIDs);
+    EXPECT_EQ(cachedGlyphs[i].stringIndex, glyphs[i].stringIndex);
+  }
+  auto otherGlyphs = TextShaper::Shape("Hello", typeface);
+  EXPECT_LT(otherGlyphs.size(), glyphs.size());
+  TextShaper::PurgeCaches();
+  auto shapedGlyphs = TextShaper::Shape(text, typeface);
+  ASSERT_EQ(shapedGlyphs.size(), glyphs.size());
+  for (size_t i = 0; i < glyphs.size(); i++) {
+    EXPECT_EQ(shapedGlyphs[i].glyphIDs, glyphs[i].glyphIDs);
+  }
+}
+
 }  // namespace pag
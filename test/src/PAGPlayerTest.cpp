@@ -17,6 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "nlohmann/json.hpp"
+#include "rendering/caches/RenderCache.h"
 #include "utils/TestUtils.h"
 
 namespace pag {
@@ -129,4 +130,109 @@ PAG_TEST(PAGPlayerTest, autoClear) {
   EXPECT_TRUE(Baseline::Compare(pagSurface, "PAGPlayerTest/autoClear_autoClear_true"));
 }
 
+/**
+ * 用例描述: 多个 PAGPlayer 共享资源缓存，相同图片只创建一次，不再使用后按内存上限回收
+ */
+PAG_TEST(PAGPlayerTest, sharedAssetCache) {
+  auto pagImage = MakePAGImage("resources/apitest/imageReplacement.png");
+  ASSERT_NE(pagImage, nullptr);
+  std::vector<std::shared_ptr<PAGPlayer>> players = {};
+  for (int i = 0; i < 2; i++) {
+    auto pagFile = LoadPAGFile("resources/apitest/ImageDecodeTest.pag");
+    ASSERT_NE(pagFile, nullptr);
+    pagFile->replaceImage(1, pagImage);
+    auto pagPlayer = MakeOffscreenPlayer(pagFile);
+    pagPlayer->setUseSharedAssetCache(true);
+    EXPECT_TRUE(pagPlayer->useSharedAssetCache());
+    pagPlayer->setProgress(0);
+    pagPlayer->flush();
+    players.push_back(pagPlayer);
+  }
+  auto firstCache = players[0]->renderCache;
+  auto secondCache = players[1]->renderCache;
+  ASSERT_EQ(firstCache->sharedAssets.count(pagImage->uniqueID()), 1u);
+  ASSERT_EQ(secondCache->sharedAssets.count(pagImage->uniqueID()), 1u);
+  EXPECT_EQ(firstCache->assetImages[pagImage->uniqueID()],
+            secondCache->assetImages[pagImage->uniqueID()]);
+  auto memoryUsage = PAGAssetCache::MemoryUsage();
+  EXPECT_GT(memoryUsage, 0u);
+
+  players[1]->setUseSharedAssetCache(false);
+  EXPECT_TRUE(secondCache->sharedAssets.empty());
+  EXPECT_EQ(PAGAssetCache::MemoryUsage(), memoryUsage);
+  auto maxMemorySize = PAGAssetCache::MaxMemorySize();
+  PAGAssetCache::SetMaxMemorySize(0);
+  // The image is still used by the first player, so it can not be evicted.
+  EXPECT_EQ(PAGAssetCache::MemoryUsage(), memoryUsage);
+  players = {};
+  EXPECT_EQ(PAGAssetCache::MemoryUsage(), 0u);
+  PAGAssetCache::SetMaxMemorySize(maxMemorySize);
+}
+
+/**
+ * 用例描述: 全局显存预算，超出预算或内存告警时释放所有 PAGPlayer 的缓存
+ */
+PAG_TEST(PAGPlayerTest, memoryGovernor) {
+  auto initialUsage = PAGMemoryGovernor::MemoryUsage();
+  std::vector<std::shared_ptr<PAGPlayer>> players = {};
+  for (auto& path : {"resources/apitest/test.pag", "resources/apitest/complex_test.pag"}) {
+    auto pagPlayer = MakeOffscreenPlayer(LoadPAGFile(path));
+    ASSERT_NE(pagPlayer, nullptr);
+    pagPlayer->setProgress(0.5);
+    pagPlayer->flush();
+    players.push_back(pagPlayer);
+  }
+  auto memoryUsage = players[0]->renderCache->memoryUsage() +
+                     players[1]->renderCache->memoryUsage();
+  EXPECT_EQ(PAGMemoryGovernor::MemoryUsage(), initialUsage + memoryUsage);
+
+  PAGMemoryGovernor::OnMemoryPressure(PAGMemoryPressureLevel::Moderate);
+  EXPECT_LE(PAGMemoryGovernor::MemoryUsage(), initialUsage + memoryUsage);
+
+  PAGMemoryGovernor::SetMaxMemorySize(1);
+  EXPECT_EQ(PAGMemoryGovernor::MaxMemorySize(), 1u);
+  for (auto& pagPlayer : players) {
+    EXPECT_TRUE(pagPlayer->renderCache->snapshotCaches.empty());
+    EXPECT_TRUE(pagPlayer->renderCache->textAtlases.empty());
+    EXPECT_TRUE(pagPlayer->renderCache->sequenceCaches.empty());
+    EXPECT_EQ(pagPlayer->renderCache->memoryUsage(), 0u);
+  }
+  // Caches registered by others may be trimmed as well, so the usage can drop below the initial.
+  auto trimmedUsage = PAGMemoryGovernor::MemoryUsage();
+  EXPECT_LE(trimmedUsage, initialUsage);
+  PAGMemoryGovernor::SetMaxMemorySize(0);
+
+  players[0]->nextFrame();
+  players[0]->flush();
+  EXPECT_EQ(PAGMemoryGovernor::MemoryUsage(),
+            trimmedUsage + players[0]->renderCache->memoryUsage());
+  PAGMemoryGovernor::OnMemoryPressure(PAGMemoryPressureLevel::Critical);
+  EXPECT_EQ(players[0]->renderCache->memoryUsage(), 0u);
+  EXPECT_LE(PAGMemoryGovernor::MemoryUsage(), trimmedUsage);
+}
+
+/**
+ * 用例描述: 流水线渲染，绘制当前帧时异步准备下一帧的图层内容，渲染结果与普通模式一致
+ */
+PAG_TEST(PAGPlayerTest, pipelinedRendering) {
+  auto normalPlayer = MakeOffscreenPlayer(LoadPAGFile("resources/apitest/complex_test.pag"));
+  ASSERT_NE(normalPlayer, nullptr);
+  auto pagPlayer = MakeOffscreenPlayer(LoadPAGFile("resources/apitest/complex_test.pag"));
+  ASSERT_NE(pagPlayer, nullptr);
+  EXPECT_FALSE(pagPlayer->pipelinedRenderingEnabled());
+  pagPlayer->setPipelinedRenderingEnabled(true);
+  EXPECT_TRUE(pagPlayer->pipelinedRenderingEnabled());
+  for (int i = 0; i < 10; i++) {
+    for (auto& player : {normalPlayer, pagPlayer}) {
+      player->nextFrame();
+      ASSERT_TRUE(player->flush());
+    }
+    EXPECT_NE(pagPlayer->renderCache->contentTask, nullptr);
+    EXPECT_TRUE(ComparePixels(normalPlayer->getSurface(), pagPlayer->getSurface()))
+        << "frame: " << i;
+  }
+  pagPlayer->setPipelinedRenderingEnabled(false);
+  EXPECT_EQ(pagPlayer->renderCache->contentTask, nullptr);
+}
+
 }  // namespace pag
\ No newline at end of file
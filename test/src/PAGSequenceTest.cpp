@@ -20,10 +20,35 @@
 #include "pag/pag.h"
 #include "platform/swiftshader/NativePlatform.h"
 #include "rendering/caches/RenderCache.h"
+#include "rendering/sequences/BitmapSequenceReader.h"
+#include "tgfx/core/Canvas.h"
+#include "tgfx/core/ImageCodec.h"
+#include "tgfx/core/Pixmap.h"
+#include "tgfx/core/Surface.h"
+#include "utils/DevicePool.h"
 #include "utils/TestUtils.h"
 
 namespace pag {
 
+static std::vector<uint8_t> ReadBufferPixels(tgfx::Context* context,
+                                             std::shared_ptr<tgfx::ImageBuffer> buffer) {
+  auto image = tgfx::Image::MakeFrom(std::move(buffer));
+  if (image == nullptr) {
+    return {};
+  }
+  auto surface = tgfx::Surface::Make(context, image->width(), image->height());
+  if (surface == nullptr) {
+    return {};
+  }
+  surface->getCanvas()->drawImage(image);
+  auto info = tgfx::ImageInfo::Make(image->width(), image->height(), tgfx::ColorType::RGBA_8888);
+  std::vector<uint8_t> pixels(info.byteSize());
+  if (!surface->readPixels(info, pixels.data())) {
+    return {};
+  }
+  return pixels;
+}
+
 /**
  * 用例描述: 测试直接上屏
  */
@@ -114,6 +139,146 @@ PAG_TEST(PAGSequenceTest, VideoSequenceToMP4WithoutHeader) {
   EXPECT_TRUE(
       Baseline::Compare(std::move(MP4Data), "PAGSequenceTest/VideoSequenceToMP4WithoutHeader"));
 }
+/**
+ * 用例描述: 从路径加载时视频序列帧数据延迟解码，首次访问时才拷贝
+ */
+PAG_TEST(PAGSequenceTest, VideoSequenceLazyDecoding) {
+  auto pagFile = LoadPAGFile("resources/apitest/video_sequence_without_mp4header.pag");
+  ASSERT_NE(pagFile, nullptr);
+  auto preComposeLayer = static_cast<const PreComposeLayer*>(pagFile->getLayer());
+  auto videoComposition = static_cast<VideoComposition*>(preComposeLayer->composition);
+  ASSERT_FALSE(videoComposition->sequences.empty());
+  auto videoSequence = videoComposition->sequences.at(0);
+  ASSERT_FALSE(videoSequence->frames.empty());
+  EXPECT_NE(videoSequence->frameLoader, nullptr);
+  // Loading the file from a path does not copy any video frame until they are accessed.
+  for (auto frame : videoSequence->frames) {
+    EXPECT_EQ(frame->fileBytes, nullptr);
+  }
+  videoSequence->loadFrames();
+  for (auto frame : videoSequence->frames) {
+    ASSERT_NE(frame->fileBytes, nullptr);
+  }
+
+  auto byteData = ByteData::FromPath(
+      ProjectPath::Absolute("resources/apitest/video_sequence_without_mp4header.pag"));
+  ASSERT_NE(byteData, nullptr);
+  auto file = Codec::Decode(byteData->data(), static_cast<uint32_t>(byteData->length()), "");
+  ASSERT_NE(file, nullptr);
+  auto composition = static_cast<VideoComposition*>(file->getRootLayer()->composition);
+  auto sequence = composition->sequences.at(0);
+  EXPECT_EQ(sequence->frameLoader, nullptr);
+  ASSERT_EQ(sequence->frames.size(), videoSequence->frames.size());
+  for (size_t i = 0; i < sequence->frames.size(); i++) {
+    auto lazyBytes = videoSequence->frames[i]->fileBytes;
+    auto fileBytes = sequence->frames[i]->fileBytes;
+    ASSERT_EQ(lazyBytes->length(), fileBytes->length());
+    EXPECT_EQ(memcmp(lazyBytes->data(), fileBytes->data(), fileBytes->length()), 0);
+  }
+}
+
+/**
+ * 用例描述: 位图序列帧检查点缓存，回退seek时从检查点开始解码，结果与完整解码一致
+ */
+PAG_TEST(PAGSequenceTest, BitmapSequenceCheckpoint) {
+  auto pagFile = LoadPAGFile("resources/apitest/ZC_mg_seky2_landscape.pag");
+  ASSERT_NE(pagFile, nullptr);
+  auto file = pagFile->getFile();
+  BitmapSequence* sequence = nullptr;
+  for (auto composition : file->compositions) {
+    if (composition->type() == CompositionType::Bitmap) {
+      sequence = static_cast<BitmapComposition*>(composition)->sequences[0];
+      break;
+    }
+  }
+  ASSERT_NE(sequence, nullptr);
+  auto totalFrames = static_cast<Frame>(sequence->frames.size());
+  ASSERT_GT(totalFrames, 8);
+  auto reader = std::make_shared<BitmapSequenceReader>(file, sequence);
+  reader->setCheckpointInterval(4);
+  for (Frame frame = 0; frame < totalFrames; frame++) {
+    ASSERT_NE(reader->readBuffer(frame), nullptr);
+  }
+  EXPECT_FALSE(reader->checkpoints.empty());
+  EXPECT_GT(reader->checkpointMemory, 0u);
+
+  // The frame restored from a checkpoint is the same as the one decoded from the keyframe. Both
+  // buffers are read back through a surface, since they may be hardware buffers.
+  auto device = DevicePool::Make();
+  ASSERT_TRUE(device != nullptr);
+  auto context = device->lockContext();
+  ASSERT_TRUE(context != nullptr);
+  auto targetFrame = totalFrames / 2 + 1;
+  auto pixels = ReadBufferPixels(context, reader->readBuffer(targetFrame));
+  ASSERT_FALSE(pixels.empty());
+  auto expectReader = std::make_shared<BitmapSequenceReader>(file, sequence);
+  auto expectPixels = ReadBufferPixels(context, expectReader->readBuffer(targetFrame));
+  ASSERT_FALSE(expectPixels.empty());
+  EXPECT_TRUE(pixels == expectPixels);
+  device->unlock();
+
+  reader->setCheckpointInterval(0);
+  EXPECT_TRUE(reader->checkpoints.empty());
+  EXPECT_EQ(reader->checkpointMemory, 0u);
+}
+
+/**
+ * 用例描述: 序列帧包含多个互不重叠的区域时并行解码，结果与逐个区域串行解码完全一致。
+ */
+PAG_TEST(PAGSequenceTest, BitmapSequenceParallelRects) {
+  auto pagFile = LoadPAGFile("resources/apitest/ZC_mg_seky2_landscape.pag");
+  ASSERT_NE(pagFile, nullptr);
+  auto file = pagFile->getFile();
+  BitmapSequence* sequence = nullptr;
+  for (auto composition : file->compositions) {
+    if (composition->type() == CompositionType::Bitmap) {
+      sequence = static_cast<BitmapComposition*>(composition)->sequences[0];
+      break;
+    }
+  }
+  ASSERT_NE(sequence, nullptr);
+  ASSERT_GE(static_cast<int64_t>(sequence->width) * sequence->height, 256 * 256);
+  auto reader = std::make_shared<BitmapSequenceReader>(file, sequence);
+  auto info = tgfx::ImageInfo::Make(sequence->width, sequence->height, tgfx::ColorType::RGBA_8888);
+  std::vector<uint8_t> keyframePixels(info.byteSize(), 0);
+  tgfx::Pixmap keyframePixmap(info, keyframePixels.data());
+  ASSERT_TRUE(sequence->frames[0]->isKeyframe);
+  ASSERT_TRUE(reader->decodeBitmapFrame(sequence->frames[0], keyframePixmap));
+  // Splits the keyframe into four non-overlapping rects, which are decoded in parallel.
+  BitmapFrame bitmapFrame = {};
+  bitmapFrame.isKeyframe = true;
+  auto halfWidth = info.width() / 2;
+  auto halfHeight = info.height() / 2;
+  for (int i = 0; i < 4; i++) {
+    auto x = (i % 2) * halfWidth;
+    auto y = (i / 2) * halfHeight;
+    auto width = i % 2 == 0 ? halfWidth : info.width() - halfWidth;
+    auto height = i / 2 == 0 ? halfHeight : info.height() - halfHeight;
+    auto rectInfo = tgfx::ImageInfo::Make(width, height, info.colorType(), info.alphaType(),
+                                          info.rowBytes());
+    tgfx::Pixmap rectPixmap(rectInfo, keyframePixels.data() + info.rowBytes() * y + x * 4);
+    auto bytes = tgfx::ImageCodec::Encode(rectPixmap, tgfx::EncodedFormat::PNG, 100);
+    ASSERT_TRUE(bytes != nullptr);
+    auto bitmapRect = new BitmapRect();
+    bitmapRect->x = x;
+    bitmapRect->y = y;
+    bitmapRect->fileBytes = ByteData::MakeCopy(bytes->data(), bytes->size()).release();
+    bitmapFrame.bitmaps.push_back(bitmapRect);
+  }
+  std::vector<uint8_t> parallelPixels(info.byteSize(), 0);
+  tgfx::Pixmap parallelPixmap(info, parallelPixels.data());
+  ASSERT_TRUE(reader->decodeBitmapFrame(&bitmapFrame, parallelPixmap));
+  std::vector<uint8_t> serialPixels(info.byteSize(), 0);
+  for (auto bitmapRect : bitmapFrame.bitmaps) {
+    auto codec = tgfx::ImageCodec::MakeFrom(tgfx::Data::MakeWithoutCopy(
+        bitmapRect->fileBytes->data(), bitmapRect->fileBytes->length()));
+    ASSERT_TRUE(codec != nullptr);
+    auto offset = info.rowBytes() * bitmapRect->y + bitmapRect->x * 4;
+    ASSERT_TRUE(codec->readPixels(info, serialPixels.data() + offset));
+  }
+  EXPECT_TRUE(parallelPixels == serialPixels);
+}
+
 /**
  * 用例描述: 同一个序列帧多图层引用且时间轴交错，测试解码器数量是否正确。
  */
@@ -151,4 +316,51 @@ PAG_TEST(PAGSequenceTest, Sequence_Multiple_References) {
   EXPECT_EQ(static_cast<int>(sequenceCaches.begin()->second.size()), 1);
 }
 
+/**
+ * 用例描述: 序列帧预解码窗口，测试预解码帧数、内存统计以及预解码帧内容是否正确。
+ */
+PAG_TEST(PAGSequenceTest, SequencePrefetchDepth) {
+  auto pagFile = LoadPAGFile("resources/apitest/wz_mvp.pag");
+  ASSERT_NE(pagFile, nullptr);
+  auto pagSurface = OffscreenSurface::Make(750, 1334);
+  auto pagPlayer = std::make_shared<PAGPlayer>();
+  pagPlayer->setSurface(pagSurface);
+  pagPlayer->setComposition(pagFile);
+  pagPlayer->setMatrix(Matrix::I());
+  pagPlayer->setSequencePrefetchDepth(3);
+  EXPECT_EQ(pagPlayer->sequencePrefetchDepth(), 3);
+  pagPlayer->setProgress(0.5);
+  pagPlayer->flush();
+  auto renderCache = pagPlayer->renderCache;
+  ASSERT_EQ(static_cast<int>(renderCache->sequenceCaches.size()), 1);
+  auto queue = renderCache->sequenceCaches.begin()->second.front();
+  EXPECT_EQ(queue->prefetchDepth(), 3);
+  ASSERT_NE(queue->prefetchTask, nullptr);
+  queue->prefetchTask->wait();
+  EXPECT_EQ(static_cast<int>(queue->prefetchedFrames.size()), 3);
+  EXPECT_EQ(queue->prefetchedFrames.front().frame, queue->currentFrame + 1);
+  EXPECT_GT(queue->memoryUsage(), 0u);
+  EXPECT_EQ(renderCache->memoryUsage(), renderCache->graphicsMemory + queue->memoryUsage());
+  // 每个预解码帧都持有独立的缓冲区，内容与逐帧解码的结果一致。
+  auto device = DevicePool::Make();
+  ASSERT_TRUE(device != nullptr);
+  auto context = device->lockContext();
+  ASSERT_TRUE(context != nullptr);
+  auto expectReader = queue->sequence->makeReader(pagFile->getFile());
+  ASSERT_NE(expectReader, nullptr);
+  for (auto& item : queue->prefetchedFrames) {
+    auto expectPixels = ReadBufferPixels(context, expectReader->readBuffer(item.frame));
+    ASSERT_FALSE(expectPixels.empty());
+    EXPECT_TRUE(ReadBufferPixels(context, item.buffer) == expectPixels);
+  }
+  device->unlock();
+  pagPlayer->nextFrame();
+  pagPlayer->flush();
+  EXPECT_EQ(queue->preparedFrame, queue->currentFrame + 1);
+  pagPlayer->setSequencePrefetchDepth(1);
+  EXPECT_EQ(queue->prefetchDepth(), 1);
+  queue->prefetchTask->wait();
+  EXPECT_LE(static_cast<int>(queue->prefetchedFrames.size()), 1);
+}
+
 }  // namespace pag
@@ -176,4 +176,66 @@ PAG_TEST(PAGSurfaceTest, BottomLeftScissor) {
   gl->deleteTextures(1, &textureInfo.id);
   device->unlock();
 }
+
+/**
+ * 用例描述: 开启局部重绘后，每帧只重绘脏区域，渲染结果与全量重绘一致。
+ */
+PAG_TEST(PAGSurfaceTest, PartialRedraw) {
+  auto fullPlayer = MakeOffscreenPlayer(LoadPAGFile("resources/apitest/test.pag"));
+  ASSERT_NE(fullPlayer, nullptr);
+  auto pagPlayer = MakeOffscreenPlayer(LoadPAGFile("resources/apitest/test.pag"));
+  ASSERT_NE(pagPlayer, nullptr);
+  pagPlayer->setPartialRedrawEnabled(true);
+  EXPECT_TRUE(pagPlayer->partialRedrawEnabled());
+  auto pagSurface = pagPlayer->getSurface();
+  auto width = pagSurface->width();
+  auto height = pagSurface->height();
+  auto surfaceBounds = Rect::MakeXYWH(0, 0, width, height);
+  auto totalFrames = fullPlayer->getComposition()->frameCount();
+  for (int frame = 0; frame < totalFrames; frame += 5) {
+    for (auto& player : {fullPlayer, pagPlayer}) {
+      player->setProgress(static_cast<double>(frame) / static_cast<double>(totalFrames));
+      ASSERT_TRUE(player->flush());
+    }
+    auto dirtyRect = pagPlayer->getDirtyRect();
+    if (frame == 0) {
+      EXPECT_EQ(dirtyRect, surfaceBounds);
+    }
+    EXPECT_TRUE(dirtyRect.left >= 0 && dirtyRect.top >= 0 && dirtyRect.right <= width &&
+                dirtyRect.bottom <= height);
+    EXPECT_TRUE(ComparePixels(fullPlayer->getSurface(), pagSurface)) << "frame: " << frame;
+  }
+  EXPECT_FALSE(pagPlayer->flush());
+  EXPECT_TRUE(pagPlayer->getDirtyRect().isEmpty());
+  pagPlayer->setPartialRedrawEnabled(false);
+  pagPlayer->nextFrame();
+  ASSERT_TRUE(pagPlayer->flush());
+  EXPECT_TRUE(pagSurface->lastGraphic == nullptr);
+}
+
+/**
+ * 用例描述: 局部刷新时，只有一小块区域变化的帧，脏区域严格小于整个 Surface
+ */
+PAG_TEST(PAGSurfaceTest, PartialRedrawSmallChange) {
+  auto composition = PAGComposition::Make(200, 200);
+  composition->addLayer(PAGSolidLayer::Make(1000000, 200, 200, Red));
+  auto smallLayer = PAGSolidLayer::Make(1000000, 10, 10, Blue);
+  composition->addLayer(smallLayer);
+  auto pagPlayer = std::make_shared<PAGPlayer>();
+  auto pagSurface = OffscreenSurface::Make(200, 200);
+  pagPlayer->setSurface(pagSurface);
+  pagPlayer->setComposition(composition);
+  pagPlayer->setPartialRedrawEnabled(true);
+  ASSERT_TRUE(pagPlayer->flush());
+  auto surfaceBounds = Rect::MakeXYWH(0, 0, 200, 200);
+  EXPECT_EQ(pagPlayer->getDirtyRect(), surfaceBounds);
+  smallLayer->setMatrix(Matrix::MakeTrans(50, 50));
+  ASSERT_TRUE(pagPlayer->flush());
+  auto dirtyRect = pagPlayer->getDirtyRect();
+  EXPECT_FALSE(dirtyRect.isEmpty());
+  EXPECT_LT(dirtyRect.width() * dirtyRect.height(), surfaceBounds.width() * surfaceBounds.height());
+  // The dirty rect covers both the old and the new position of the small layer.
+  EXPECT_TRUE(dirtyRect.left <= 0 && dirtyRect.top <= 0 && dirtyRect.right >= 60 &&
+              dirtyRect.bottom >= 60);
+}
 }  // namespace pag
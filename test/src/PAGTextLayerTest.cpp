@@ -22,7 +22,10 @@
 #include "base/utils/Log.h"
 #include "nlohmann/json.hpp"
 #include "pag/file.h"
+#include "rendering/caches/TextAtlas.h"
+#include "rendering/graphics/Glyph.h"
 #include "rendering/renderers/TextRenderer.h"
+#include "utils/DevicePool.h"
 #include "utils/TestUtils.h"
 
 namespace pag {
@@ -539,4 +542,116 @@ PAG_TEST(PAGTextLayerTest, TextLayerScaleAnimationWithMipmap) {
   EXPECT_TRUE(
       Baseline::Compare(TestPAGSurface, "PAGTextLayerTest/TextLayerScaleAnimationWithMipmap"));
 }
+/**
+ * 用例描述: Glyph 拷贝时共享只读的排版数据，只拷贝可写属性
+ */
+PAG_TEST(PAGTextLayerTest, GlyphCopySharesData) {
+  auto typeface =
+      tgfx::Typeface::MakeFromPath(ProjectPath::Absolute("resources/font/NotoSerifSC-Regular.otf"));
+  ASSERT_TRUE(typeface != nullptr);
+  tgfx::Font font(typeface, 30);
+  auto glyphs = Glyph::BuildFromText("PAG", font, {}, true);
+  ASSERT_EQ(glyphs.size(), 3u);
+  auto glyph = glyphs[0];
+  Glyph copy = *glyph;
+  EXPECT_EQ(copy.data, glyph->data);
+  EXPECT_EQ(copy.info, glyph->info);
+  copy.setAlpha(0.5f);
+  copy.setMatrix(tgfx::Matrix::MakeTrans(10, 0));
+  EXPECT_EQ(glyph->getAlpha(), 1.0f);
+  EXPECT_TRUE(glyph->getMatrix().isIdentity());
+  auto horizontalGlyph = glyph->makeHorizontalGlyph();
+  EXPECT_FALSE(horizontalGlyph->isVertical());
+  EXPECT_EQ(horizontalGlyph->data, glyph->data);
+  EXPECT_EQ(horizontalGlyph->getBounds(), glyph->getOriginBounds());
+  EXPECT_EQ(glyph->getName(), "P");
+}
+
+/**
+ * 用例描述: 文本动画选择器批量计算的范围因子与逐个字符计算的结果一致
+ */
+PAG_TEST(PAGTextLayerTest, TextSelectorBatchFactors) {
+  for (auto& path : {"assets/TextAnimators.pag", "assets/TextAnimatorMode.pag",
+                     "assets/TextAnimatorX7.pag", "assets/TextAnimatorSmooth.pag"}) {
+    auto pagFile = LoadPAGFile(path);
+    ASSERT_NE(pagFile, nullptr);
+    auto file = pagFile->getFile();
+    for (int i = 0; i < file->numTexts(); i++) {
+      auto text = file->getTextAt(i);
+      auto textCount = text->getTextDocument()->text.size();
+      for (Frame frame = 0; frame < file->duration(); frame += 5) {
+        for (auto animator : text->animators) {
+          TextAnimatorRenderer renderer(animator, ParagraphJustification::LeftJustify, textCount,
+                                        frame);
+          auto factors = TextSelectorRenderer::CalculateFactorsFromSelectors(
+              renderer.selectorRenderers, textCount);
+          ASSERT_EQ(factors.size(), textCount);
+          for (size_t index = 0; index < textCount; index++) {
+            auto factor = TextSelectorRenderer::CalculateFactorFromSelectors(
+                renderer.selectorRenderers, index);
+            EXPECT_EQ(factors[index], factor) << path << " frame: " << frame << " index: " << index;
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * 用例描述: 相同字体的文本共享字形图集，新增字形原地绘制到已有分页，不再引用的分页会被整页回收
+ */
+PAG_TEST(PAGTextLayerTest, SharedGlyphAtlas) {
+  auto typeface =
+      tgfx::Typeface::MakeFromPath(ProjectPath::Absolute("resources/font/NotoSerifSC-Regular.otf"));
+  ASSERT_TRUE(typeface != nullptr);
+  tgfx::Font font(typeface, 30);
+  auto firstGlyphs = Glyph::BuildFromText("PAG", font, {});
+  auto secondGlyphs = Glyph::BuildFromText("PAGX", font, {});
+  auto firstBlock =
+      std::make_shared<TextBlock>(1, std::vector<std::vector<GlyphHandle>>{firstGlyphs}, 1.0f);
+  auto secondBlock =
+      std::make_shared<TextBlock>(2, std::vector<std::vector<GlyphHandle>>{secondGlyphs}, 1.0f);
+  auto device = DevicePool::Make();
+  ASSERT_TRUE(device != nullptr);
+  auto context = device->lockContext();
+  ASSERT_TRUE(context != nullptr);
+  GlyphAtlas maskAtlas(true);
+  GlyphAtlas colorAtlas(false);
+  auto firstAtlas = TextAtlas::Make(firstBlock.get(), context, &maskAtlas, &colorAtlas, 1.0f);
+  ASSERT_TRUE(firstAtlas != nullptr);
+  EXPECT_EQ(maskAtlas.pageCount(), 1u);
+  EXPECT_EQ(maskAtlas.glyphLocators.size(), 3u);
+  auto firstImage = firstAtlas->getAtlasImage(0);
+  ASSERT_TRUE(firstImage != nullptr);
+
+  auto secondAtlas = TextAtlas::Make(secondBlock.get(), context, &maskAtlas, &colorAtlas, 1.0f);
+  ASSERT_TRUE(secondAtlas != nullptr);
+  EXPECT_EQ(maskAtlas.pageCount(), 1u);
+  EXPECT_EQ(maskAtlas.glyphLocators.size(), 4u);
+  EXPECT_EQ(colorAtlas.pageCount(), 0u);
+  EXPECT_EQ(firstAtlas->getAtlasImage(0), secondAtlas->getAtlasImage(0));
+  // The new glyph is drawn into the existing texture of the page, which keeps its size.
+  EXPECT_EQ(firstAtlas->getAtlasImage(0), firstImage);
+  EXPECT_EQ(firstImage->width(), secondAtlas->getAtlasImage(0)->width());
+  EXPECT_EQ(firstImage->width(), std::min(context->caps()->maxTextureSize, 1024));
+  tgfx::BytesKey bytesKey;
+  firstGlyphs[0]->computeAtlasKey(&bytesKey, firstGlyphs[0]->getStyle());
+  AtlasLocator firstLocator;
+  AtlasLocator secondLocator;
+  ASSERT_TRUE(firstAtlas->getLocator(bytesKey, &firstLocator));
+  ASSERT_TRUE(secondAtlas->getLocator(bytesKey, &secondLocator));
+  EXPECT_EQ(firstLocator.location, secondLocator.location);
+
+  EXPECT_EQ(maskAtlas.purgeExpiredPages(0), 0u);
+  firstAtlas = nullptr;
+  EXPECT_EQ(maskAtlas.purgeExpiredPages(0), 0u);
+  secondAtlas = nullptr;
+  EXPECT_EQ(maskAtlas.purgeExpiredPages(1), 0u);
+  EXPECT_GT(maskAtlas.purgeExpiredPages(1), 0u);
+  EXPECT_EQ(maskAtlas.pageCount(), 0u);
+  EXPECT_TRUE(maskAtlas.glyphLocators.empty());
+  EXPECT_EQ(maskAtlas.memoryUsage(), 0u);
+  device->unlock();
+}
+
 }  // namespace pag
@@ -108,6 +108,28 @@ std::shared_ptr<PAGFile> LoadPAGFile(const std::string& path) {
   return PAGFile::Load(ProjectPath::Absolute(path));
 }
 
+std::shared_ptr<PAGPlayer> MakeOffscreenPlayer(std::shared_ptr<PAGComposition> composition) {
+  if (composition == nullptr) {
+    return nullptr;
+  }
+  auto pagPlayer = std::make_shared<PAGPlayer>();
+  pagPlayer->setSurface(OffscreenSurface::Make(composition->width(), composition->height()));
+  pagPlayer->setComposition(composition);
+  return pagPlayer;
+}
+
+bool ComparePixels(std::shared_ptr<PAGSurface> surface, std::shared_ptr<PAGSurface> other) {
+  auto bitmap = MakeSnapshot(surface);
+  auto otherBitmap = MakeSnapshot(other);
+  if (bitmap.isEmpty() || otherBitmap.isEmpty()) {
+    return false;
+  }
+  Pixmap pixmap(bitmap);
+  Pixmap otherPixmap(otherBitmap);
+  return pixmap.info() == otherPixmap.info() &&
+         memcmp(pixmap.pixels(), otherPixmap.pixels(), pixmap.byteSize()) == 0;
+}
+
 std::shared_ptr<tgfx::ImageCodec> MakeImageCodec(const std::string& path) {
   return ImageCodec::MakeFrom(ProjectPath::Absolute(path));
 }
@@ -47,6 +47,17 @@ bool CreateGLTexture(tgfx::Context* context, int width, int height, tgfx::GLText
 
 std::shared_ptr<PAGFile> LoadPAGFile(const std::string& path);
 
+/**
+ * Creates a PAGPlayer that renders the specified composition into an offscreen surface of the same
+ * size. Returns nullptr if the composition is nullptr.
+ */
+std::shared_ptr<PAGPlayer> MakeOffscreenPlayer(std::shared_ptr<PAGComposition> composition);
+
+/**
+ * Returns true if the two PAGSurfaces hold exactly the same pixels.
+ */
+bool ComparePixels(std::shared_ptr<PAGSurface> surface, std::shared_ptr<PAGSurface> other);
+
 std::shared_ptr<tgfx::ImageCodec> MakeImageCodec(const std::string& path);
 
 std::shared_ptr<tgfx::Image> MakeImage(const std::string& path);